@@ -12,153 +12,877 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <sys/mman.h>
+#include <algorithm>
+#include <cstring>
+#include <future>  // NOLINT
+#include <limits>
+#include <new>
+#include <thread>  // NOLINT
+#include <utility>
+
 #include "common/exception.h"
 #include "common/macros.h"
 
 namespace bustub {
 
+namespace {
+
+/**
+ * Reserve zeroed, page-aligned memory for the data of the frames. Memory is only used once touched. Arenas of at least
+ * a huge page are aligned to huge pages and asked to be backed by them, which saves most TLB misses on large pools.
+ */
+auto MapFrameArena(size_t size) -> char * {
+  const bool huge = BUFFER_POOL_HUGE_PAGES && size >= static_cast<size_t>(HUGE_PAGE_SIZE);
+  const size_t reserved = huge ? size + HUGE_PAGE_SIZE : size;
+  void *memory = mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (memory == MAP_FAILED) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "can't reserve memory for the buffer pool");
+  }
+  if (!huge) {
+    return static_cast<char *>(memory);
+  }
+  // Give back what is left on either side of the aligned arena.
+  auto *start = static_cast<char *>(memory);
+  auto offset = reinterpret_cast<uintptr_t>(start) % HUGE_PAGE_SIZE;
+  char *arena = offset == 0 ? start : start + (HUGE_PAGE_SIZE - offset);
+  if (arena != start) {
+    munmap(start, static_cast<size_t>(arena - start));
+  }
+  if (arena + size != start + reserved) {
+    munmap(arena + size, static_cast<size_t>(start + reserved - (arena + size)));
+  }
+  // Only a hint: without transparent huge pages the arena is simply backed by small pages.
+  madvise(arena, size, MADV_HUGEPAGE);
+  return arena;
+}
+
+}  // namespace
+
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
-                                                     LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
-  // we allocate a consecutive memory space for the buffer pool
-  pages_ = new Page[pool_size_];
-  page_table_ = new ExtendibleHashTable<page_id_t, frame_id_t>(bucket_size_);
-  replacer_ = new LRUKReplacer(pool_size, replacer_k);
+                                                     LogManager *log_manager, size_t max_pool_size,
+                                                     ReplacerType replacer_type)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, replacer_k, log_manager, max_pool_size, replacer_type) {
+}
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances,
+                                                     uint32_t instance_index, DiskManager *disk_manager,
+                                                     size_t replacer_k, LogManager *log_manager, size_t max_pool_size,
+                                                     ReplacerType replacer_type)
+    : pool_size_(pool_size),
+      max_pool_size_(std::max(pool_size, max_pool_size)),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager) {
+  BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
+  BUSTUB_ASSERT(
+      instance_index < num_instances,
+      "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 0.");
+  // New pages go after the ones already in the database file, starting at the first id this instance owns.
+  const auto num_pages = disk_manager_->GetNumPages();
+  const auto modulus = static_cast<page_id_t>(num_instances_);
+  next_page_id_ = num_pages + ((static_cast<page_id_t>(instance_index_) - num_pages % modulus) + modulus) % modulus;
 
-  // Initially, every page is in the free list.
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
+  // We reserve a consecutive memory space for the data of all the frames the pool can grow to, apart from their
+  // metadata: the data is only backed once touched, so the frames past pool_size_ cost address space only.
+  frame_data_ = MapFrameArena(max_pool_size_ * BUSTUB_PAGE_SIZE);
+  pages_ = static_cast<Page *>(::operator new(max_pool_size_ * sizeof(Page), std::align_val_t{alignof(Page)}));
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    new (pages_ + i) Page(frame_data_ + i * BUSTUB_PAGE_SIZE);
   }
+  page_table_ = new PageTable(max_pool_size_);
+  if (replacer_type == ReplacerType::CLOCK) {
+    replacer_ = new ConcurrentClockReplacer(max_pool_size_);
+  } else {
+    replacer_ = new LRUKReplacer(max_pool_size_, replacer_k);
+  }
+  frame_io_ = std::make_unique<std::atomic<FrameIOState>[]>(max_pool_size_);
+  frame_io_cv_ = std::make_unique<std::condition_variable[]>(max_pool_size_);
+
+  read_ahead_ = std::make_unique<ReadAheadWorker>(
+      [this](page_id_t page_id, next_page_fn next_page, BufferAccessStrategy *strategy) {
+        return PrefetchPage(page_id, next_page, strategy);
+      });
 
-  // TODO(students): remove this line after you have implemented the buffer pool manager
+  // Initially, every page is in the free list, and the frames the pool may grow into are retired.
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    frame_io_[i] = FrameIOState::NONE;
+    if (i < pool_size_) {
+      free_list_.emplace_back(static_cast<int>(i));
+    } else {
+      pages_[i].pin_count_ = -1;
+    }
+  }
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  read_ahead_.reset();
+  StopBackgroundFlusher();
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    pages_[i].~Page();
+  }
+  ::operator delete(pages_, std::align_val_t{alignof(Page)});
+  munmap(frame_data_, max_pool_size_ * BUSTUB_PAGE_SIZE);
   delete page_table_;
   delete replacer_;
 }
 
 auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
-  std::scoped_lock<std::mutex> lock(latch_);
-  return ReallocatePage(page_id);
+  Page *page = TryNewPage(page_id);
+  if (page == nullptr) {
+    stats_.Add(BufferPoolCounter::PIN_FAILURE);
+  }
+  return page;
 }
 
-auto BufferPoolManagerInstance::ReallocatePage(page_id_t *page_id, bool has_id) -> Page * {
+auto BufferPoolManagerInstance::TryNewPage(page_id_t *page_id) -> Page * {
+  // Taking a deallocated page writes the free space map, which must not happen with the latch held.
+  page_id_t reused = disk_manager_->ReuseFreePage(static_cast<page_id_t>(instance_index_),
+                                                  static_cast<page_id_t>(num_instances_));
+  std::unique_lock<std::mutex> lock(latch_);
   frame_id_t frame;
-  {
-    if (free_list_.empty()) {
-      bool flag = replacer_->Evict(&frame);
-      if (!flag) {
-        return nullptr;
-      }
-      page_table_->Remove(pages_[frame].GetPageId());
-      if (pages_[frame].IsDirty()) {
-        disk_manager_->WritePage(pages_[frame].GetPageId(), pages_[frame].GetData());
-      }
-    } else {
-      frame = *(free_list_.begin());
-      free_list_.pop_front();
+  if (!AcquireFrame(&frame)) {
+    if (reused != INVALID_PAGE_ID) {
+      disk_manager_->ReturnFreePage(reused, static_cast<page_id_t>(num_instances_));
     }
+    return nullptr;
   }
-  if (!has_id) {
-    *page_id = AllocatePage();
+  *page_id = AllocatePage(reused, frame);
+  TraceAccess(*page_id, PageAccessType::PIN, true);
+  return InstallPage(&lock, *page_id, frame, false);
+}
+
+auto BufferPoolManagerInstance::AcquireFrame(frame_id_t *frame_id) -> bool {
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    // A lock-free fetcher that followed a stale page table entry may hold the frame for a moment.
+    while (!ClaimFrame(*frame_id)) {
+      std::this_thread::yield();
+    }
+    return true;
   }
-  ResetPage(*page_id, frame);
-  page_table_->Insert(*page_id, frame);
-  replacer_->RecordAccess(frame);
-  replacer_->SetEvictable(frame, false);
-  return pages_ + frame;
+
+  std::vector<frame_id_t> pinned;
+  bool found = false;
+  while (replacer_->Evict(frame_id)) {
+    if (ClaimFrame(*frame_id)) {
+      found = true;
+      // Every eviction eats into the clean frames, let the flusher check whether it should top them up.
+      WakeBackgroundFlusher();
+      break;
+    }
+    pinned.push_back(*frame_id);
+  }
+  // These victims were pinned without the latch after the replacer had picked them. Track them again; whoever holds
+  // the last pin marks them evictable when it goes away, unless that already happened.
+  for (frame_id_t frame : pinned) {
+    replacer_->RecordAccess(frame);
+    if (pages_[frame].pin_count_ == 0) {
+      replacer_->SetEvictable(frame, true);
+    }
+  }
+  return found;
+}
+
+auto BufferPoolManagerInstance::AcquireRingFrame(page_id_t page_id, BufferAccessStrategy *strategy,
+                                                 frame_id_t *frame_id) -> bool {
+  const size_t capacity = std::max<size_t>(1, std::min(strategy->GetRingSize() / num_instances_, pool_size_ / 4));
+  page_id_t victim = strategy->NextVictim(instance_index_, capacity);
+  frame_id_t frame;
+  // The page the scan loaded a ring ago may have been evicted, picked up by somebody else or modified since.
+  if (victim != INVALID_PAGE_ID && page_table_->Find(victim, &frame) && !pages_[frame].is_dirty_ &&
+      frame_io_[frame] == FrameIOState::NONE && ClaimFrame(frame)) {
+    // The last unpinner may not have marked the frame evictable yet.
+    replacer_->SetEvictable(frame, true);
+    replacer_->Remove(frame);
+    *frame_id = frame;
+  } else if (!AcquireFrame(frame_id)) {
+    return false;
+  }
+  strategy->FillSlot(instance_index_, capacity, page_id);
+  return true;
+}
+
+auto BufferPoolManagerInstance::AdmitPage(page_id_t page_id) -> bool {
+  frame_id_t victim;
+  if (!free_list_.empty() || !replacer_->PeekVictim(&victim)) {
+    return true;
+  }
+  // Ties go to the victim: a page seen as often as the one it would replace is not worth the miss it causes.
+  return frequency_sketch_->Estimate(page_id) > frequency_sketch_->Estimate(pages_[victim].page_id_);
+}
+
+auto BufferPoolManagerInstance::ClaimFrame(frame_id_t frame_id) -> bool {
+  int unpinned = 0;
+  return pages_[frame_id].pin_count_.compare_exchange_strong(unpinned, -1);
+}
+
+auto BufferPoolManagerInstance::TryPin(page_id_t page_id, frame_id_t frame_id) -> bool {
+  Page *page = pages_ + frame_id;
+  int pin_count = page->pin_count_;
+  do {
+    if (pin_count < 0) {
+      return false;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+  // The page id of a frame only changes while it is claimed, so it is stable now that we hold a pin.
+  if (page->page_id_ != page_id) {
+    UnpinFrame(frame_id, false);
+    return false;
+  }
+  return true;
+}
+
+auto BufferPoolManagerInstance::UnpinFrame(frame_id_t frame_id, bool is_dirty) -> bool {
+  Page *page = pages_ + frame_id;
+  int pin_count = page->pin_count_;
+  if (pin_count <= 0) {
+    return false;
+  }
+  // The dirty flag must be set while we still hold the pin, or the frame could be recycled without a write-back.
+  if (is_dirty) {
+    page->is_dirty_ = true;
+  }
+  do {
+    if (pin_count <= 0) {
+      return false;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+  if (pin_count == 1) {
+    replacer_->SetEvictable(frame_id, true);
+  }
+  return true;
+}
+
+auto BufferPoolManagerInstance::InstallPage(std::unique_lock<std::mutex> *lock, page_id_t page_id, frame_id_t frame_id,
+                                            bool load) -> Page * {
+  Page *page = pages_ + frame_id;
+  const page_id_t old_page_id = page->page_id_;
+  const bool write_back = old_page_id != INVALID_PAGE_ID && page->is_dirty_;
+  // Optimistic readers of the old page must not validate once the frame holds something else.
+  page->rwlatch_.Invalidate();
+  if (old_page_id != INVALID_PAGE_ID) {
+    page_table_->Remove(old_page_id);
+    stats_.Add(BufferPoolCounter::EVICTION);
+  }
+  if (write_back) {
+    stats_.Add(BufferPoolCounter::DIRTY_WRITE_BACK);
+    writing_back_[old_page_id] = frame_id;
+    frame_io_[frame_id] = FrameIOState::WRITING_BACK;
+  } else if (load) {
+    frame_io_[frame_id] = FrameIOState::LOADING;
+  } else {
+    page->ResetMemory();
+  }
+
+  // Publish the new mapping before touching the disk, so that concurrent fetchers of page_id find the frame and wait
+  // for it instead of loading a second copy. Storing the pin count ends the claim and lets lock-free fetchers in, so
+  // it comes last.
+  page->page_id_ = page_id;
+  page->is_dirty_ = false;
+  page_table_->Insert(page_id, frame_id);
+  replacer_->RecordAccess(frame_id);
+  replacer_->SetEvictable(frame_id, false);
+  page->pin_count_ = 1;
+
+  if (!write_back && !load) {
+    return page;
+  }
+
+  if (write_back && load) {
+    // Write the victim back from a copy, so that the new page can be read into the frame at the same time.
+    std::unique_ptr<char[]> victim(new char[BUSTUB_PAGE_SIZE]);
+    std::memcpy(victim.get(), page->GetData(), BUSTUB_PAGE_SIZE);
+    lock->unlock();
+    std::vector<DiskRequest> requests;
+    requests.push_back(DiskRequest{true, victim.get(), old_page_id, {}});
+    requests.push_back(DiskRequest{false, page->GetData(), page_id, {}});
+    std::future<bool> written = requests[0].callback_.get_future();
+    std::future<bool> loaded = requests[1].callback_.get_future();
+    disk_manager_->Schedule(&requests);
+    written.wait();
+    lock->lock();
+    writing_back_.erase(old_page_id);
+    SetFrameIO(frame_id, FrameIOState::LOADING);
+    lock->unlock();
+    loaded.wait();
+    lock->lock();
+    SetFrameIO(frame_id, FrameIOState::NONE);
+    return page;
+  }
+
+  if (write_back) {
+    lock->unlock();
+    disk_manager_->WritePage(old_page_id, page->GetData());
+    lock->lock();
+    writing_back_.erase(old_page_id);
+    if (!load) {
+      page->ResetMemory();
+    }
+  }
+
+  if (load) {
+    SetFrameIO(frame_id, FrameIOState::LOADING);
+    lock->unlock();
+    disk_manager_->ReadPage(page_id, page->GetData());
+    lock->lock();
+  }
+  SetFrameIO(frame_id, FrameIOState::NONE);
+  return page;
+}
+
+void BufferPoolManagerInstance::WaitForIO(std::unique_lock<std::mutex> *lock, frame_id_t frame_id) {
+  frame_io_cv_[frame_id].wait(*lock, [&] { return frame_io_[frame_id] == FrameIOState::NONE; });
 }
 
-void BufferPoolManagerInstance::ResetPage(page_id_t page, frame_id_t frame) {
-  pages_[frame].page_id_ = page;
-  pages_[frame].ResetMemory();
-  pages_[frame].pin_count_ = 1;
-  pages_[frame].is_dirty_ = false;
+void BufferPoolManagerInstance::SetFrameIO(frame_id_t frame_id, FrameIOState state) {
+  frame_io_[frame_id] = state;
+  frame_io_cv_[frame_id].notify_all();
 }
 
 auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
-  std::scoped_lock<std::mutex> lock(latch_);
+  return FetchPgStrategyImp(page_id, nullptr);
+}
+
+auto BufferPoolManagerInstance::FetchPgStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  ValidatePageId(page_id);
+  const auto start = std::chrono::steady_clock::now();
+  stats_.Add(BufferPoolCounter::FETCH);
+  if (frequency_sketch_ != nullptr) {
+    frequency_sketch_->Increment(page_id);
+  }
+  bool use_ring = strategy != nullptr && strategy->CountFetch(page_id);
+  bool hit;
+  Page *page = PinPage(page_id, use_ring ? strategy : nullptr, &hit);
+  if (page == nullptr) {
+    stats_.Add(BufferPoolCounter::PIN_FAILURE);
+    return nullptr;
+  }
+  RecordFetch(hit ? BufferPoolLatency::HIT : BufferPoolLatency::MISS, start);
+  TraceAccess(page_id, PageAccessType::PIN, false);
+  return page;
+}
+
+auto BufferPoolManagerInstance::PinPage(page_id_t page_id, BufferAccessStrategy *ring, bool *hit) -> Page * {
   frame_id_t frame;
-  if (page_table_->Find(page_id, frame)) {
+  *hit = true;
+  // Fast path: a resident page is pinned without taking the latch.
+  if (page_table_->Find(page_id, &frame) && TryPin(page_id, frame)) {
     replacer_->RecordAccess(frame);
     replacer_->SetEvictable(frame, false);
-    pages_[frame].pin_count_++;
+    if (frame_io_[frame] != FrameIOState::NONE) {
+      std::unique_lock<std::mutex> lock(latch_);
+      WaitForIO(&lock, frame);
+    }
     return pages_ + frame;
   }
-  Page *page_ptr = nullptr;
-  page_ptr = ReallocatePage(&page_id, true);
-  if (page_ptr != nullptr) {
-    frame = page_ptr - pages_;
-    ResetPage(page_id, frame);
-    disk_manager_->ReadPage(page_id, page_ptr->GetData());
+
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    if (page_table_->Find(page_id, &frame)) {
+      // Frames are only ever claimed with the latch held, so the pin count cannot be negative here. Pin before
+      // waiting so that the frame cannot be recycled under us while the load finishes.
+      pages_[frame].pin_count_++;
+      replacer_->RecordAccess(frame);
+      replacer_->SetEvictable(frame, false);
+      WaitForIO(&lock, frame);
+      return pages_ + frame;
+    }
+    auto writer = writing_back_.find(page_id);
+    if (writer == writing_back_.end()) {
+      break;
+    }
+    // The page was just evicted and its latest content is still on its way to disk.
+    frame_id_t writer_frame = writer->second;
+    frame_io_cv_[writer_frame].wait(lock, [&] { return writing_back_.count(page_id) == 0; });
+  }
+
+  *hit = false;
+  if (ring == nullptr && frequency_sketch_ != nullptr && !AdmitPage(page_id)) {
+    stats_.Add(BufferPoolCounter::ADMISSION_REJECTION);
+    ring = admission_window_.get();
+  }
+  if (!(ring != nullptr ? AcquireRingFrame(page_id, ring, &frame) : AcquireFrame(&frame))) {
+    return nullptr;
   }
-  return page_ptr;
+  return InstallPage(&lock, page_id, frame, true);
 }
 
-auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
+auto BufferPoolManagerInstance::FetchPageOptimistic(page_id_t page_id, uint64_t *version) -> Page * {
   frame_id_t frame;
-  bool flag = page_table_->Find(page_id, frame);
-  if (!flag) {
-    return false;
+  if (!page_table_->Find(page_id, &frame)) {
+    return nullptr;
   }
-  if (pages_[frame].GetPinCount() == 0) {
-    return false;
+  // The version is read first: a frame that is recycled after this point fails the validation of the caller. Any
+  // change that happened before is visible in the checks below.
+  Page *page = pages_ + frame;
+  if (!page->TryOptimisticRead(version) || page->page_id_ != page_id || frame_io_[frame] != FrameIOState::NONE) {
+    return nullptr;
   }
-  if (pages_[frame].GetPinCount() == 1) {
-    replacer_->SetEvictable(frame, true);
+  return page;
+}
+
+void BufferPoolManagerInstance::RecordFetch(BufferPoolLatency kind, std::chrono::steady_clock::time_point start) {
+  stats_.Add(kind == BufferPoolLatency::HIT ? BufferPoolCounter::HIT : BufferPoolCounter::MISS);
+  stats_.RecordLatency(kind, std::chrono::steady_clock::now() - start);
+}
+
+auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  frame_id_t frame;
+  bool unpinned;
+  if (page_table_->Find(page_id, &frame) && pages_[frame].page_id_ == page_id) {
+    unpinned = UnpinFrame(frame, is_dirty);
+  } else {
+    // The lock-free lookup can miss while the page table is being rebuilt, so only the latched one is conclusive.
+    std::scoped_lock<std::mutex> lock(latch_);
+    unpinned = page_table_->Find(page_id, &frame) && UnpinFrame(frame, is_dirty);
   }
-  if (!pages_[frame].is_dirty_) {
-    pages_[frame].is_dirty_ = is_dirty;
+  if (unpinned) {
+    TraceAccess(page_id, PageAccessType::UNPIN, is_dirty);
+  }
+  return unpinned;
+}
+
+void BufferPoolManagerInstance::TraceAccess(page_id_t page_id, PageAccessType type, bool is_dirty) {
+  PageAccessTraceWriter *trace = access_trace_;
+  if (trace != nullptr) {
+    trace->Record(page_id, type, is_dirty);
   }
-  pages_[frame].pin_count_--;
-  return true;
 }
 
 auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
+  std::unique_lock<std::mutex> lock(latch_);
   frame_id_t frame;
-  bool flag = page_table_->Find(page_id, frame);
+  bool flag = page_table_->Find(page_id, &frame);
   if (!flag) {
     return false;
   }
-  disk_manager_->WritePage(pages_[frame].GetPageId(), pages_[frame].GetData());
-  pages_[frame].is_dirty_ = false;
+  // Hold a pin across the write so the frame stays put while the latch is released.
+  Page *page = pages_ + frame;
+  page->pin_count_++;
+  replacer_->SetEvictable(frame, false);
+  WaitForIO(&lock, frame);
+  page->is_dirty_ = false;
+  lock.unlock();
+
+  disk_manager_->WritePage(page_id, page->GetData());
+  UnpinFrame(frame, false);
   return true;
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
-  std::scoped_lock<std::mutex> lock(latch_);
-  frame_id_t frame;
-  for (size_t i = 0; i < pool_size_; i++) {
-    bool flag = page_table_->Find(pages_[i].GetPageId(), frame);
-    if (flag && i == static_cast<size_t>(frame)) {
-      disk_manager_->WritePage(pages_[i].GetPageId(), pages_[i].GetData());
-      pages_[i].is_dirty_ = false;
+  FlushDirtyPages();
+  // Page writes are not durable by themselves, flushing the whole pool is where callers expect them to be.
+  disk_manager_->Sync();
+}
+
+void BufferPoolManagerInstance::FlushDirtyPages() {
+  // Pin the dirty pages and write them out without the latch, so that the pool keeps serving requests meanwhile.
+  std::vector<std::pair<page_id_t, frame_id_t>> dirty;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (size_t i = 0; i < pool_size_; i++) {
+      Page *page = pages_ + i;
+      // Frames with I/O in flight are either being loaded (and therefore clean) or written back by someone else.
+      if (page->page_id_ == INVALID_PAGE_ID || !page->is_dirty_ || frame_io_[i] != FrameIOState::NONE) {
+        continue;
+      }
+      page->pin_count_++;
+      replacer_->SetEvictable(static_cast<frame_id_t>(i), false);
+      dirty.emplace_back(page->page_id_, static_cast<frame_id_t>(i));
+    }
+  }
+
+  // Write in page id order and merge adjacent pages into a single vectored write.
+  std::sort(dirty.begin(), dirty.end());
+  std::vector<const char *> run;
+  size_t begin = 0;
+  while (begin < dirty.size()) {
+    // Only the latch of the first page of a run may be waited for. Blocking on a latch while holding others could
+    // deadlock with a thread that latches the same pages in another order, so the run ends at the first page whose
+    // latch is taken.
+    size_t end = begin;
+    do {
+      Page *page = pages_ + dirty[end].second;
+      if (end == begin) {
+        page->RLatch();
+      } else if (!page->TryRLatch()) {
+        break;
+      }
+      // Clear the dirty flag before writing: a writer that comes in later marks the page dirty again when it unpins.
+      page->is_dirty_ = false;
+      run.push_back(page->GetData());
+      end++;
+    } while (end < dirty.size() && end - begin < FLUSH_RUN_PAGES && dirty[end].first == dirty[end - 1].first + 1);
+
+    disk_manager_->WritePages(dirty[begin].first, run);
+    for (size_t i = begin; i < end; i++) {
+      pages_[dirty[i].second].RUnlatch();
+      UnpinFrame(dirty[i].second, false);
     }
+    run.clear();
+    begin = end;
   }
 }
 
 auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
+  std::unique_lock<std::mutex> lock(latch_);
   frame_id_t frame;
-  bool flag = page_table_->Find(page_id, frame);
+  bool flag = page_table_->Find(page_id, &frame);
   if (!flag) {
+    // Let a write-back in flight land first, or it could overwrite the page after it has been handed out again.
+    auto writer = writing_back_.find(page_id);
+    if (writer != writing_back_.end()) {
+      frame_id_t writer_frame = writer->second;
+      frame_io_cv_[writer_frame].wait(lock, [&] { return writing_back_.count(page_id) == 0; });
+      if (page_table_->Find(page_id, &frame)) {
+        // Fetched again in the meantime.
+        return false;
+      }
+    }
+    DeallocatePage(page_id);
     return true;
   }
-  if (pages_[frame].GetPinCount() != 0) {
+  if (!ClaimFrame(frame)) {
     return false;
   }
-  replacer_->Remove(frame);
-  page_table_->Remove(page_id);
-  { free_list_.push_back(frame); }
-  // ResetPage(page_id, frame);
+  DiscardFrame(frame);
   DeallocatePage(page_id);
   return true;
 }
 
-auto BufferPoolManagerInstance::AllocatePage() -> page_id_t { return next_page_id_++; }
+void BufferPoolManagerInstance::DiscardFrame(frame_id_t frame_id) {
+  Page *page = pages_ + frame_id;
+  // The last unpinner may not have marked the frame evictable yet.
+  replacer_->SetEvictable(frame_id, true);
+  replacer_->Remove(frame_id);
+  page_table_->Remove(page->page_id_);
+  page->rwlatch_.Invalidate();
+  // The frame goes back to the free list empty, so that its stale content is never written back.
+  page->page_id_ = INVALID_PAGE_ID;
+  page->is_dirty_ = false;
+  page->pin_count_ = 0;
+  free_list_.push_back(frame_id);
+}
+
+auto BufferPoolManagerInstance::Resize(size_t pool_size) -> bool {
+  if (pool_size == 0 || pool_size > max_pool_size_) {
+    return false;
+  }
+  std::scoped_lock<std::mutex> lock(latch_);
+  const size_t old_pool_size = pool_size_;
+  if (pool_size >= old_pool_size) {
+    // The new frames are zeroed: either they were never touched, or their memory was dropped when they were retired.
+    for (size_t i = old_pool_size; i < pool_size; i++) {
+      pages_[i].pin_count_ = 0;
+      free_list_.emplace_back(static_cast<frame_id_t>(i));
+    }
+    pool_size_ = pool_size;
+    return true;
+  }
+
+  // Claim every frame to retire, so that nobody can pin them any more, or give up if one of them is in use.
+  std::vector<frame_id_t> claimed;
+  for (size_t i = pool_size; i < old_pool_size; i++) {
+    auto frame = static_cast<frame_id_t>(i);
+    if (frame_io_[frame] != FrameIOState::NONE || !ClaimFrame(frame)) {
+      for (frame_id_t claimed_frame : claimed) {
+        pages_[claimed_frame].pin_count_ = 0;
+      }
+      return false;
+    }
+    claimed.push_back(frame);
+  }
+
+  // Write the dirty pages back before they leave the page table, so that a fetch that comes in right after does not
+  // read stale data. Resizing is rare, so the latch is simply held across the writes.
+  std::vector<DiskRequest> requests;
+  for (frame_id_t frame : claimed) {
+    Page *page = pages_ + frame;
+    if (page->page_id_ != INVALID_PAGE_ID && page->is_dirty_) {
+      requests.push_back(DiskRequest{true, page->GetData(), page->page_id_, {}});
+      stats_.Add(BufferPoolCounter::DIRTY_WRITE_BACK);
+    }
+  }
+  std::vector<std::future<bool>> written;
+  for (auto &request : requests) {
+    written.push_back(request.callback_.get_future());
+  }
+  disk_manager_->Schedule(&requests);
+  for (auto &future : written) {
+    future.wait();
+  }
+
+  for (frame_id_t frame : claimed) {
+    Page *page = pages_ + frame;
+    page->rwlatch_.Invalidate();
+    if (page->page_id_ != INVALID_PAGE_ID) {
+      page_table_->Remove(page->page_id_);
+      // The last unpinner may not have marked the frame evictable yet.
+      replacer_->SetEvictable(frame, true);
+      replacer_->Remove(frame);
+      stats_.Add(BufferPoolCounter::EVICTION);
+    }
+    page->page_id_ = INVALID_PAGE_ID;
+    page->is_dirty_ = false;
+  }
+  free_list_.remove_if([pool_size](frame_id_t frame) { return static_cast<size_t>(frame) >= pool_size; });
+  pool_size_ = pool_size;
+  // The retired frames stay claimed, but their data goes back to the operating system and reads as zeros from now on.
+  madvise(frame_data_ + pool_size * BUSTUB_PAGE_SIZE, (old_pool_size - pool_size) * BUSTUB_PAGE_SIZE, MADV_DONTNEED);
+  return true;
+}
+
+void BufferPoolManagerInstance::StartBackgroundFlusher(double low_watermark, double high_watermark) {
+  BUSTUB_ASSERT(0 <= low_watermark && low_watermark <= high_watermark && high_watermark <= 1,
+                "watermarks should be fractions of the pool with low <= high");
+  StopBackgroundFlusher();
+  flush_low_watermark_ = low_watermark;
+  flush_high_watermark_ = high_watermark;
+  enable_flusher_ = true;
+  flusher_thread_ = new std::thread(&BufferPoolManagerInstance::RunBackgroundFlusher, this);
+}
+
+void BufferPoolManagerInstance::EnableAdmissionFilter(size_t window_size) {
+  BUSTUB_ASSERT(window_size > 0, "the admission window needs at least one frame");
+  frequency_sketch_ = std::make_unique<FrequencySketch>(max_pool_size_);
+  // AcquireRingFrame() gives every instance its share of a ring, so this ring is sized for all of them.
+  admission_window_ = std::make_unique<BufferAccessStrategy>(window_size * num_instances_);
+}
+
+void BufferPoolManagerInstance::StopBackgroundFlusher() {
+  if (flusher_thread_ == nullptr) {
+    return;
+  }
+  {
+    std::scoped_lock<std::mutex> lock(flusher_latch_);
+    enable_flusher_ = false;
+  }
+  flusher_cv_.notify_one();
+  flusher_thread_->join();
+  delete flusher_thread_;
+  flusher_thread_ = nullptr;
+}
+
+void BufferPoolManagerInstance::WakeBackgroundFlusher() {
+  if (!enable_flusher_) {
+    return;
+  }
+  {
+    std::scoped_lock<std::mutex> lock(flusher_latch_);
+    flusher_wakeup_ = true;
+  }
+  flusher_cv_.notify_one();
+}
+
+void BufferPoolManagerInstance::RunBackgroundFlusher() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(flusher_latch_);
+      flusher_cv_.wait_for(lock, background_flush_interval, [&] { return !enable_flusher_ || flusher_wakeup_; });
+      if (!enable_flusher_) {
+        return;
+      }
+      flusher_wakeup_ = false;
+    }
+    // The watermarks are fractions, so that they follow the pool when it is resized.
+    const auto pool_size = static_cast<double>(pool_size_);
+    size_t clean = CountCleanFrames();
+    if (clean < static_cast<size_t>(flush_low_watermark_ * pool_size)) {
+      FlushSomeDirtyPages(static_cast<size_t>(flush_high_watermark_ * pool_size) - clean);
+    }
+  }
+}
+
+auto BufferPoolManagerInstance::CountCleanFrames() -> size_t {
+  size_t clean = 0;
+  for (size_t i = 0; i < pool_size_; i++) {
+    Page *page = pages_ + i;
+    if (page->pin_count_ == 0 && (!page->is_dirty_ || page->page_id_ == INVALID_PAGE_ID)) {
+      clean++;
+    }
+  }
+  return clean;
+}
+
+void BufferPoolManagerInstance::FlushSomeDirtyPages(size_t max_pages) {
+  std::vector<std::pair<page_id_t, frame_id_t>> dirty;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (size_t i = 0; i < pool_size_; i++) {
+      Page *page = pages_ + i;
+      if (page->pin_count_ == 0 && page->is_dirty_ && frame_io_[i] == FrameIOState::NONE) {
+        dirty.emplace_back(page->page_id_, static_cast<frame_id_t>(i));
+      }
+    }
+  }
+  if (dirty.empty()) {
+    return;
+  }
+  // Write in page id order, starting where the previous round stopped, so that consecutive rounds sweep over the
+  // whole file instead of writing the same low page ids again and again.
+  std::sort(dirty.begin(), dirty.end());
+  auto start = std::upper_bound(dirty.begin(), dirty.end(),
+                                std::make_pair(flush_cursor_, std::numeric_limits<frame_id_t>::max()));
+  std::rotate(dirty.begin(), start, dirty.end());
+
+  // Copy the pages out and write the copies in batches, so that many writes are in flight at once without holding
+  // the latches of the pages while waiting for the disk. The frames stay pinned until their copy is on disk: they are
+  // clean by then, and a fetch after an eviction must not read the old data from disk.
+  std::vector<char> buffer(std::min<size_t>(max_pages, DISK_QUEUE_DEPTH) * BUSTUB_PAGE_SIZE);
+  std::vector<DiskRequest> requests;
+  std::vector<std::future<bool>> written;
+  std::vector<frame_id_t> pinned;
+  size_t flushed = 0;
+  auto write_batch = [&]() {
+    disk_manager_->Schedule(&requests);
+    for (auto &future : written) {
+      future.wait();
+    }
+    for (frame_id_t frame : pinned) {
+      UnpinFrame(frame, false);
+    }
+    flushed_pages_ += pinned.size();
+    written.clear();
+    pinned.clear();
+  };
+  for (auto [page_id, frame] : dirty) {
+    if (flushed == max_pages || !enable_flusher_) {
+      break;
+    }
+    Page *page = pages_ + frame;
+    {
+      std::scoped_lock<std::mutex> lock(latch_);
+      // Pages that got pinned in the meantime are probably being modified and are not eviction candidates anyway.
+      if (page->page_id_ != page_id || page->pin_count_ != 0 || !page->is_dirty_ ||
+          frame_io_[frame] != FrameIOState::NONE) {
+        continue;
+      }
+      page->pin_count_++;
+      replacer_->SetEvictable(frame, false);
+    }
+    // Clear the dirty flag before copying the data out: a writer that comes in later marks the page dirty again when
+    // it unpins it. The page latch keeps the copy from seeing a half-modified page.
+    char *copy = buffer.data() + pinned.size() * BUSTUB_PAGE_SIZE;
+    page->RLatch();
+    page->is_dirty_ = false;
+    std::memcpy(copy, page->GetData(), BUSTUB_PAGE_SIZE);
+    page->RUnlatch();
+    requests.push_back(DiskRequest{true, copy, page_id, {}});
+    written.push_back(requests.back().callback_.get_future());
+    pinned.push_back(frame);
+    flush_cursor_ = page_id;
+    flushed++;
+    if (pinned.size() * BUSTUB_PAGE_SIZE == buffer.size()) {
+      write_batch();
+    }
+  }
+  if (!pinned.empty()) {
+    write_batch();
+  }
+}
+
+void BufferPoolManagerInstance::ReadAhead(page_id_t page_id, next_page_fn next_page, size_t num_pages,
+                                          std::shared_ptr<BufferAccessStrategy> strategy) {
+  read_ahead_->Schedule(page_id, next_page, std::min(num_pages, pool_size_ / 8), std::move(strategy));
+}
+
+auto BufferPoolManagerInstance::PrefetchPage(page_id_t page_id, next_page_fn next_page,
+                                             BufferAccessStrategy *strategy) -> page_id_t {
+  ValidatePageId(page_id);
+  frame_id_t frame;
+  Page *page;
+  if (page_table_->Find(page_id, &frame) && TryPin(page_id, frame)) {
+    page = pages_ + frame;
+    if (frame_io_[frame] != FrameIOState::NONE) {
+      std::unique_lock<std::mutex> lock(latch_);
+      WaitForIO(&lock, frame);
+    }
+  } else {
+    // Read-ahead only follows the scan into the ring, it does not count towards activating it. Nor is it a fetch: it
+    // stays out of the statistics, the access frequencies of the admission filter and the access trace.
+    bool hit;
+    page = PinPage(page_id, strategy != nullptr && strategy->IsActive() ? strategy : nullptr, &hit);
+    if (page == nullptr) {
+      return INVALID_PAGE_ID;
+    }
+    frame = static_cast<frame_id_t>(page - pages_);
+  }
+  page->RLatch();
+  page_id_t next_page_id = next_page(page);
+  page->RUnlatch();
+  UnpinFrame(frame, false);
+  return next_page_id;
+}
+
+auto BufferPoolManagerInstance::PrefetchPage(page_id_t page_id) -> bool {
+  return PrefetchPage(page_id, [](Page *page) { return page->GetPageId(); }) == page_id;
+}
+
+auto BufferPoolManagerInstance::GetHotPages() -> std::vector<page_id_t> {
+  std::vector<page_id_t> hot_pages;
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (frame_id_t frame : replacer_->GetHotFrames()) {
+    if (pages_[frame].page_id_ != INVALID_PAGE_ID) {
+      hot_pages.push_back(pages_[frame].page_id_);
+    }
+  }
+  return hot_pages;
+}
+
+auto BufferPoolManagerInstance::AllocatePage(page_id_t reused, frame_id_t frame_id) -> page_id_t {
+  page_id_t page_id = reused;
+  if (page_id != INVALID_PAGE_ID && !DropStalePage(page_id, frame_id)) {
+    // Still in use by a stale reader, so it waits for another round in the reserved pages.
+    disk_manager_->ReturnFreePage(page_id, static_cast<page_id_t>(num_instances_));
+    page_id = INVALID_PAGE_ID;
+  }
+  if (page_id == INVALID_PAGE_ID) {
+    page_id = next_page_id_.fetch_add(static_cast<page_id_t>(num_instances_));
+  }
+  ValidatePageId(page_id);
+  return page_id;
+}
+
+auto BufferPoolManagerInstance::DropStalePage(page_id_t page_id, frame_id_t frame_id) -> bool {
+  // A deleted page is fetched back by whoever still held its id, e.g. an optimistic B+ tree descent that raced with a
+  // merge. Its old content must neither stay mapped next to the new page nor be written back over it.
+  if (writing_back_.count(page_id) != 0) {
+    return false;
+  }
+  frame_id_t frame;
+  if (!page_table_->Find(page_id, &frame)) {
+    return true;
+  }
+  if (frame == frame_id) {
+    // The frame picked for the new page holds the old one: forget it instead of writing it back.
+    Page *page = pages_ + frame;
+    page_table_->Remove(page_id);
+    page->rwlatch_.Invalidate();
+    page->page_id_ = INVALID_PAGE_ID;
+    page->is_dirty_ = false;
+    return true;
+  }
+  if (!ClaimFrame(frame)) {
+    return false;
+  }
+  DiscardFrame(frame);
+  return true;
+}
+
+void BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) {
+  // Ids that were never handed out are not ours to recycle.
+  if (page_id >= next_page_id_) {
+    return;
+  }
+  disk_manager_->DeallocatePage(page_id);
+}
+
+void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
+  // allocated pages mod back to this BPI
+  BUSTUB_ASSERT(page_id % num_instances_ == instance_index_, "Invalid page id for this buffer pool instance");
+}
 
 }  // namespace bustub
@@ -0,0 +1,104 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.cpp
+//
+// Identification: src/buffer/buffer_pool_stats.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_stats.h"
+
+#include <sched.h>
+#include <algorithm>
+#include <functional>
+#include <thread>  // NOLINT
+
+namespace bustub {
+
+auto BufferPoolStatsSnapshot::HitRatio() const -> double {
+  uint64_t fetches = Get(BufferPoolCounter::FETCH);
+  return fetches == 0 ? 0.0 : static_cast<double>(Get(BufferPoolCounter::HIT)) / static_cast<double>(fetches);
+}
+
+auto BufferPoolStatsSnapshot::LatencyPercentile(BufferPoolLatency histogram, double percentile) const -> uint64_t {
+  const auto &buckets = histograms_[static_cast<size_t>(histogram)];
+  uint64_t total = 0;
+  for (uint64_t count : buckets) {
+    total += count;
+  }
+  if (total == 0) {
+    return 0;
+  }
+  auto rank = static_cast<uint64_t>(percentile / 100 * static_cast<double>(total));
+  rank = std::clamp<uint64_t>(rank, 1, total);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NUM_BUCKETS; i++) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return (static_cast<uint64_t>(1) << (i + 1)) - 1;
+    }
+  }
+  return (static_cast<uint64_t>(1) << NUM_BUCKETS) - 1;
+}
+
+auto BufferPoolStatsSnapshot::operator+=(const BufferPoolStatsSnapshot &other) -> BufferPoolStatsSnapshot & {
+  for (size_t i = 0; i < counters_.size(); i++) {
+    counters_[i] += other.counters_[i];
+  }
+  for (size_t h = 0; h < histograms_.size(); h++) {
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+      histograms_[h][i] += other.histograms_[h][i];
+    }
+  }
+  return *this;
+}
+
+auto BufferPoolStats::LocalShard() -> Shard & {
+  int cpu = sched_getcpu();
+  if (cpu < 0) {
+    // No CPU number available, spread the threads out instead.
+    thread_local const size_t thread_hash = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    return shards_[thread_hash % NUM_SHARDS];
+  }
+  return shards_[static_cast<size_t>(cpu) % NUM_SHARDS];
+}
+
+void BufferPoolStats::RecordLatency(BufferPoolLatency histogram, std::chrono::nanoseconds latency) {
+  auto nanos = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 1));
+  size_t bucket = std::min<size_t>(63 - __builtin_clzll(nanos), BufferPoolStatsSnapshot::NUM_BUCKETS - 1);
+  LocalShard().histograms_[static_cast<size_t>(histogram)][bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+auto BufferPoolStats::Snapshot() const -> BufferPoolStatsSnapshot {
+  BufferPoolStatsSnapshot snapshot;
+  for (const auto &shard : shards_) {
+    for (size_t i = 0; i < snapshot.counters_.size(); i++) {
+      snapshot.counters_[i] += shard.counters_[i].load(std::memory_order_relaxed);
+    }
+    for (size_t h = 0; h < snapshot.histograms_.size(); h++) {
+      for (size_t i = 0; i < BufferPoolStatsSnapshot::NUM_BUCKETS; i++) {
+        snapshot.histograms_[h][i] += shard.histograms_[h][i].load(std::memory_order_relaxed);
+      }
+    }
+  }
+  return snapshot;
+}
+
+void BufferPoolStats::Reset() {
+  for (auto &shard : shards_) {
+    for (auto &counter : shard.counters_) {
+      counter.store(0, std::memory_order_relaxed);
+    }
+    for (auto &histogram : shard.histograms_) {
+      for (auto &bucket : histogram) {
+        bucket.store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_warmer.cpp
+//
+// Identification: src/buffer/buffer_pool_warmer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_warmer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+auto BufferPoolWarmer::SaveHotPages(BufferPoolManager *bpm, const std::string &file_name) -> bool {
+  std::vector<page_id_t> hot_pages = bpm->GetHotPages();
+  // Write a new file and rename it over the old one, so that a crash never leaves a half-written list behind.
+  std::string tmp_name = file_name + ".tmp";
+  std::ofstream out(tmp_name, std::ios::binary | std::ios::trunc | std::ios::out);
+  FileHeader header{MAGIC, static_cast<uint32_t>(hot_pages.size())};
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(hot_pages.data()),
+            static_cast<std::streamsize>(hot_pages.size() * sizeof(page_id_t)));
+  out.close();
+  if (out.fail() || rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+    LOG_DEBUG("I/O error while writing the hot page list");
+    remove(tmp_name.c_str());
+    return false;
+  }
+  return true;
+}
+
+auto BufferPoolWarmer::LoadHotPages(const std::string &file_name, page_id_t num_pages) -> std::vector<page_id_t> {
+  std::ifstream in(file_name, std::ios::binary | std::ios::in);
+  if (!in.is_open()) {
+    return {};
+  }
+  FileHeader header{};
+  in.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (in.fail() || header.magic_ != MAGIC) {
+    LOG_DEBUG("ignoring corrupt hot page list");
+    return {};
+  }
+  std::vector<page_id_t> hot_pages(header.num_pages_);
+  in.read(reinterpret_cast<char *>(hot_pages.data()),
+          static_cast<std::streamsize>(hot_pages.size() * sizeof(page_id_t)));
+  if (in.fail()) {
+    LOG_DEBUG("ignoring truncated hot page list");
+    return {};
+  }
+  // The database file may have shrunk or been recreated since the list was saved.
+  hot_pages.erase(std::remove_if(hot_pages.begin(), hot_pages.end(),
+                                 [num_pages](page_id_t page_id) { return page_id < 0 || page_id >= num_pages; }),
+                  hot_pages.end());
+  return hot_pages;
+}
+
+BufferPoolWarmer::BufferPoolWarmer(BufferPoolManager *bpm, std::vector<page_id_t> hot_pages)
+    : bpm_(bpm), pages_(std::move(hot_pages)) {
+  // Prefetching more than the pool holds would only evict the hottest pages again.
+  pages_.resize(std::min(pages_.size(), bpm_->GetPoolSize()));
+  std::sort(pages_.begin(), pages_.end());
+  pages_.erase(std::unique(pages_.begin(), pages_.end()), pages_.end());
+  thread_ = std::thread([this] { Run(); });
+}
+
+BufferPoolWarmer::~BufferPoolWarmer() {
+  stop_ = true;
+  Wait();
+}
+
+void BufferPoolWarmer::Wait() {
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void BufferPoolWarmer::Run() {
+  for (page_id_t page_id : pages_) {
+    if (stop_) {
+      return;
+    }
+    if (bpm_->PrefetchPage(page_id)) {
+      num_prefetched_++;
+    }
+  }
+}
+
+}  // namespace bustub
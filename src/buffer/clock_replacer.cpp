@@ -12,18 +12,57 @@
 
 #include "buffer/clock_replacer.h"
 
+#include "common/macros.h"
+
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : num_pages_(num_pages), in_clock_(num_pages), ref_(num_pages) {}
 
 ClockReplacer::~ClockReplacer() = default;
 
-auto ClockReplacer::Victim(frame_id_t *frame_id) -> bool { return false; }
+auto ClockReplacer::Victim(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (size_ == 0) {
+    return false;
+  }
+  // At most two sweeps: the first one may only clear reference bits.
+  while (true) {
+    if (in_clock_[hand_]) {
+      if (!ref_[hand_]) {
+        *frame_id = static_cast<frame_id_t>(hand_);
+        in_clock_[hand_] = false;
+        size_--;
+        hand_ = (hand_ + 1) % num_pages_;
+        return true;
+      }
+      ref_[hand_] = false;
+    }
+    hand_ = (hand_ + 1) % num_pages_;
+  }
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "Invalid frame id");
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (in_clock_[frame_id]) {
+    in_clock_[frame_id] = false;
+    size_--;
+  }
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "Invalid frame id");
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (!in_clock_[frame_id]) {
+    in_clock_[frame_id] = true;
+    size_++;
+  }
+  ref_[frame_id] = true;
+}
 
-auto ClockReplacer::Size() -> size_t { return 0; }
+auto ClockReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return size_;
+}
 
 }  // namespace bustub
@@ -0,0 +1,131 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// concurrent_clock_replacer.cpp
+//
+// Identification: src/buffer/concurrent_clock_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/concurrent_clock_replacer.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+ConcurrentClockReplacer::ConcurrentClockReplacer(size_t num_frames)
+    : num_frames_(num_frames), states_(std::make_unique<std::atomic<uint8_t>[]>(num_frames)) {
+  BUSTUB_ASSERT(num_frames > 0, "the replacer needs at least one frame");
+}
+
+auto ConcurrentClockReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(hand_latch_);
+  // Two sweeps find a victim if there is one: the first one may only clear reference bits. Concurrent hits can set
+  // them again behind the hand, so allow one more before giving up.
+  for (size_t step = 0; step < 3 * num_frames_ && size_ > 0; step++) {
+    size_t frame = hand_;
+    hand_ = (hand_ + 1) % num_frames_;
+    auto &state = states_[frame];
+    uint8_t current = state.load();
+    while ((current & (TRACKED | EVICTABLE)) == (TRACKED | EVICTABLE)) {
+      if ((current & REFERENCED) != 0) {
+        // Second chance.
+        if (state.compare_exchange_weak(current, static_cast<uint8_t>(current & ~REFERENCED))) {
+          break;
+        }
+        continue;
+      }
+      if (state.compare_exchange_weak(current, 0)) {
+        size_--;
+        *frame_id = static_cast<frame_id_t>(frame);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+auto ConcurrentClockReplacer::PeekVictim(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(hand_latch_);
+  // Evict() takes the first unreferenced evictable frame of its first sweep, or else the first evictable frame once the
+  // sweep has cleared every reference bit.
+  bool found = false;
+  for (size_t i = 0; i < num_frames_; i++) {
+    size_t frame = (hand_ + i) % num_frames_;
+    uint8_t current = states_[frame].load();
+    if ((current & (TRACKED | EVICTABLE)) != (TRACKED | EVICTABLE)) {
+      continue;
+    }
+    if ((current & REFERENCED) == 0) {
+      *frame_id = static_cast<frame_id_t>(frame);
+      return true;
+    }
+    if (!found) {
+      *frame_id = static_cast<frame_id_t>(frame);
+      found = true;
+    }
+  }
+  return found;
+}
+
+void ConcurrentClockReplacer::RecordAccess(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "Invalid frame id");
+  auto &state = states_[frame_id];
+  // Skip the write when the bits are already set, so that hits on a hot frame do not bounce its cache line around.
+  if ((state.load(std::memory_order_relaxed) & (TRACKED | REFERENCED)) != (TRACKED | REFERENCED)) {
+    state.fetch_or(TRACKED | REFERENCED);
+  }
+}
+
+void ConcurrentClockReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "Invalid frame id");
+  auto &state = states_[frame_id];
+  uint8_t current = state.load();
+  uint8_t desired;
+  do {
+    if ((current & TRACKED) == 0 || ((current & EVICTABLE) != 0) == set_evictable) {
+      return;
+    }
+    desired = static_cast<uint8_t>(set_evictable ? current | EVICTABLE : current & ~EVICTABLE);
+  } while (!state.compare_exchange_weak(current, desired));
+  size_ += set_evictable ? 1 : -1;
+}
+
+void ConcurrentClockReplacer::Remove(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_frames_, "Invalid frame id");
+  auto &state = states_[frame_id];
+  uint8_t current = state.load();
+  do {
+    if ((current & TRACKED) == 0) {
+      return;
+    }
+    BUSTUB_ASSERT((current & EVICTABLE) != 0, "Remove unEvictable frame id.");
+  } while (!state.compare_exchange_weak(current, 0));
+  size_--;
+}
+
+auto ConcurrentClockReplacer::Size() -> size_t { return static_cast<size_t>(std::max<int64_t>(size_, 0)); }
+
+auto ConcurrentClockReplacer::GetHotFrames() -> std::vector<frame_id_t> {
+  std::vector<frame_id_t> unreferenced;
+  std::vector<frame_id_t> referenced;
+  {
+    std::scoped_lock<std::mutex> lock(hand_latch_);
+    for (size_t i = 0; i < num_frames_; i++) {
+      size_t frame = (hand_ + i) % num_frames_;
+      uint8_t current = states_[frame].load();
+      if ((current & TRACKED) != 0) {
+        ((current & REFERENCED) != 0 ? referenced : unreferenced).push_back(static_cast<frame_id_t>(frame));
+      }
+    }
+  }
+  // That is the eviction order, so the hottest frames are at the end.
+  std::vector<frame_id_t> hot_frames(referenced.rbegin(), referenced.rend());
+  hot_frames.insert(hot_frames.end(), unreferenced.rbegin(), unreferenced.rend());
+  return hot_frames;
+}
+
+}  // namespace bustub
@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frequency_sketch.cpp
+//
+// Identification: src/buffer/frequency_sketch.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frequency_sketch.h"
+
+#include <algorithm>
+#include <array>
+
+namespace bustub {
+
+namespace {
+
+/** Round up to a power of two. */
+auto CeilPowerOfTwo(size_t n) -> size_t {
+  size_t power = 1;
+  while (power < n) {
+    power <<= 1;
+  }
+  return power;
+}
+
+/** One seed per row, so that pages colliding in one row are unlikely to collide in the others. */
+constexpr std::array<uint64_t, FrequencySketch::DEPTH> ROW_SEEDS = {0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL,
+                                                                   0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL};
+
+}  // namespace
+
+FrequencySketch::FrequencySketch(size_t capacity)
+    : width_(CeilPowerOfTwo(std::max<size_t>(capacity, 16))),
+      sample_size_(10 * std::max<size_t>(capacity, 1)),
+      counters_(std::make_unique<std::atomic<uint8_t>[]>(DEPTH * width_)) {}
+
+auto FrequencySketch::IndexOf(page_id_t page_id, size_t row) const -> size_t {
+  // The finalizer of MurmurHash3, so that consecutive page ids spread over the whole row.
+  uint64_t hash = static_cast<uint64_t>(static_cast<uint32_t>(page_id)) + ROW_SEEDS[row];
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return row * width_ + (hash & (width_ - 1));
+}
+
+void FrequencySketch::Increment(page_id_t page_id) {
+  for (size_t row = 0; row < DEPTH; row++) {
+    auto &counter = counters_[IndexOf(page_id, row)];
+    uint8_t count = counter.load(std::memory_order_relaxed);
+    while (count < MAX_COUNT && !counter.compare_exchange_weak(count, count + 1, std::memory_order_relaxed)) {
+    }
+  }
+  if (additions_.fetch_add(1, std::memory_order_relaxed) + 1 >= sample_size_) {
+    std::unique_lock<std::mutex> lock(aging_latch_, std::try_to_lock);
+    // Somebody else may have aged the counters while we were getting here.
+    if (lock.owns_lock() && additions_ >= sample_size_) {
+      Age();
+    }
+  }
+}
+
+auto FrequencySketch::Estimate(page_id_t page_id) const -> uint32_t {
+  uint32_t estimate = MAX_COUNT;
+  for (size_t row = 0; row < DEPTH; row++) {
+    estimate = std::min<uint32_t>(estimate, counters_[IndexOf(page_id, row)].load(std::memory_order_relaxed));
+  }
+  return estimate;
+}
+
+void FrequencySketch::Age() {
+  for (size_t i = 0; i < DEPTH * width_; i++) {
+    counters_[i].store(counters_[i].load(std::memory_order_relaxed) >> 1, std::memory_order_relaxed);
+  }
+  // The halved counters stand for half the accesses of the sample.
+  additions_ = sample_size_ / 2;
+}
+
+}  // namespace bustub
@@ -11,128 +11,126 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/lru_k_replacer.h"
-#include "iostream"
+
+#include <algorithm>
+#include <functional>
+#include <tuple>
 
 namespace bustub {
 
-LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : replacer_size_(num_frames), k_(k) {}
+LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : replacer_size_(num_frames), k_(k), frames_(num_frames) {
+  BUSTUB_ASSERT(k > 0, "k must be positive");
+}
 
 auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
-  latch_.lock();
-  for (auto iter = temp_pool_.begin(); iter != temp_pool_.end();) {
-    if ((*iter)->IsEvictable()) {
-      *frame_id = (*iter)->GetId();
-      iter = temp_pool_.erase(iter);
-      temp_map_.erase(*frame_id);
-      latch_.unlock();
-      return true;
-    }
-    iter++;
-  }
-  for (auto iter = cache_pool_.begin(); iter != cache_pool_.end();) {
-    if ((*iter)->IsEvictable()) {
-      *frame_id = (*iter)->GetId();
-      iter = cache_pool_.erase(iter);
-      cache_map_.erase(*frame_id);
-      latch_.unlock();
-      return true;
-    }
-    iter++;
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto &candidates = inf_frames_.empty() ? finite_frames_ : inf_frames_;
+  if (candidates.empty()) {
+    return false;
   }
-  latch_.unlock();
-  return false;
+  *frame_id = candidates.begin()->second;
+  candidates.erase(candidates.begin());
+  frames_[*frame_id].Reset();
+  curr_size_--;
+  return true;
 }
 
-void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
-  BUSTUB_ASSERT(frame_id <= (int)replacer_size_, "Invalid frame id");
-  latch_.lock();
-  if (cache_map_.count(frame_id) != 0U) {
-    auto iter = cache_map_[frame_id];
-    cache_pool_.emplace_back(std::move(*iter));
-    cache_pool_.erase(iter);
-    cache_map_[frame_id] = (--cache_pool_.end());
-    latch_.unlock();
-    return;
+auto LRUKReplacer::PeekVictim(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  const auto &candidates = inf_frames_.empty() ? finite_frames_ : inf_frames_;
+  if (candidates.empty()) {
+    return false;
   }
+  *frame_id = candidates.begin()->second;
+  return true;
+}
 
-  if (temp_map_.count(frame_id) != 0U) {
-    auto iter = temp_map_[frame_id];
-    (*iter)->IncreaseTimes();
-    if ((*iter)->GetTimes() >= k_) {
-      cache_pool_.emplace_back(std::move(*iter));
-      cache_map_[frame_id] = (--cache_pool_.end());
-      temp_pool_.erase(iter);
-      temp_map_.erase(frame_id);
-    }
-    latch_.unlock();
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < replacer_size_, "Invalid frame id");
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto &info = frames_[frame_id];
+  if (!info.IsEvictable()) {
+    info.RecordAccess(current_timestamp_++, k_);
     return;
   }
-
-  std::unique_ptr<FrameInfo> frame_ptr = std::make_unique<FrameInfo>(frame_id);
-  frame_ptr->IncreaseTimes();
-  temp_pool_.emplace_back(std::move(frame_ptr));
-  temp_map_[frame_id] = (--temp_pool_.end());
-  latch_.unlock();
+  // The frame's position in the eviction order depends on its history, so take it out and put it back.
+  EvictableSetOf(info).erase({info.GetOldestAccess(), frame_id});
+  info.RecordAccess(current_timestamp_++, k_);
+  EvictableSetOf(info).emplace(info.GetOldestAccess(), frame_id);
 }
 
 void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
-  latch_.lock();
-  if (temp_map_.count(frame_id) != 0U) {
-    auto iter = temp_map_[frame_id];
-    (*iter)->SetEvictable(set_evictable);
-    latch_.unlock();
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < replacer_size_, "Invalid frame id");
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto &info = frames_[frame_id];
+  if (!info.IsTracked() || info.IsEvictable() == set_evictable) {
     return;
   }
-
-  if (cache_map_.count(frame_id) != 0U) {
-    auto iter = cache_map_[frame_id];
-    (*iter)->SetEvictable(set_evictable);
-    latch_.unlock();
-    return;
+  info.SetEvictable(set_evictable);
+  if (set_evictable) {
+    EvictableSetOf(info).emplace(info.GetOldestAccess(), frame_id);
+    curr_size_++;
+  } else {
+    EvictableSetOf(info).erase({info.GetOldestAccess(), frame_id});
+    curr_size_--;
   }
-  latch_.unlock();
 }
 
 void LRUKReplacer::Remove(frame_id_t frame_id) {
-  latch_.lock();
-  if (temp_map_.count(frame_id) != 0U) {
-    auto iter = temp_map_[frame_id];
-    BUSTUB_ASSERT((*iter)->IsEvictable(), "Remove unEvictable frame id.");
-    temp_pool_.erase(iter);
-    temp_map_.erase(frame_id);
-    latch_.unlock();
-    return;
-  }
-  if (cache_map_.count(frame_id) != 0U) {
-    auto iter = cache_map_[frame_id];
-    BUSTUB_ASSERT((*iter)->IsEvictable(), "Remove unEvictable frame id.");
-    cache_pool_.erase(iter);
-    cache_map_.erase(frame_id);
-    latch_.unlock();
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < replacer_size_, "Invalid frame id");
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto &info = frames_[frame_id];
+  if (!info.IsTracked()) {
     return;
   }
-  latch_.unlock();
+  BUSTUB_ASSERT(info.IsEvictable(), "Remove unEvictable frame id.");
+  EvictableSetOf(info).erase({info.GetOldestAccess(), frame_id});
+  info.Reset();
+  curr_size_--;
 }
 
 auto LRUKReplacer::Size() -> size_t {
   std::scoped_lock<std::mutex> lock(latch_);
-  size_t num = 0;
-  for (auto &ele : cache_pool_) {
-    if (ele->IsEvictable()) {
-      num++;
+  return curr_size_;
+}
+
+auto LRUKReplacer::GetHotFrames() -> std::vector<frame_id_t> {
+  std::vector<std::tuple<bool, size_t, frame_id_t>> tracked;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (size_t i = 0; i < frames_.size(); i++) {
+      if (frames_[i].IsTracked()) {
+        tracked.emplace_back(frames_[i].HasKAccesses(k_), frames_[i].GetOldestAccess(), static_cast<frame_id_t>(i));
+      }
     }
   }
-  for (auto &ele : temp_pool_) {
-    if (ele->IsEvictable()) {
-      num++;
-    }
+  std::sort(tracked.begin(), tracked.end(), std::greater<>());
+  std::vector<frame_id_t> hot_frames;
+  hot_frames.reserve(tracked.size());
+  for (const auto &entry : tracked) {
+    hot_frames.push_back(std::get<2>(entry));
+  }
+  return hot_frames;
+}
+
+void LRUKReplacer::FrameInfo::RecordAccess(size_t timestamp, size_t k) {
+  if (history_.size() != k) {
+    history_.resize(k);
+  }
+  if (count_ < k) {
+    history_[(head_ + count_) % k] = timestamp;
+    count_++;
+    return;
   }
-  return num;
+  // The history is full: the oldest entry is overwritten and the next one becomes the oldest.
+  history_[head_] = timestamp;
+  head_ = (head_ + 1) % k;
 }
 
-LRUKReplacer::FrameInfo::FrameInfo(frame_id_t frame_id) : frame_id_(frame_id) {
-  times_ = 0;
-  evictable_ = true;
+void LRUKReplacer::FrameInfo::Reset() {
+  head_ = 0;
+  count_ = 0;
+  evictable_ = false;
 }
 
 }  // namespace bustub
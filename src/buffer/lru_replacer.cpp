@@ -14,16 +14,43 @@
 
 namespace bustub {
 
-LRUReplacer::LRUReplacer(size_t num_pages) {}
+LRUReplacer::LRUReplacer(size_t num_pages) : num_pages_(num_pages) {}
 
 LRUReplacer::~LRUReplacer() = default;
 
-auto LRUReplacer::Victim(frame_id_t *frame_id) -> bool { return false; }
-
-void LRUReplacer::Pin(frame_id_t frame_id) {}
-
-void LRUReplacer::Unpin(frame_id_t frame_id) {}
-
-auto LRUReplacer::Size() -> size_t { return 0; }
+auto LRUReplacer::Victim(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (lru_list_.empty()) {
+    return false;
+  }
+  *frame_id = lru_list_.front();
+  lru_list_.pop_front();
+  lru_map_.erase(*frame_id);
+  return true;
+}
+
+void LRUReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto iter = lru_map_.find(frame_id);
+  if (iter == lru_map_.end()) {
+    return;
+  }
+  lru_list_.erase(iter->second);
+  lru_map_.erase(iter);
+}
+
+void LRUReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (lru_map_.count(frame_id) != 0 || lru_list_.size() >= num_pages_) {
+    return;
+  }
+  lru_list_.push_back(frame_id);
+  lru_map_[frame_id] = std::prev(lru_list_.end());
+}
+
+auto LRUReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return lru_list_.size();
+}
 
 }  // namespace bustub
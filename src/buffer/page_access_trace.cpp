@@ -0,0 +1,108 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_access_trace.cpp
+//
+// Identification: src/buffer/page_access_trace.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_access_trace.h"
+
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "fmt/format.h"
+
+namespace bustub {
+
+namespace {
+
+constexpr uint64_t UNPIN_FLAG = 2;
+constexpr uint64_t DIRTY_FLAG = 1;
+
+}  // namespace
+
+PageAccessTraceWriter::PageAccessTraceWriter(const std::string &file_name)
+    : out_(file_name, std::ios::binary | std::ios::trunc | std::ios::out), start_(std::chrono::steady_clock::now()) {
+  if (!out_.is_open()) {
+    throw Exception(fmt::format("can't open trace file {}", file_name));
+  }
+  PageAccessTraceHeader header{PageAccessTraceHeader::MAGIC, PageAccessTraceHeader::VERSION};
+  out_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  buffer_.reserve(BATCH_SIZE * RECORD_SIZE);
+}
+
+PageAccessTraceWriter::~PageAccessTraceWriter() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  FlushLocked();
+}
+
+void PageAccessTraceWriter::Record(page_id_t page_id, PageAccessType type, bool is_dirty) {
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_);
+  uint64_t word = static_cast<uint64_t>(elapsed.count()) << 2;
+  word |= (type == PageAccessType::UNPIN ? UNPIN_FLAG : 0) | (is_dirty ? DIRTY_FLAG : 0);
+  char record[RECORD_SIZE];
+  memcpy(record, &word, sizeof(word));
+  memcpy(record + sizeof(word), &page_id, sizeof(page_id));
+
+  std::scoped_lock<std::mutex> lock(latch_);
+  buffer_.insert(buffer_.end(), record, record + RECORD_SIZE);
+  num_records_++;
+  if (buffer_.size() >= BATCH_SIZE * RECORD_SIZE) {
+    FlushLocked();
+  }
+}
+
+void PageAccessTraceWriter::Flush() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  FlushLocked();
+}
+
+void PageAccessTraceWriter::FlushLocked() {
+  out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  out_.flush();
+  if (out_.fail()) {
+    LOG_DEBUG("I/O error while writing the page access trace");
+  }
+  buffer_.clear();
+}
+
+auto PageAccessTraceWriter::GetNumRecords() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return num_records_;
+}
+
+PageAccessTraceReader::PageAccessTraceReader(const std::string &file_name)
+    : in_(file_name, std::ios::binary | std::ios::in) {
+  if (!in_.is_open()) {
+    throw Exception(fmt::format("can't open trace file {}", file_name));
+  }
+  PageAccessTraceHeader header{};
+  in_.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (in_.fail() || header.magic_ != PageAccessTraceHeader::MAGIC ||
+      header.version_ != PageAccessTraceHeader::VERSION) {
+    throw Exception(fmt::format("{} is not a page access trace", file_name));
+  }
+}
+
+auto PageAccessTraceReader::Next(PageAccessRecord *record) -> bool {
+  char buffer[PageAccessTraceWriter::RECORD_SIZE];
+  in_.read(buffer, sizeof(buffer));
+  if (in_.gcount() != sizeof(buffer)) {
+    return false;
+  }
+  uint64_t word;
+  memcpy(&word, buffer, sizeof(word));
+  memcpy(&record->page_id_, buffer + sizeof(word), sizeof(page_id_t));
+  record->timestamp_ = word >> 2;
+  record->type_ = (word & UNPIN_FLAG) != 0 ? PageAccessType::UNPIN : PageAccessType::PIN;
+  record->is_dirty_ = (word & DIRTY_FLAG) != 0;
+  return true;
+}
+
+}  // namespace bustub
@@ -0,0 +1,132 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace bustub {
+
+PageTable::PageTable(size_t num_frames) {
+  // Keep the load factor at or below one half, so that probe sequences stay short.
+  capacity_ = CACHE_LINE_SIZE / sizeof(Slot);
+  shift_ = 64 - 3;
+  while (capacity_ < 2 * num_frames) {
+    capacity_ <<= 1;
+    shift_--;
+  }
+  mask_ = capacity_ - 1;
+
+  void *memory = std::aligned_alloc(CACHE_LINE_SIZE, capacity_ * sizeof(Slot));
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  auto *slots = static_cast<Slot *>(memory);
+  for (size_t i = 0; i < capacity_; i++) {
+    new (slots + i) Slot();
+  }
+  slots_.reset(slots);
+}
+
+void PageTable::SlotDeleter::operator()(Slot *slots) const {
+  // Slot is trivially destructible, so the storage can be released directly.
+  std::free(slots);  // NOLINT
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  BUSTUB_ASSERT(page_id >= 0 && frame_id >= 0, "only valid pages can be mapped to valid frames");
+  size_t slot = HashSlot(page_id);
+  size_t target = capacity_;
+  for (size_t probes = 0; probes < capacity_; probes++) {
+    uint64_t entry = slots_[slot].value_.load(std::memory_order_relaxed);
+    if (entry == EMPTY) {
+      if (target == capacity_) {
+        target = slot;
+      }
+      break;
+    }
+    if (entry == TOMBSTONE) {
+      if (target == capacity_) {
+        target = slot;
+      }
+    } else {
+      // Two frames holding the same page would drift apart, and the eviction of either would unmap the other.
+      BUSTUB_ASSERT(PageOf(entry) != page_id, "a page can only be mapped to one frame at a time");
+    }
+    slot = (slot + 1) & mask_;
+  }
+  BUSTUB_ASSERT(target != capacity_, "the page table is sized for the pool and cannot be full");
+
+  if (slots_[target].value_.load(std::memory_order_relaxed) == TOMBSTONE) {
+    tombstones_--;
+  }
+  slots_[target].value_.store(Pack(page_id, frame_id), std::memory_order_release);
+  size_++;
+}
+
+auto PageTable::Remove(page_id_t page_id) -> bool {
+  size_t slot = HashSlot(page_id);
+  size_t probes = 0;
+  for (; probes < capacity_; probes++) {
+    uint64_t entry = slots_[slot].value_.load(std::memory_order_relaxed);
+    if (entry == EMPTY) {
+      return false;
+    }
+    if (entry != TOMBSTONE && PageOf(entry) == page_id) {
+      break;
+    }
+    slot = (slot + 1) & mask_;
+  }
+  if (probes == capacity_) {
+    return false;
+  }
+  size_--;
+
+  // If the next slot is empty no probe sequence runs through this one, so it can be emptied right away, and so can
+  // the tombstones right before it.
+  if (slots_[(slot + 1) & mask_].value_.load(std::memory_order_relaxed) != EMPTY) {
+    slots_[slot].value_.store(TOMBSTONE, std::memory_order_release);
+    if (++tombstones_ > capacity_ / 4) {
+      Rebuild();
+    }
+    return true;
+  }
+  slots_[slot].value_.store(EMPTY, std::memory_order_release);
+  slot = (slot - 1) & mask_;
+  while (slots_[slot].value_.load(std::memory_order_relaxed) == TOMBSTONE) {
+    slots_[slot].value_.store(EMPTY, std::memory_order_release);
+    tombstones_--;
+    slot = (slot - 1) & mask_;
+  }
+  return true;
+}
+
+void PageTable::Rebuild() {
+  std::vector<uint64_t> entries;
+  entries.reserve(size_);
+  for (size_t i = 0; i < capacity_; i++) {
+    uint64_t entry = slots_[i].value_.load(std::memory_order_relaxed);
+    if (entry != EMPTY && entry != TOMBSTONE) {
+      entries.push_back(entry);
+    }
+    slots_[i].value_.store(EMPTY, std::memory_order_release);
+  }
+  size_ = 0;
+  tombstones_ = 0;
+  for (uint64_t entry : entries) {
+    Insert(PageOf(entry), FrameOf(entry));
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,207 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                                     size_t replacer_k, LogManager *log_manager, size_t max_pool_size,
+                                                     ReplacerType replacer_type)
+    : num_instances_(num_instances), disk_manager_(disk_manager) {
+  BUSTUB_ASSERT(num_instances > 0, "a parallel buffer pool needs at least one instance");
+  instances_.reserve(num_instances_);
+  for (size_t i = 0; i < num_instances_; i++) {
+    instances_.emplace_back(std::make_unique<BufferPoolManagerInstance>(
+        pool_size, static_cast<uint32_t>(num_instances_), static_cast<uint32_t>(i), disk_manager, replacer_k,
+        log_manager, max_pool_size, replacer_type));
+  }
+  read_ahead_ = std::make_unique<ReadAheadWorker>(
+      [this](page_id_t page_id, next_page_fn next_page, BufferAccessStrategy *strategy) {
+        return GetBufferPoolManager(page_id)->PrefetchPage(page_id, next_page, strategy);
+      });
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() = default;
+
+auto ParallelBufferPoolManager::GetPoolSize() -> size_t {
+  size_t pool_size = 0;
+  for (auto &instance : instances_) {
+    pool_size += instance->GetPoolSize();
+  }
+  return pool_size;
+}
+
+auto ParallelBufferPoolManager::GetMaxPoolSize() -> size_t {
+  size_t max_pool_size = 0;
+  for (auto &instance : instances_) {
+    max_pool_size += instance->GetMaxPoolSize();
+  }
+  return max_pool_size;
+}
+
+auto ParallelBufferPoolManager::Resize(size_t pool_size) -> bool {
+  if (pool_size < num_instances_) {
+    return false;
+  }
+  std::vector<size_t> old_sizes;
+  for (size_t i = 0; i < num_instances_; i++) {
+    size_t instance_size = pool_size / num_instances_ + (i < pool_size % num_instances_ ? 1 : 0);
+    old_sizes.push_back(instances_[i]->GetPoolSize());
+    if (!instances_[i]->Resize(instance_size)) {
+      for (size_t j = 0; j < i; j++) {
+        instances_[j]->Resize(old_sizes[j]);
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+void ParallelBufferPoolManager::StartBackgroundFlusher(double low_watermark, double high_watermark) {
+  for (auto &instance : instances_) {
+    instance->StartBackgroundFlusher(low_watermark, high_watermark);
+  }
+}
+
+void ParallelBufferPoolManager::StopBackgroundFlusher() {
+  for (auto &instance : instances_) {
+    instance->StopBackgroundFlusher();
+  }
+}
+
+void ParallelBufferPoolManager::SetAccessTrace(PageAccessTraceWriter *trace) {
+  for (auto &instance : instances_) {
+    instance->SetAccessTrace(trace);
+  }
+}
+
+void ParallelBufferPoolManager::EnableAdmissionFilter(size_t window_size) {
+  for (auto &instance : instances_) {
+    instance->EnableAdmissionFilter(window_size);
+  }
+}
+
+auto ParallelBufferPoolManager::GetFlushedPageCount() const -> uint64_t {
+  uint64_t count = 0;
+  for (const auto &instance : instances_) {
+    count += instance->GetFlushedPageCount();
+  }
+  return count;
+}
+
+auto ParallelBufferPoolManager::GetEvictedDirtyPageCount() const -> uint64_t {
+  uint64_t count = 0;
+  for (const auto &instance : instances_) {
+    count += instance->GetEvictedDirtyPageCount();
+  }
+  return count;
+}
+
+auto ParallelBufferPoolManager::FetchPageOptimistic(page_id_t page_id, uint64_t *version) -> Page * {
+  return GetBufferPoolManager(page_id)->FetchPageOptimistic(page_id, version);
+}
+
+auto ParallelBufferPoolManager::PrefetchPage(page_id_t page_id) -> bool {
+  return GetBufferPoolManager(page_id)->PrefetchPage(page_id);
+}
+
+auto ParallelBufferPoolManager::GetHotPages() -> std::vector<page_id_t> {
+  std::vector<std::vector<page_id_t>> instance_pages;
+  size_t longest = 0;
+  for (auto &instance : instances_) {
+    instance_pages.push_back(instance->GetHotPages());
+    longest = std::max(longest, instance_pages.back().size());
+  }
+  std::vector<page_id_t> hot_pages;
+  for (size_t i = 0; i < longest; i++) {
+    for (const auto &pages : instance_pages) {
+      if (i < pages.size()) {
+        hot_pages.push_back(pages[i]);
+      }
+    }
+  }
+  return hot_pages;
+}
+
+auto ParallelBufferPoolManager::GetStats() -> BufferPoolStatsSnapshot {
+  BufferPoolStatsSnapshot stats;
+  for (auto &instance : instances_) {
+    stats += instance->GetStats();
+  }
+  return stats;
+}
+
+void ParallelBufferPoolManager::ResetStats() {
+  for (auto &instance : instances_) {
+    instance->ResetStats();
+  }
+}
+
+void ParallelBufferPoolManager::ReadAhead(page_id_t page_id, next_page_fn next_page, size_t num_pages,
+                                          std::shared_ptr<BufferAccessStrategy> strategy) {
+  read_ahead_->Schedule(page_id, next_page, std::min(num_pages, GetPoolSize() / 8), std::move(strategy));
+}
+
+auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance * {
+  BUSTUB_ASSERT(page_id >= 0, "Invalid page id");
+  return instances_[static_cast<size_t>(page_id) % num_instances_].get();
+}
+
+auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+auto ParallelBufferPoolManager::FetchPgStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  return GetBufferPoolManager(page_id)->FetchPage(page_id, strategy);
+}
+
+auto ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+auto ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
+  // Every call starts at a different instance so that concurrent callers spread out over the shards instead of all
+  // hammering instance 0 until it is full.
+  size_t start = next_instance_.fetch_add(1) % num_instances_;
+  for (size_t i = 0; i < num_instances_; i++) {
+    Page *page = instances_[(start + i) % num_instances_]->TryNewPage(page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  // A full instance is not a failure as long as another one has room.
+  instances_[start]->CountPinFailure();
+  return nullptr;
+}
+
+auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPgsImp() {
+  for (auto &instance : instances_) {
+    instance->FlushDirtyPages();
+  }
+  // The instances share the disk manager, one sync makes the writes of all of them durable.
+  disk_manager_->Sync();
+}
+
+}  // namespace bustub
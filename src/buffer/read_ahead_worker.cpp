@@ -0,0 +1,68 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead_worker.cpp
+//
+// Identification: src/buffer/read_ahead_worker.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/read_ahead_worker.h"
+
+namespace bustub {
+
+ReadAheadWorker::~ReadAheadWorker() {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    stop_ = true;
+  }
+  cv_.notify_one();
+  if (thread_ != nullptr) {
+    thread_->join();
+    delete thread_;
+  }
+}
+
+void ReadAheadWorker::Schedule(page_id_t page_id, BufferPoolManager::next_page_fn next_page, size_t num_pages,
+                               std::shared_ptr<BufferAccessStrategy> strategy) {
+  if (page_id == INVALID_PAGE_ID || num_pages == 0) {
+    return;
+  }
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (stop_ || queue_.size() >= MAX_PENDING) {
+      return;
+    }
+    queue_.push_back({page_id, next_page, num_pages, std::move(strategy)});
+    if (thread_ == nullptr) {
+      thread_ = new std::thread(&ReadAheadWorker::Run, this);
+    }
+  }
+  cv_.notify_one();
+}
+
+void ReadAheadWorker::Run() {
+  while (true) {
+    Request request;
+    {
+      std::unique_lock<std::mutex> lock(latch_);
+      cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+      if (stop_) {
+        return;
+      }
+      request = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    page_id_t page_id = request.page_id_;
+    for (size_t i = 0; i < request.num_pages_ && page_id != INVALID_PAGE_ID; i++) {
+      page_id_t next_page_id = prefetch_(page_id, request.next_page_, request.strategy_.get());
+      // A chain that runs into itself is corrupt or was modified under us; stop following it.
+      page_id = next_page_id == page_id ? INVALID_PAGE_ID : next_page_id;
+    }
+  }
+}
+
+}  // namespace bustub
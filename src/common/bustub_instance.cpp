@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <optional>
 #include <shared_mutex>
 #include <string>
@@ -12,6 +13,9 @@
 #include "binder/statement/select_statement.h"
 #include "binder/statement/set_show_statement.h"
 #include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/buffer_pool_warmer.h"
+#include "buffer/page_access_trace.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "catalog/table_generator.h"
 #include "common/bustub_instance.h"
@@ -27,6 +31,7 @@
 #include "execution/plans/abstract_plan.h"
 #include "fmt/core.h"
 #include "fmt/format.h"
+#include "storage/disk/disk_manager_uring.h"
 #include "optimizer/optimizer.h"
 #include "planner/planner.h"
 #include "recovery/checkpoint_manager.h"
@@ -41,23 +46,17 @@ auto BustubInstance::MakeExecutorContext(Transaction *txn) -> std::unique_ptr<Ex
   return std::make_unique<ExecutorContext>(txn, catalog_, buffer_pool_manager_, txn_manager_, lock_manager_);
 }
 
-BustubInstance::BustubInstance(const std::string &db_file_name) {
+BustubInstance::BustubInstance(const std::string &db_file_name, size_t bpm_instances, bool warm_up_buffer_pool,
+                               bool direct_io) {
   enable_logging = false;
 
   // Storage related.
-  disk_manager_ = new DiskManager(db_file_name);
+  disk_manager_ = new DiskManagerUring(db_file_name, DISK_QUEUE_DEPTH, direct_io);
 
   // Log related.
   log_manager_ = new LogManager(disk_manager_);
 
-  // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
-  // buffer pool size specified in `config.h`.
-  try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
-  } catch (NotImplementedException &e) {
-    std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
-    buffer_pool_manager_ = nullptr;
-  }
+  MakeBufferPoolManager(bpm_instances);
 
   // Transaction (txn) related.
   lock_manager_ = new LockManager();
@@ -71,9 +70,18 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
 
   // Execution engine.
   execution_engine_ = new ExecutionEngine(buffer_pool_manager_, txn_manager_, catalog_);
+
+  // Buffer pool warm-up. The list is consumed, so that a crash before the next clean shutdown does not warm the pool
+  // up with a stale one.
+  if (warm_up_buffer_pool && buffer_pool_manager_ != nullptr) {
+    warm_up_file_name_ = db_file_name.substr(0, db_file_name.rfind('.')) + ".warm";
+    auto hot_pages = BufferPoolWarmer::LoadHotPages(warm_up_file_name_, disk_manager_->GetNumPages());
+    remove(warm_up_file_name_.c_str());
+    warmer_ = std::make_unique<BufferPoolWarmer>(buffer_pool_manager_, std::move(hot_pages));
+  }
 }
 
-BustubInstance::BustubInstance() {
+BustubInstance::BustubInstance(size_t bpm_instances) {
   enable_logging = false;
 
   // Storage related.
@@ -82,14 +90,7 @@ BustubInstance::BustubInstance() {
   // Log related.
   log_manager_ = new LogManager(disk_manager_);
 
-  // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
-  // buffer pool size specified in `config.h`.
-  try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
-  } catch (NotImplementedException &e) {
-    std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
-    buffer_pool_manager_ = nullptr;
-  }
+  MakeBufferPoolManager(bpm_instances);
 
   // Transaction (txn) related.
   lock_manager_ = new LockManager();
@@ -105,6 +106,49 @@ BustubInstance::BustubInstance() {
   execution_engine_ = new ExecutionEngine(buffer_pool_manager_, txn_manager_, catalog_);
 }
 
+void BustubInstance::MakeBufferPoolManager(size_t bpm_instances) {
+  // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
+  // buffer pool size specified in `config.h`. When the pool is sharded, the frames are split evenly
+  // between the instances. Dirty pages are written back in the background so that queries rarely
+  // wait for a write-back when they need a frame. `SET buffer_pool_size` resizes the pool later on.
+  const size_t pool_size = 128;
+  try {
+    if (bpm_instances > 1) {
+      auto *bpm = new ParallelBufferPoolManager(bpm_instances, (pool_size + bpm_instances - 1) / bpm_instances,
+                                                disk_manager_, LRUK_REPLACER_K, log_manager_,
+                                                (MAX_BUFFER_POOL_SIZE + bpm_instances - 1) / bpm_instances);
+      bpm->StartBackgroundFlusher();
+      buffer_pool_manager_ = bpm;
+    } else {
+      auto *bpm =
+          new BufferPoolManagerInstance(pool_size, disk_manager_, LRUK_REPLACER_K, log_manager_, MAX_BUFFER_POOL_SIZE);
+      bpm->StartBackgroundFlusher();
+      buffer_pool_manager_ = bpm;
+    }
+  } catch (NotImplementedException &e) {
+    std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
+    buffer_pool_manager_ = nullptr;
+  }
+}
+
+void BustubInstance::SetBufferPoolSize(const std::string &value) {
+  if (buffer_pool_manager_ == nullptr) {
+    throw Exception("no buffer pool to resize");
+  }
+  size_t pool_size = 0;
+  try {
+    pool_size = std::stoul(value);
+  } catch (std::exception &e) {
+    throw Exception(fmt::format("invalid buffer pool size: {}", value));
+  }
+  if (pool_size == 0 || pool_size > buffer_pool_manager_->GetMaxPoolSize()) {
+    throw Exception(fmt::format("buffer pool size must be between 1 and {}", buffer_pool_manager_->GetMaxPoolSize()));
+  }
+  if (!buffer_pool_manager_->Resize(pool_size)) {
+    throw Exception("can't shrink the buffer pool while the pages it would drop are pinned, try again later");
+  }
+}
+
 void BustubInstance::CmdDisplayTables(ResultWriter &writer) {
   auto table_names = catalog_->GetTableNames();
   writer.BeginTable(false);
@@ -146,6 +190,59 @@ void BustubInstance::CmdDisplayIndices(ResultWriter &writer) {
   writer.EndTable();
 }
 
+void BustubInstance::CmdDisplayDbSize(ResultWriter &writer) {
+  auto num_pages = static_cast<size_t>(disk_manager_->GetNumPages());
+  // Pages deleted before they were ever written out are not part of the file.
+  auto num_free = std::min(disk_manager_->GetNumFreePages(), num_pages);
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("pages");
+  writer.WriteHeaderCell("live");
+  writer.WriteHeaderCell("free");
+  writer.WriteHeaderCell("free_ratio");
+  writer.EndHeader();
+  writer.BeginRow();
+  writer.WriteCell(fmt::format("{}", num_pages));
+  writer.WriteCell(fmt::format("{}", num_pages - num_free));
+  writer.WriteCell(fmt::format("{}", num_free));
+  writer.WriteCell(fmt::format("{:.3f}", num_pages == 0 ? 0.0 : static_cast<double>(num_free) / num_pages));
+  writer.EndRow();
+  writer.EndTable();
+}
+
+void BustubInstance::CmdDisplayBufferPoolStats(ResultWriter &writer) {
+  auto stats = buffer_pool_manager_ == nullptr ? BufferPoolStatsSnapshot{} : buffer_pool_manager_->GetStats();
+  auto fetches = stats.Get(BufferPoolCounter::FETCH);
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("stat");
+  writer.WriteHeaderCell("value");
+  writer.EndHeader();
+  auto write_row = [&writer](const std::string &name, const std::string &value) {
+    writer.BeginRow();
+    writer.WriteCell(name);
+    writer.WriteCell(value);
+    writer.EndRow();
+  };
+  write_row("fetches", fmt::format("{}", fetches));
+  write_row("hits", fmt::format("{}", stats.Get(BufferPoolCounter::HIT)));
+  write_row("misses", fmt::format("{}", stats.Get(BufferPoolCounter::MISS)));
+  write_row("hit_ratio", fmt::format("{:.3f}", stats.HitRatio()));
+  write_row("evictions", fmt::format("{}", stats.Get(BufferPoolCounter::EVICTION)));
+  write_row("dirty_write_backs", fmt::format("{}", stats.Get(BufferPoolCounter::DIRTY_WRITE_BACK)));
+  write_row("pin_failures", fmt::format("{}", stats.Get(BufferPoolCounter::PIN_FAILURE)));
+  write_row("admission_rejections", fmt::format("{}", stats.Get(BufferPoolCounter::ADMISSION_REJECTION)));
+  const std::pair<BufferPoolLatency, const char *> histograms[] = {{BufferPoolLatency::HIT, "hit"},
+                                                                   {BufferPoolLatency::MISS, "miss"}};
+  for (auto [kind, name] : histograms) {
+    for (int percentile : {50, 90, 99}) {
+      write_row(fmt::format("{}_latency_p{}_ns", name, percentile),
+                fmt::format("{}", stats.LatencyPercentile(kind, percentile)));
+    }
+  }
+  writer.EndTable();
+}
+
 void BustubInstance::WriteOneCell(const std::string &cell, ResultWriter &writer) {
   writer.BeginTable(true);
   writer.BeginRow();
@@ -154,12 +251,33 @@ void BustubInstance::WriteOneCell(const std::string &cell, ResultWriter &writer)
   writer.EndTable();
 }
 
+void BustubInstance::CmdTrace(const std::string &file_name, ResultWriter &writer) {
+  if (buffer_pool_manager_ == nullptr) {
+    throw Exception("no buffer pool to trace");
+  }
+  if (access_trace_ != nullptr) {
+    buffer_pool_manager_->SetAccessTrace(nullptr);
+    WriteOneCell(fmt::format("recorded {} page accesses", access_trace_->GetNumRecords()), writer);
+    access_trace_.reset();
+  }
+  if (file_name != "off") {
+    access_trace_ = std::make_unique<PageAccessTraceWriter>(file_name);
+    buffer_pool_manager_->SetAccessTrace(access_trace_.get());
+  }
+}
+
 void BustubInstance::CmdDisplayHelp(ResultWriter &writer) {
   std::string help = R"(Welcome to the BusTub shell!
 
 \dt: show all tables
 \di: show all indices
+\dbsize: show the number of live and free pages of the database file
+\bpstats: show the buffer pool hit, miss and eviction counters and fetch latencies
+\bpstats reset: set the buffer pool statistics back to zero
+\trace <file>: record every page pin and unpin to a trace for bustub-replacer-replay
+\trace off: stop recording page accesses
 \help: show this message again
+SET buffer_pool_size = <frames>: grow or shrink the buffer pool while it is running
 
 BusTub shell currently only supports a small set of Postgres queries. We'll set
 up a doc describing the current status later. It will silently ignore some parts
@@ -191,6 +309,24 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
       CmdDisplayIndices(writer);
       return true;
     }
+    if (sql == "\\dbsize") {
+      CmdDisplayDbSize(writer);
+      return true;
+    }
+    if (sql == "\\bpstats") {
+      CmdDisplayBufferPoolStats(writer);
+      return true;
+    }
+    if (sql == "\\bpstats reset") {
+      if (buffer_pool_manager_ != nullptr) {
+        buffer_pool_manager_->ResetStats();
+      }
+      return true;
+    }
+    if (StringUtil::StartsWith(sql, "\\trace ")) {
+      CmdTrace(StringUtil::Strip(sql.substr(7), ' '), writer);
+      return true;
+    }
     if (sql == "\\help") {
       CmdDisplayHelp(writer);
       return true;
@@ -252,11 +388,18 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
       case StatementType::VARIABLE_SHOW_STATEMENT: {
         const auto &show_stmt = dynamic_cast<const VariableShowStatement &>(*statement);
         auto content = GetSessionVariable(show_stmt.variable_);
+        if (show_stmt.variable_ == "buffer_pool_size" && buffer_pool_manager_ != nullptr) {
+          content = std::to_string(buffer_pool_manager_->GetPoolSize());
+        }
         WriteOneCell(fmt::format("{}={}", show_stmt.variable_, content), writer);
         continue;
       }
       case StatementType::VARIABLE_SET_STATEMENT: {
         const auto &set_stmt = dynamic_cast<const VariableSetStatement &>(*statement);
+        if (set_stmt.variable_ == "buffer_pool_size") {
+          SetBufferPoolSize(set_stmt.value_);
+          continue;
+        }
         session_variables_[set_stmt.variable_] = set_stmt.value_;
         continue;
       }
@@ -391,6 +534,14 @@ BustubInstance::~BustubInstance() {
   if (enable_logging) {
     log_manager_->StopFlushThread();
   }
+  warmer_.reset();
+  if (access_trace_ != nullptr) {
+    buffer_pool_manager_->SetAccessTrace(nullptr);
+    access_trace_.reset();
+  }
+  if (!warm_up_file_name_.empty()) {
+    BufferPoolWarmer::SaveHotPages(buffer_pool_manager_, warm_up_file_name_);
+  }
   delete execution_engine_;
   delete catalog_;
   delete checkpoint_manager_;
@@ -30,8 +30,12 @@ void SeqScanExecutor::Init() {
   if (alaways_false_) {
     return;
   }
+  // Once a scan has gone through a quarter of the pool, it keeps to a small ring of frames so that a big table does
+  // not evict the pages everybody else is working with.
+  auto strategy =
+      std::make_shared<BufferAccessStrategy>(SCAN_RING_SIZE, exec_ctx_->GetBufferPoolManager()->GetPoolSize() / 4);
   table_itr_ = std::make_unique<TableIterator>(
-      exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid())->table_->Begin(exec_ctx_->GetTransaction()));
+      exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid())->table_->Begin(exec_ctx_->GetTransaction(), strategy));
   table_end_ = std::make_unique<TableIterator>(exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid())->table_->End());
   std::cout << "transaction id: " << exec_ctx_->GetTransaction()->GetTransactionId()
             << " table id: " << plan_->table_oid_
@@ -0,0 +1,125 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * BufferAccessStrategy keeps a large sequential scan from flushing the whole buffer pool.
+ *
+ * Pages that a scan fetches through a strategy and that miss the pool are loaded into a small private ring of frames:
+ * once the ring is full, the frame of the page loaded ring_size misses ago is recycled for the next one, instead of
+ * evicting somebody else's page. Scans of small tables are left alone, as the ring only kicks in once
+ * activation_threshold pages have been fetched through the strategy.
+ *
+ * A strategy belongs to a single scan, but the read-ahead worker may use it concurrently with the scan. With a
+ * ParallelBufferPoolManager, every instance gets its own share of the ring.
+ */
+class BufferAccessStrategy {
+ public:
+  /**
+   * @brief Create a strategy for a scan.
+   * @param ring_size the number of frames the scan may occupy once the ring is in use
+   * @param activation_threshold the number of pages the scan fetches before the ring is used
+   */
+  explicit BufferAccessStrategy(size_t ring_size, size_t activation_threshold = 0)
+      : ring_size_(ring_size), activation_threshold_(activation_threshold) {
+    BUSTUB_ASSERT(ring_size > 0, "the ring needs at least one frame");
+  }
+
+  DISALLOW_COPY_AND_MOVE(BufferAccessStrategy);
+
+  /** @return the number of frames of the ring */
+  auto GetRingSize() const -> size_t { return ring_size_; }
+
+  /**
+   * @brief Count a fetch through the strategy. Repeated fetches of the same page, e.g. one per tuple, count once.
+   * @return true if the ring is in use
+   */
+  auto CountFetch(page_id_t page_id) -> bool {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (fetched_pages_ < activation_threshold_ && page_id != last_page_id_) {
+      fetched_pages_++;
+    }
+    last_page_id_ = page_id;
+    return fetched_pages_ >= activation_threshold_;
+  }
+
+  /** @return true if the ring is in use */
+  auto IsActive() -> bool {
+    std::scoped_lock<std::mutex> lock(latch_);
+    return fetched_pages_ >= activation_threshold_;
+  }
+
+  /**
+   * @brief Return the page occupying the ring slot the next miss of a buffer pool instance goes to. Calls to
+   * NextVictim() and FillSlot() for the same instance must be serialized by the caller.
+   * @param instance_index index of the buffer pool instance
+   * @param capacity the share of the ring of that instance
+   * @return the page whose frame should be recycled, or INVALID_PAGE_ID if the ring is not full yet
+   */
+  auto NextVictim(uint32_t instance_index, size_t capacity) -> page_id_t {
+    std::scoped_lock<std::mutex> lock(latch_);
+    Ring &ring = GetRing(instance_index, capacity);
+    return ring.slots_[ring.next_];
+  }
+
+  /**
+   * @brief Record that page_id was loaded into the ring slot returned by the last NextVictim() of the instance.
+   */
+  void FillSlot(uint32_t instance_index, size_t capacity, page_id_t page_id) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    Ring &ring = GetRing(instance_index, capacity);
+    ring.slots_[ring.next_] = page_id;
+    ring.next_ = (ring.next_ + 1) % ring.slots_.size();
+  }
+
+ private:
+  /** The pages a buffer pool instance loaded for the scan, oldest at next_ once the ring is full. */
+  struct Ring {
+    std::vector<page_id_t> slots_;
+    size_t next_{0};
+  };
+
+  auto GetRing(uint32_t instance_index, size_t capacity) -> Ring & {
+    if (rings_.size() <= instance_index) {
+      rings_.resize(instance_index + 1);
+    }
+    Ring &ring = rings_[instance_index];
+    if (ring.slots_.empty()) {
+      ring.slots_.resize(capacity, INVALID_PAGE_ID);
+    }
+    return ring;
+  }
+
+  /** The number of frames of the ring. */
+  const size_t ring_size_;
+  /** The number of pages fetched before the ring is used. */
+  const size_t activation_threshold_;
+  /** Protects the members below. */
+  std::mutex latch_;
+  /** Pages fetched so far, capped at the activation threshold. */
+  size_t fetched_pages_{0};
+  /** The page fetched last. */
+  page_id_t last_page_id_{INVALID_PAGE_ID};
+  /** One ring per buffer pool instance. */
+  std::vector<Ring> rings_;
+};
+
+}  // namespace bustub
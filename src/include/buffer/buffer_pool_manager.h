@@ -13,9 +13,14 @@
 #pragma once
 
 #include <list>
+#include <memory>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/page_access_trace.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
@@ -30,6 +35,8 @@ class BufferPoolManager {
  public:
   enum class CallbackType { BEFORE, AFTER };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
+  /** Reads the id of the page that follows the given page in a scan out of its content, or INVALID_PAGE_ID. */
+  using next_page_fn = page_id_t (*)(Page *page);
 
   BufferPoolManager() = default;
   /**
@@ -45,6 +52,17 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Fetch a page on behalf of a scan that uses an access strategy. Not a grading function. Buffer pools that do not
+   * support access strategies fetch the page as usual.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the scan, or nullptr
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+    return FetchPgStrategyImp(page_id, strategy);
+  }
+
   /** Grading function. Do not modify! */
   auto UnpinPage(page_id_t page_id, bool is_dirty, bufferpool_callback_fn callback = nullptr) -> bool {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -87,6 +105,66 @@ class BufferPoolManager {
   /** @return size of the buffer pool */
   virtual auto GetPoolSize() -> size_t = 0;
 
+  /** @return the size the buffer pool can be grown to with Resize() */
+  virtual auto GetMaxPoolSize() -> size_t { return GetPoolSize(); }
+
+  /**
+   * Grow or shrink the buffer pool while it is in use. Not a grading function.
+   * @param pool_size the new number of frames
+   * @return false if the buffer pool could not be resized, e.g. because pages that would have to go are pinned; the
+   * buffer pool keeps its size then
+   */
+  virtual auto Resize(size_t pool_size) -> bool { return false; }
+
+  /**
+   * Hint that a scan is about to fetch page_id and the pages following it. Up to num_pages pages are loaded in the
+   * background, starting at page_id and following next_page from each loaded page to the next one. The pages are not
+   * pinned, and buffer pools that do not read ahead simply ignore the hint.
+   * @param page_id the first page to read ahead
+   * @param next_page extracts the id of the next page in the scan from a page
+   * @param num_pages the maximum number of pages to read ahead
+   * @param strategy the access strategy of the scan the pages are read for, or nullptr
+   */
+  virtual void ReadAhead(page_id_t page_id, next_page_fn next_page, size_t num_pages,
+                         std::shared_ptr<BufferAccessStrategy> strategy = nullptr) {}
+
+  /**
+   * Look a resident page up for an optimistic read, without pinning or latching it. Not a grading function.
+   *
+   * The caller may read the page, but must check ValidateOptimisticRead(version) on it before trusting anything it
+   * read: the frame can be evicted and reused at any time, which fails the validation.
+   * @param page_id id of the page
+   * @param[out] version the version to validate the read against
+   * @return the page, or nullptr if it is not resident, is being loaded or write-latched, or the buffer pool does not
+   * support optimistic reads. Fall back to FetchPage() then.
+   */
+  virtual auto FetchPageOptimistic(page_id_t page_id, uint64_t *version) -> Page * { return nullptr; }
+
+  /**
+   * Make sure a page is resident without keeping it pinned, e.g. to warm the pool up. Not a grading function.
+   * @param page_id the page to load
+   * @return false if the page could not be loaded or the buffer pool does not support prefetching
+   */
+  virtual auto PrefetchPage(page_id_t page_id) -> bool { return false; }
+
+  /**
+   * @return the ids of the resident pages, the ones the replacer would keep longest first, or an empty list if the
+   * buffer pool does not track that
+   */
+  virtual auto GetHotPages() -> std::vector<page_id_t> { return {}; }
+
+  /** @return the statistics the buffer pool collected so far, all zero if it does not collect any */
+  virtual auto GetStats() -> BufferPoolStatsSnapshot { return {}; }
+
+  /** Set the statistics of the buffer pool back to zero. */
+  virtual void ResetStats() {}
+
+  /**
+   * Record the pins and unpins of the buffer pool to trace, or stop recording if trace is nullptr. Not a grading
+   * function.
+   */
+  virtual void SetAccessTrace(PageAccessTraceWriter *trace) {}
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -108,6 +186,16 @@ class BufferPoolManager {
    */
   virtual auto FetchPgImp(page_id_t page_id) -> Page * = 0;
 
+  /**
+   * Fetch the requested page from the buffer pool, loading it into the ring of the access strategy on a miss.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, or nullptr
+   * @return the requested page
+   */
+  virtual auto FetchPgStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+    return FetchPgImp(page_id);
+  }
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -12,14 +12,24 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
 #include <list>
+#include <memory>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/concurrent_clock_replacer.h"
+#include "buffer/frequency_sketch.h"
 #include "buffer/lru_k_replacer.h"
+#include "buffer/page_access_trace.h"
+#include "buffer/page_table.h"
+#include "buffer/read_ahead_worker.h"
 #include "common/config.h"
-#include "container/hash/extendible_hash_table.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -37,9 +47,28 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param disk_manager the disk manager
    * @param replacer_k the lookback constant k for the LRU-K replacer
    * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param max_pool_size the number of frames Resize() can grow the pool to, 0 to make it pool_size
+   * @param replacer_type the replacement policy; replacer_k only matters for LRU-K
    */
   BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, size_t max_pool_size = 0,
+                            ReplacerType replacer_type = ReplacerType::LRU_K);
+
+  /**
+   * @brief Creates a new BufferPoolManagerInstance that is one shard of a ParallelBufferPoolManager.
+   * @param pool_size the size of the buffer pool
+   * @param num_instances total number of BPIs in parallel BPM
+   * @param instance_index index of this BPI in the parallel BPM
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer
+   * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param max_pool_size the number of frames Resize() can grow the pool to, 0 to make it pool_size
+   * @param replacer_type the replacement policy; replacer_k only matters for LRU-K
+   */
+  BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                            DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
+                            LogManager *log_manager = nullptr, size_t max_pool_size = 0,
+                            ReplacerType replacer_type = ReplacerType::LRU_K);
 
   /**
    * @brief Destroy an existing BufferPoolManagerInstance.
@@ -49,9 +78,109 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @brief Return the size (number of frames) of the buffer pool. */
   auto GetPoolSize() -> size_t override { return pool_size_; }
 
+  /** @brief Return the number of frames the pool can grow to. */
+  auto GetMaxPoolSize() -> size_t override { return max_pool_size_; }
+
+  /**
+   * @brief Grow or shrink the pool while it is in use.
+   *
+   * Growing hands frames [old size, pool_size) to the free list. Shrinking retires frames [pool_size, old size): their
+   * pages are written back if dirty and dropped, and the memory of their data is returned to the operating system.
+   * The frames are only retired if none of them is pinned or in the middle of I/O; the pool is left alone otherwise.
+   * @param pool_size the new number of frames, between 1 and GetMaxPoolSize()
+   * @return false if the size is out of range or a frame to retire is in use
+   */
+  auto Resize(size_t pool_size) -> bool override;
+
   /** @brief Return the pointer to all the pages in the buffer pool. */
   auto GetPages() -> Page * { return pages_; }
 
+  /**
+   * @brief Record every successful pin and unpin to trace from now on, or stop recording if trace is nullptr. The
+   * trace must outlive the requests in flight when it is detached.
+   */
+  void SetAccessTrace(PageAccessTraceWriter *trace) override { access_trace_ = trace; }
+
+  /**
+   * @brief Start a background thread that writes dirty pages back before they are picked for eviction, so that the
+   * foreground rarely has to wait for a write-back. Whenever fewer than low_watermark of the frames are clean (free,
+   * or unpinned and not dirty), it writes unpinned dirty pages in page id order until high_watermark of them are.
+   * @param low_watermark fraction of clean frames under which the flusher starts writing
+   * @param high_watermark fraction of clean frames at which the flusher stops writing
+   */
+  void StartBackgroundFlusher(double low_watermark = BACKGROUND_FLUSH_LOW_WATERMARK,
+                              double high_watermark = BACKGROUND_FLUSH_HIGH_WATERMARK);
+
+  /** @brief Stop and join the background flusher, if it is running. */
+  void StopBackgroundFlusher();
+
+  /**
+   * @brief Put a TinyLFU admission filter in front of the replacer, so that one-off accesses stop evicting hot pages.
+   *
+   * Every fetch is counted in a FrequencySketch. When a fetch misses and no frame is free, the page only displaces the
+   * replacer's victim if it has been accessed more often recently. Otherwise it is loaded into a small admission
+   * window instead: a ring of window_size frames that the rejected pages recycle, like the ring of a
+   * BufferAccessStrategy. Call this before the buffer pool is shared between threads.
+   * @param window_size the number of frames the rejected pages of this instance may occupy
+   */
+  void EnableAdmissionFilter(size_t window_size = ADMISSION_WINDOW_SIZE);
+
+  /** @return the number of pages the background flusher has written back */
+  auto GetFlushedPageCount() const -> uint64_t { return flushed_pages_; }
+
+  /** @return the number of dirty pages that were evicted and had to be written back by the foreground */
+  auto GetEvictedDirtyPageCount() const -> uint64_t {
+    return stats_.Snapshot().Get(BufferPoolCounter::DIRTY_WRITE_BACK);
+  }
+
+  /** @brief Look a resident page up for an optimistic read. See BufferPoolManager::FetchPageOptimistic(). */
+  auto FetchPageOptimistic(page_id_t page_id, uint64_t *version) -> Page * override;
+
+  /** @return the hit, miss and eviction counters and the fetch latencies of this instance */
+  auto GetStats() -> BufferPoolStatsSnapshot override { return stats_.Snapshot(); }
+
+  /** @brief Set the statistics of this instance back to zero. */
+  void ResetStats() override { stats_.Reset(); }
+
+  /**
+   * @brief Read pages ahead on a background thread. At most an eighth of the pool is read ahead per hint, so that
+   * read-ahead cannot flush the pool.
+   */
+  void ReadAhead(page_id_t page_id, next_page_fn next_page, size_t num_pages,
+                 std::shared_ptr<BufferAccessStrategy> strategy = nullptr) override;
+
+  /**
+   * @brief Make sure a page is resident without keeping it pinned. A page that is already resident is left alone and
+   * does not count as accessed.
+   * @param page_id the page to load
+   * @param next_page extracts the id of the page following page_id in a scan
+   * @param strategy if not nullptr and in use, a missing page is loaded into its ring
+   * @return the id of the page following page_id, or INVALID_PAGE_ID if page_id could not be loaded
+   */
+  auto PrefetchPage(page_id_t page_id, next_page_fn next_page, BufferAccessStrategy *strategy = nullptr)
+      -> page_id_t;
+
+  /** @brief Make sure a page is resident without keeping it pinned. See BufferPoolManager::PrefetchPage(). */
+  auto PrefetchPage(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Create a new page like NewPage(), but without counting a pin failure when every frame is pinned, for a
+   * caller that tries other instances before giving up.
+   */
+  auto TryNewPage(page_id_t *page_id) -> Page *;
+
+  /** @brief Count a pin failure, for a NewPage() that failed on every instance. */
+  void CountPinFailure() { stats_.Add(BufferPoolCounter::PIN_FAILURE); }
+
+  /**
+   * @brief Write out every dirty page like FlushAllPages(), but without syncing the disk manager, for a caller that
+   * flushes several instances sharing it and syncs once at the end.
+   */
+  void FlushDirtyPages();
+
+  /** @return the ids of the resident pages in the reverse of the LRU-K eviction order */
+  auto GetHotPages() -> std::vector<page_id_t> override;
+
  protected:
   /**
    * TODO(P1): Add implementation
@@ -90,6 +219,16 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto FetchPgImp(page_id_t page_id) -> Page * override;
 
+  /**
+   * @brief Fetch the requested page like FetchPgImp(). Once the access strategy is in use, a miss recycles the frame
+   * of the page the strategy loaded a ring ago, when that frame is unpinned and clean, instead of evicting a page of
+   * somebody else.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, or nullptr
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -140,44 +279,239 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto DeletePgImp(page_id_t page_id) -> bool override;
 
-  /** Number of pages in the buffer pool. */
-  const size_t pool_size_;
+  /** Number of pages in the buffer pool. Only changed by Resize(), with the latch held. */
+  std::atomic<size_t> pool_size_;
+  /** Number of frames the pool can grow to. Everything indexed by frame id is sized for this many frames. */
+  const size_t max_pool_size_;
+  /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
+  const uint32_t num_instances_ = 1;
+  /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
+  const uint32_t instance_index_ = 0;
   /** The next page id to be allocated  */
-  std::atomic<page_id_t> next_page_id_ = 0;
-  /** Bucket size for the extendible hash table */
-  const size_t bucket_size_ = 4;
+  std::atomic<page_id_t> next_page_id_;
 
-  /** Array of buffer pool pages. */
+  /**
+   * Metadata of the buffer pool pages, max_pool_size_ of them, one or two cache lines each. Frames at or past pool_size_
+   * are retired: claimed forever.
+   */
   Page *pages_;
+  /**
+   * The data of the frames, one BUSTUB_PAGE_SIZE slot per frame. Address space for max_pool_size_ frames is reserved
+   * up front, but memory is only used by the frames that have been touched and are not retired. Large arenas are
+   * aligned to and backed by huge pages where the system allows it.
+   */
+  char *frame_data_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. Please ignore this for P1. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  ExtendibleHashTable<page_id_t, frame_id_t> *page_table_;
+  /** Page table for keeping track of buffer pool pages. Read without the latch on the hit path. */
+  PageTable *page_table_;
   /** Replacer to find unpinned pages for replacement. */
-  LRUKReplacer *replacer_;
+  FrameReplacer *replacer_;
   /** List of free frames that don't have any pages on them. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /**
+   * This latch serializes the writers of the page table, the free list, the page id of the frames and the I/O state
+   * below. It is never held across a disk read or write.
+   *
+   * Fetching a resident page and unpinning it take no latch at all: the page table is read lock-free and the pin
+   * count is bumped with a compare-and-swap. The pin count is therefore the authority on whether a frame may be
+   * recycled. Before giving a frame to another page, the latch holder claims it by swapping its pin count from 0 to
+   * -1, which fails if anybody pinned it in the meantime. The evictable flags of the replacer are only a hint that
+   * may briefly lag behind the pin count.
+   */
   std::mutex latch_;
 
+  /** The disk I/O a frame is currently undergoing. */
+  enum class FrameIOState : uint8_t {
+    /** The frame content is valid. */
+    NONE,
+    /** The previous (dirty) page of the frame is being written back. */
+    WRITING_BACK,
+    /** The page is being read from disk into the frame. */
+    LOADING
+  };
+
+  /**
+   * I/O state of every frame. A frame whose state is not NONE is pinned by the thread doing the I/O. Only changed
+   * with the latch held, but read without it on the hit path.
+   */
+  std::unique_ptr<std::atomic<FrameIOState>[]> frame_io_;
+  /** Signalled whenever the I/O state of the corresponding frame changes. Waited on with latch_ held. */
+  std::unique_ptr<std::condition_variable[]> frame_io_cv_;
+  /**
+   * Pages that have already been evicted from the page table but whose write-back to disk is still in flight,
+   * mapped to the frame doing the write. Fetching such a page must wait for that frame, or it would read stale data.
+   */
+  std::unordered_map<page_id_t, frame_id_t> writing_back_;
+
+  /** The background flusher thread, nullptr if it is not running. */
+  std::thread *flusher_thread_{nullptr};
+  /** True while the background flusher should keep running. */
+  std::atomic<bool> enable_flusher_{false};
+  /** Set by the foreground to wake the flusher up before its interval is over. Protected by flusher_latch_. */
+  bool flusher_wakeup_{false};
+  /** Protects flusher_wakeup_. */
+  std::mutex flusher_latch_;
+  /** Signalled to wake the flusher up. */
+  std::condition_variable flusher_cv_;
+  /** The flusher starts writing when fewer than this fraction of the frames are clean. */
+  double flush_low_watermark_{0};
+  /** The flusher stops writing when at least this fraction of the frames are clean. */
+  double flush_high_watermark_{0};
+  /** The flusher resumes its sweep after this page id, so that it cycles through the dirty pages in page id order. */
+  page_id_t flush_cursor_{INVALID_PAGE_ID};
+  /** Number of pages written back by the background flusher. */
+  std::atomic<uint64_t> flushed_pages_{0};
+  /** Fetch, hit, miss and eviction counters and fetch latencies. */
+  BufferPoolStats stats_;
+  /** Serves the read-ahead hints. */
+  std::unique_ptr<ReadAheadWorker> read_ahead_;
+  /** Where pins and unpins are recorded, nullptr if they are not. */
+  std::atomic<PageAccessTraceWriter *> access_trace_{nullptr};
+  /** Recent access frequencies of the pages, if the admission filter is enabled. */
+  std::unique_ptr<FrequencySketch> frequency_sketch_;
+  /** The ring the pages turned away by the admission filter are loaded into. */
+  std::unique_ptr<BufferAccessStrategy> admission_window_;
+
+  /** @brief Record a pin or unpin to the access trace, if there is one. */
+  void TraceAccess(page_id_t page_id, PageAccessType type, bool is_dirty);
+
+  /** @brief Count a fetch as a hit or a miss and record its latency, measured from start. */
+  void RecordFetch(BufferPoolLatency kind, std::chrono::steady_clock::time_point start);
+
   /**
-   * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief Allocate a page on disk for a new page, reusing a deallocated page if it is not resident any more or can be
+   * dropped from the pool. Caller should acquire the latch before calling this function.
+   * @param reused the deallocated page DiskManager::ReuseFreePage() returned, or INVALID_PAGE_ID
+   * @param frame_id the frame claimed for the new page
    * @return the id of the allocated page
    */
-  auto AllocatePage() -> page_id_t;
+  auto AllocatePage(page_id_t reused, frame_id_t frame_id) -> page_id_t;
+
+  /**
+   * @brief Drop the frame still holding a deallocated page, if any, so that the page can be handed out again. Caller
+   * should acquire the latch before calling this function.
+   * @param page_id the deallocated page
+   * @param frame_id the frame claimed for the new page, which may be the one holding page_id
+   * @return false if the page is pinned or being written back, and cannot be reused yet
+   */
+  auto DropStalePage(page_id_t page_id, frame_id_t frame_id) -> bool;
+
+  /**
+   * @brief Unmap the page of a claimed frame without writing it back, and put the frame on the free list. Caller should
+   * acquire the latch before calling this function.
+   */
+  void DiscardFrame(frame_id_t frame_id);
+
+  /**
+   * @brief Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
+   * validate input data and ensure that a parallel BPM is routing requests to the correct BPI.
+   * @param page_id id of the page to validate
+   */
+  void ValidatePageId(page_id_t page_id) const;
 
   /**
-   * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief Deallocate a page on disk, so that AllocatePage() can hand it out again. Caller should acquire the latch
+   * before calling this function.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id);
+
+  /**
+   * @brief Pick a frame to hold a new page, from the free list first and from the replacer otherwise, and claim it.
+   * Caller should acquire the latch before calling this function.
+   * @param[out] frame_id the frame that was picked
+   * @return false if all frames are pinned
+   */
+  auto AcquireFrame(frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Map page_id onto the given (claimed) frame and pin it. If the frame still holds a dirty page, it is written
+   * back first; if load is true, the page content is then read from disk, otherwise it is zeroed. The latch is
+   * released while the disk is accessed, and other threads asking for either page wait on the frame meanwhile.
+   * @param lock the caller's hold on latch_, held again when this function returns
+   * @param page_id the page to place in the frame
+   * @param frame_id the frame returned by AcquireFrame()
+   * @param load whether to read the page content from disk
+   * @return the pinned page
+   */
+  auto InstallPage(std::unique_lock<std::mutex> *lock, page_id_t page_id, frame_id_t frame_id, bool load) -> Page *;
+
+  /**
+   * @brief Claim an unpinned frame so that nobody can pin it until it is handed over to its next page. Caller should
+   * acquire the latch before calling this function.
+   * @return false if the frame is pinned
+   */
+  auto ClaimFrame(frame_id_t frame_id) -> bool;
 
-  // TODO(student): You may add additional private members and helper functions
-  void ResetPage(page_id_t page, frame_id_t frame);
-  auto ReallocatePage(page_id_t *page, bool has_id = false) -> Page *;
+  /**
+   * @brief Pick and claim a frame for page_id from the ring of an access strategy, falling back to AcquireFrame()
+   * while the ring is not full or its next frame is busy. Caller should acquire the latch before calling this
+   * function.
+   * @param[out] frame_id the frame that was picked
+   * @return false if all frames are pinned
+   */
+  auto AcquireRingFrame(page_id_t page_id, BufferAccessStrategy *strategy, frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Ask the admission filter whether page_id may displace the page the replacer would evict next. Caller
+   * should acquire the latch before calling this function.
+   * @return true if the page is estimated to be accessed more often than the victim, or there is no victim
+   */
+  auto AdmitPage(page_id_t page_id) -> bool;
+
+  /**
+   * @brief Pin a page, loading it from disk if it is not resident, without counting the access anywhere but in the
+   * replacer. The body of FetchPgStrategyImp(), which does the counting, and of read-ahead, which does not.
+   * @param page_id the page to pin
+   * @param ring the access strategy whose ring a miss goes to, or nullptr to take a frame from the pool
+   * @param[out] hit whether the page was resident
+   * @return the pinned page, or nullptr if all frames are pinned
+   */
+  auto PinPage(page_id_t page_id, BufferAccessStrategy *ring, bool *hit) -> Page *;
+
+  /**
+   * @brief Pin the frame a lock-free page table lookup returned for page_id, without taking the latch.
+   * @return false if the frame is being claimed or no longer holds page_id, in which case it is left unpinned
+   */
+  auto TryPin(page_id_t page_id, frame_id_t frame_id) -> bool;
+
+  /**
+   * @brief Drop one pin of a frame, marking the page dirty first if asked to, and make the frame evictable when the
+   * last pin goes away. Does not need the latch.
+   * @return false if the frame was not pinned
+   */
+  auto UnpinFrame(frame_id_t frame_id, bool is_dirty) -> bool;
+
+  /** @brief Body of the background flusher thread. */
+  void RunBackgroundFlusher();
+
+  /** @brief Wake the background flusher up, if it is running. */
+  void WakeBackgroundFlusher();
+
+  /**
+   * @brief Count the frames that can be reused without a write-back. Reads the frame metadata without the latch, so
+   * the result is approximate.
+   */
+  auto CountCleanFrames() -> size_t;
+
+  /**
+   * @brief Write back up to max_pages unpinned dirty pages, continuing the page id ordered sweep from flush_cursor_.
+   * Called by the flusher thread without holding the latch.
+   */
+  void FlushSomeDirtyPages(size_t max_pages);
+
+  /**
+   * @brief Block until the given frame has no disk I/O in flight. Caller should hold the latch through lock.
+   */
+  void WaitForIO(std::unique_lock<std::mutex> *lock, frame_id_t frame_id);
+
+  /**
+   * @brief Change the I/O state of a frame and wake up whoever is waiting on it. Caller should acquire the latch
+   * before calling this function.
+   */
+  void SetFrameIO(frame_id_t frame_id, FrameIOState state);
 };
 }  // namespace bustub
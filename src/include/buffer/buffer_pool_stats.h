@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** The events BufferPoolStats counts. */
+enum class BufferPoolCounter {
+  /** FetchPage calls. */
+  FETCH = 0,
+  /** Fetches of a page that was already resident. */
+  HIT,
+  /** Fetches that had to read the page from disk. */
+  MISS,
+  /** Frames taken away from a resident page to hold another one. */
+  EVICTION,
+  /** Evictions that had to write the victim back first. */
+  DIRTY_WRITE_BACK,
+  /** FetchPage and NewPage calls that returned nullptr because every frame was pinned. */
+  PIN_FAILURE,
+  /** Misses the admission filter loaded into its window instead of evicting the replacer's victim. */
+  ADMISSION_REJECTION,
+  NUM_COUNTERS
+};
+
+/** The FetchPage latency histograms BufferPoolStats keeps. */
+enum class BufferPoolLatency { HIT = 0, MISS, NUM_HISTOGRAMS };
+
+/**
+ * A point-in-time copy of the statistics of one or more buffer pools. Snapshots of several pools can be added up.
+ */
+struct BufferPoolStatsSnapshot {
+  /** Latencies fall into bucket i if they are in [2^i, 2^(i+1)) nanoseconds, the first bucket also takes 0. */
+  static constexpr size_t NUM_BUCKETS = 40;
+
+  std::array<uint64_t, static_cast<size_t>(BufferPoolCounter::NUM_COUNTERS)> counters_{};
+  std::array<std::array<uint64_t, NUM_BUCKETS>, static_cast<size_t>(BufferPoolLatency::NUM_HISTOGRAMS)> histograms_{};
+
+  /** @return the value of a counter */
+  auto Get(BufferPoolCounter counter) const -> uint64_t { return counters_[static_cast<size_t>(counter)]; }
+
+  /** @return the fraction of the fetches that were hits, 0 if there were no fetches */
+  auto HitRatio() const -> double;
+
+  /**
+   * @return an upper bound of the given percentile of a latency histogram in nanoseconds, precise to a factor of two,
+   * or 0 if the histogram is empty
+   */
+  auto LatencyPercentile(BufferPoolLatency histogram, double percentile) const -> uint64_t;
+
+  /** @brief Add the statistics of another snapshot to this one. */
+  auto operator+=(const BufferPoolStatsSnapshot &other) -> BufferPoolStatsSnapshot &;
+};
+
+/**
+ * BufferPoolStats counts what a buffer pool does, cheaply enough to stay on in production.
+ *
+ * Every counter and histogram bucket is sharded over cache-line sized slots. A thread updates the shard of the CPU it
+ * runs on with a relaxed atomic add, so threads on different cores do not bounce cache lines between each other.
+ * Snapshot() adds the shards up. It does not stop updates, so a snapshot taken under load is not an exact cut.
+ */
+class BufferPoolStats {
+ public:
+  BufferPoolStats() = default;
+
+  /** @brief Count an event. */
+  inline void Add(BufferPoolCounter counter, uint64_t value = 1) {
+    LocalShard().counters_[static_cast<size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+  }
+
+  /** @brief Record a FetchPage latency. */
+  void RecordLatency(BufferPoolLatency histogram, std::chrono::nanoseconds latency);
+
+  /** @return the sum of all the shards */
+  auto Snapshot() const -> BufferPoolStatsSnapshot;
+
+  /** @brief Set every counter and histogram back to zero. */
+  void Reset();
+
+ private:
+  static constexpr size_t NUM_SHARDS = 16;
+
+  struct alignas(CACHE_LINE_SIZE) Shard {
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(BufferPoolCounter::NUM_COUNTERS)> counters_{};
+    std::array<std::array<std::atomic<uint64_t>, BufferPoolStatsSnapshot::NUM_BUCKETS>,
+               static_cast<size_t>(BufferPoolLatency::NUM_HISTOGRAMS)>
+        histograms_{};
+  };
+
+  /** @return the shard of the CPU the calling thread runs on */
+  auto LocalShard() -> Shard &;
+
+  std::array<Shard, NUM_SHARDS> shards_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_warmer.h
+//
+// Identification: src/include/buffer/buffer_pool_warmer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * BufferPoolWarmer brings a buffer pool back to the working set it had before a restart.
+ *
+ * On a clean shutdown, SaveHotPages() dumps the ids of the resident pages to a sidecar file, in the order the
+ * replacer would keep them. On startup, LoadHotPages() reads them back and a BufferPoolWarmer prefetches them on a
+ * background thread, so that the first queries find their pages resident instead of paying a miss each.
+ *
+ * Only the hottest pages that fit into the pool are prefetched, and they are read in page id order, which turns the
+ * warm-up into a mostly sequential scan of the database file.
+ */
+class BufferPoolWarmer {
+ public:
+  /**
+   * @brief Write the hot pages of a buffer pool to a file, replacing it atomically.
+   * @param bpm the buffer pool
+   * @param file_name the sidecar file
+   * @return false if the file could not be written
+   */
+  static auto SaveHotPages(BufferPoolManager *bpm, const std::string &file_name) -> bool;
+
+  /**
+   * @brief Read the hot pages saved by SaveHotPages().
+   * @param file_name the sidecar file
+   * @param num_pages the number of pages of the database file; ids at or past it are dropped
+   * @return the page ids, hottest first, or an empty list if the file does not exist or is corrupt
+   */
+  static auto LoadHotPages(const std::string &file_name, page_id_t num_pages) -> std::vector<page_id_t>;
+
+  /**
+   * @brief Start prefetching pages into a buffer pool on a background thread.
+   * @param bpm the buffer pool to warm up
+   * @param hot_pages the pages to prefetch, hottest first
+   */
+  BufferPoolWarmer(BufferPoolManager *bpm, std::vector<page_id_t> hot_pages);
+
+  DISALLOW_COPY_AND_MOVE(BufferPoolWarmer);
+
+  /** @brief Stop the warm-up if it is still running, and join the thread. */
+  ~BufferPoolWarmer();
+
+  /** @brief Wait until every page has been prefetched. */
+  void Wait();
+
+  /** @return the number of pages prefetched so far */
+  auto GetNumPrefetched() const -> size_t { return num_prefetched_.load(); }
+
+ private:
+  /** Header of the sidecar file. */
+  struct FileHeader {
+    uint32_t magic_;
+    uint32_t num_pages_;
+  };
+  static constexpr uint32_t MAGIC = 0x5741524d;  // "WARM"
+
+  /** Body of the warm-up thread. */
+  void Run();
+
+  BufferPoolManager *bpm_;
+  /** The pages to prefetch, in page id order. */
+  std::vector<page_id_t> pages_;
+  std::atomic<size_t> num_prefetched_{0};
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+};
+
+}  // namespace bustub
@@ -46,7 +46,17 @@ class ClockReplacer : public Replacer {
   auto Size() -> size_t override;
 
  private:
-  // TODO(student): implement me!
+  /** Maximum number of frames the replacer tracks. */
+  size_t num_pages_;
+  /** Whether each frame is in the clock, i.e. unpinned. */
+  std::vector<bool> in_clock_;
+  /** Reference bit of each frame, set when it is unpinned and cleared when the hand sweeps past it. */
+  std::vector<bool> ref_;
+  /** Position of the clock hand. */
+  size_t hand_{0};
+  /** Number of frames in the clock. */
+  size_t size_{0};
+  std::mutex latch_;
 };
 
 }  // namespace bustub
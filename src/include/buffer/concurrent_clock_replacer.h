@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// concurrent_clock_replacer.h
+//
+// Identification: src/include/buffer/concurrent_clock_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/frame_replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ConcurrentClockReplacer implements the CLOCK policy for BufferPoolManagerInstance without a lock on the hit path.
+ *
+ * Every frame has one atomic byte of state: whether it is tracked, whether it is evictable and its reference bit.
+ * RecordAccess() sets the reference bit, and SetEvictable() flips the evictable bit; both are a plain load when the
+ * bit already has the right value, which is the common case for a hot page, and a single compare-and-swap otherwise.
+ * Only Evict() and PeekVictim() take a latch, to move the clock hand: the hand sweeps over the frames, clearing the
+ * reference bits of evictable frames and evicting the first evictable frame whose bit is already clear.
+ */
+class ConcurrentClockReplacer : public FrameReplacer {
+ public:
+  /**
+   * @brief Create a new ConcurrentClockReplacer.
+   * @param num_frames the maximum number of frames the replacer will be required to store
+   */
+  explicit ConcurrentClockReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(ConcurrentClockReplacer);
+
+  ~ConcurrentClockReplacer() override = default;
+
+  /**
+   * @brief Evict the first evictable frame after the hand whose reference bit is clear, clearing the reference bits
+   * of the evictable frames the hand passes on the way.
+   */
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  auto PeekVictim(frame_id_t *frame_id) -> bool override;
+
+  /** @brief Set the reference bit of the frame. Lock-free. */
+  void RecordAccess(frame_id_t frame_id) override;
+
+  /** @brief Mark a tracked frame evictable or not. Lock-free. */
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  /**
+   * @brief List the tracked frames, hottest first: the referenced ones before the others, and within each group, the
+   * ones the hand reaches last first.
+   */
+  auto GetHotFrames() -> std::vector<frame_id_t> override;
+
+ private:
+  static constexpr uint8_t TRACKED = 1;
+  static constexpr uint8_t EVICTABLE = 2;
+  static constexpr uint8_t REFERENCED = 4;
+
+  const size_t num_frames_;
+  /** TRACKED, EVICTABLE and REFERENCED bits of every frame, indexed by frame id. */
+  std::unique_ptr<std::atomic<uint8_t>[]> states_;
+  /** Number of evictable frames. Signed, as the eviction of a frame may be counted before it was made evictable. */
+  std::atomic<int64_t> size_{0};
+  /** Protects the hand. */
+  std::mutex hand_latch_;
+  /** The frame the hand looks at next. */
+  size_t hand_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_replacer.h
+//
+// Identification: src/include/buffer/frame_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** The replacement policies BufferPoolManagerInstance can be built with. */
+enum class ReplacerType {
+  /** LRUKReplacer: evicts the frame with the largest backward k-distance. */
+  LRU_K = 0,
+  /** ConcurrentClockReplacer: CLOCK with atomic reference bits, no lock on a hit. */
+  CLOCK,
+};
+
+/**
+ * FrameReplacer is the interface BufferPoolManagerInstance drives its replacement policy through.
+ *
+ * A frame becomes tracked when it is first accessed, and only tracked frames that are marked evictable are candidates
+ * for eviction. Evicting or removing a frame forgets it until its next access.
+ */
+class FrameReplacer {
+ public:
+  FrameReplacer() = default;
+  virtual ~FrameReplacer() = default;
+
+  /**
+   * @brief Pick an evictable frame according to the policy and forget it.
+   * @param[out] frame_id id of the evicted frame
+   * @return false if no frame can be evicted
+   */
+  virtual auto Evict(frame_id_t *frame_id) -> bool = 0;
+
+  /**
+   * @brief Find the frame Evict() would evict next, without evicting it.
+   * @param[out] frame_id id of that frame
+   * @return false if no frame can be evicted
+   */
+  virtual auto PeekVictim(frame_id_t *frame_id) -> bool = 0;
+
+  /** @brief Record that a frame was accessed, starting to track it if it is not tracked yet. */
+  virtual void RecordAccess(frame_id_t frame_id) = 0;
+
+  /** @brief Mark a tracked frame evictable or not. Does nothing for frames that are not tracked. */
+  virtual void SetEvictable(frame_id_t frame_id, bool set_evictable) = 0;
+
+  /** @brief Forget an evictable frame, whatever the policy thinks of it. Does nothing if it is not tracked. */
+  virtual void Remove(frame_id_t frame_id) = 0;
+
+  /** @return the number of evictable frames */
+  virtual auto Size() -> size_t = 0;
+
+  /** @return every tracked frame, evictable or not, in the reverse of the order the policy would evict them */
+  virtual auto GetHotFrames() -> std::vector<frame_id_t> = 0;
+};
+
+}  // namespace bustub
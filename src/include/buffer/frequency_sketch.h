@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frequency_sketch.h
+//
+// Identification: src/include/buffer/frequency_sketch.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FrequencySketch estimates how often each page has been accessed recently, in constant space (the TinyLFU sketch).
+ *
+ * It is a count-min sketch: every page maps to one small saturating counter in each of DEPTH rows, and its estimate is
+ * the smallest of them. Collisions can only make an estimate too high. Once sample_size accesses have been counted,
+ * every counter is halved, so that pages that were hot a while ago do not stay hot forever.
+ *
+ * All the methods are thread-safe and lock-free, except for the aging, which the thread that completes a sample does.
+ */
+class FrequencySketch {
+ public:
+  /** Number of rows, i.e. of counters per page. */
+  static constexpr size_t DEPTH = 4;
+  /** Counters saturate at this value. */
+  static constexpr uint8_t MAX_COUNT = 15;
+
+  /**
+   * @brief Create a sketch sized for a cache of the given number of pages.
+   * @param capacity the number of pages the cache holds; the counters are halved every 10 * capacity accesses
+   */
+  explicit FrequencySketch(size_t capacity);
+
+  DISALLOW_COPY_AND_MOVE(FrequencySketch);
+
+  /** @brief Count an access to page_id, halving every counter if that completes a sample. */
+  void Increment(page_id_t page_id);
+
+  /** @return the estimated number of recent accesses to page_id, at most MAX_COUNT */
+  auto Estimate(page_id_t page_id) const -> uint32_t;
+
+  /** @return the number of accesses counted since the counters were last halved */
+  auto GetSampleCount() const -> size_t { return additions_; }
+
+ private:
+  /** @return the index of the counter of page_id in the given row */
+  auto IndexOf(page_id_t page_id, size_t row) const -> size_t;
+
+  /** Halve every counter. */
+  void Age();
+
+  /** Number of counters per row, a power of two. */
+  const size_t width_;
+  /** Number of accesses after which the counters are halved. */
+  const size_t sample_size_;
+  /** DEPTH rows of width_ counters each. */
+  std::unique_ptr<std::atomic<uint8_t>[]> counters_;
+  /** Accesses counted since the last aging. */
+  std::atomic<size_t> additions_{0};
+  /** Held by the thread that ages the counters, so that only one does. */
+  std::mutex aging_latch_;
+};
+
+}  // namespace bustub
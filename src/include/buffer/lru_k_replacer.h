@@ -16,9 +16,12 @@
 #include <list>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <set>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "buffer/frame_replacer.h"
 #include "common/config.h"
 #include "common/macros.h"
 
@@ -34,8 +37,11 @@ namespace bustub {
  * A frame with less than k historical references is given
  * +inf as its backward k-distance. When multiple frames have +inf backward k-distance,
  * classical LRU algorithm is used to choose victim.
+ *
+ * Evictable frames are kept in ordered sets keyed by the oldest timestamp of their history,
+ * so every operation runs in O(log n).
  */
-class LRUKReplacer {
+class LRUKReplacer : public FrameReplacer {
  public:
   /**
    *
@@ -53,7 +59,7 @@ class LRUKReplacer {
    *
    * @brief Destroys the LRUReplacer.
    */
-  ~LRUKReplacer() = default;
+  ~LRUKReplacer() override = default;
 
   /**
    * TODO(P1): Add implementation
@@ -71,7 +77,14 @@ class LRUKReplacer {
    * @param[out] frame_id id of frame that is evicted.
    * @return true if a frame is evicted successfully, false if no frames can be evicted.
    */
-  auto Evict(frame_id_t *frame_id) -> bool;
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  /**
+   * @brief Find the frame Evict() would evict next, without evicting it.
+   * @param[out] frame_id id of that frame
+   * @return false if no frame can be evicted
+   */
+  auto PeekVictim(frame_id_t *frame_id) -> bool override;
 
   /**
    * TODO(P1): Add implementation
@@ -84,7 +97,7 @@ class LRUKReplacer {
    *
    * @param frame_id id of frame that received a new access.
    */
-  void RecordAccess(frame_id_t frame_id);
+  void RecordAccess(frame_id_t frame_id) override;
 
   /**
    * TODO(P1): Add implementation
@@ -103,7 +116,7 @@ class LRUKReplacer {
    * @param frame_id id of frame whose 'evictable' status will be modified
    * @param set_evictable whether the given frame is evictable or not
    */
-  void SetEvictable(frame_id_t frame_id, bool set_evictable);
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
 
   /**
    * TODO(P1): Add implementation
@@ -122,7 +135,7 @@ class LRUKReplacer {
    *
    * @param frame_id id of frame to be removed
    */
-  void Remove(frame_id_t frame_id);
+  void Remove(frame_id_t frame_id) override;
 
   /**
    * TODO(P1): Add implementation
@@ -131,39 +144,78 @@ class LRUKReplacer {
    *
    * @return size_t
    */
-  auto Size() -> size_t;
+  auto Size() -> size_t override;
+
+  /**
+   * @brief List every frame with access history, evictable or not, in the reverse of the eviction order: frames with
+   * k accesses come first, by increasing backward k-distance, followed by the frames with fewer accesses.
+   * @return the tracked frames, hottest first
+   */
+  auto GetHotFrames() -> std::vector<frame_id_t> override;
 
+  /**
+   * FrameInfo keeps the access history of one frame: the timestamps of its last k accesses, kept in a ring so that
+   * recording an access never shifts or allocates.
+   */
   class FrameInfo {
    public:
-    explicit FrameInfo(frame_id_t frame_id);
+    /** @brief Record an access at the given timestamp, forgetting the oldest one if k accesses are already kept. */
+    void RecordAccess(size_t timestamp, size_t k);
 
-    inline auto IsEvictable() -> bool { return evictable_; };
+    /** @brief Forget the whole access history. */
+    void Reset();
 
-    inline auto SetEvictable(const bool is_evictable) -> void { evictable_ = is_evictable; };
+    /**
+     * @return the timestamp of the k-th most recent access if the frame has been accessed at least k times, otherwise
+     * the timestamp of its earliest access. Either way, this is the oldest timestamp kept in the history.
+     */
+    inline auto GetOldestAccess() const -> size_t { return history_[head_]; }
 
-    inline auto IncreaseTimes() -> void { times_ += 1; };
+    /** @return true if the frame has been accessed at least k times, i.e. its backward k-distance is finite */
+    inline auto HasKAccesses(size_t k) const -> bool { return count_ >= k; }
 
-    inline auto GetId() const -> frame_id_t { return frame_id_; };
+    /** @return true if the frame has any access history, i.e. it is tracked by the replacer */
+    inline auto IsTracked() const -> bool { return count_ > 0; }
 
-    inline auto GetTimes() const -> size_t { return times_; };
+    inline auto IsEvictable() const -> bool { return evictable_; }
+
+    inline void SetEvictable(const bool is_evictable) { evictable_ = is_evictable; }
 
    private:
-    frame_id_t frame_id_;
-    size_t times_;
-    bool evictable_;
+    /** Ring buffer with the last (up to) k access timestamps. */
+    std::vector<size_t> history_;
+    /** Index of the oldest timestamp in history_. */
+    size_t head_{0};
+    /** Number of accesses kept in history_, at most k. */
+    size_t count_{0};
+    bool evictable_{false};
   };
 
  private:
-  // TODO(student): implement me! You can replace these member variables as you like.
-  // Remove maybe_unused if you start using them.
-  [[maybe_unused]] size_t current_timestamp_{0};
-  [[maybe_unused]] size_t curr_size_{0};
-  [[maybe_unused]] size_t replacer_size_;
-  [[maybe_unused]] size_t k_;
-  std::list<std::shared_ptr<FrameInfo>> cache_pool_;
-  std::unordered_map<frame_id_t, std::list<std::shared_ptr<FrameInfo>>::iterator> cache_map_;
-  std::list<std::shared_ptr<FrameInfo>> temp_pool_;
-  std::unordered_map<frame_id_t, std::list<std::shared_ptr<FrameInfo>>::iterator> temp_map_;
+  /** An evictable frame, ordered by the oldest timestamp in its access history. */
+  using EvictionKey = std::pair<size_t, frame_id_t>;
+
+  /** @return the set of evictable frames the given frame belongs to, depending on its number of accesses */
+  auto EvictableSetOf(const FrameInfo &info) -> std::set<EvictionKey> & {
+    return info.HasKAccesses(k_) ? finite_frames_ : inf_frames_;
+  }
+
+  size_t current_timestamp_{0};
+  size_t curr_size_{0};
+  size_t replacer_size_;
+  size_t k_;
+  /** Access history of every frame, indexed by frame id. */
+  std::vector<FrameInfo> frames_;
+  /**
+   * Evictable frames with fewer than k accesses (+inf backward k-distance), ordered by their earliest access. These are
+   * always evicted before any frame in finite_frames_.
+   */
+  std::set<EvictionKey> inf_frames_;
+  /**
+   * Evictable frames with at least k accesses, ordered by the timestamp of their k-th most recent access. The first
+   * one has the largest backward k-distance.
+   */
+  std::set<EvictionKey> finite_frames_;
   std::mutex latch_;
 };
 
@@ -14,6 +14,7 @@
 
 #include <list>
 #include <mutex>  // NOLINT
+#include <unordered_map>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -46,7 +47,13 @@ class LRUReplacer : public Replacer {
   auto Size() -> size_t override;
 
  private:
-  // TODO(student): implement me!
+  /** Maximum number of frames the replacer tracks. */
+  size_t num_pages_;
+  /** Unpinned frames, least recently unpinned first. */
+  std::list<frame_id_t> lru_list_;
+  /** Position of every unpinned frame in lru_list_. */
+  std::unordered_map<frame_id_t, std::list<frame_id_t>::iterator> lru_map_;
+  std::mutex latch_;
 };
 
 }  // namespace bustub
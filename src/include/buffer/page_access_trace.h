@@ -0,0 +1,131 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_access_trace.h
+//
+// Identification: src/include/buffer/page_access_trace.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <fstream>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/** What happened to a page in a PageAccessRecord. */
+enum class PageAccessType : uint8_t {
+  /** The page was pinned by FetchPage or NewPage. */
+  PIN = 0,
+  /** The page was unpinned by UnpinPage. */
+  UNPIN,
+};
+
+/** One event of a page access trace. */
+struct PageAccessRecord {
+  /** Nanoseconds since the trace was started. */
+  uint64_t timestamp_;
+  page_id_t page_id_;
+  PageAccessType type_;
+  /** For an unpin, whether the caller dirtied the page. For a pin, whether the page was created by NewPage. */
+  bool is_dirty_;
+
+  auto operator==(const PageAccessRecord &other) const -> bool {
+    return timestamp_ == other.timestamp_ && page_id_ == other.page_id_ && type_ == other.type_ &&
+           is_dirty_ == other.is_dirty_;
+  }
+};
+
+/** Header of a trace file. */
+struct PageAccessTraceHeader {
+  static constexpr uint32_t MAGIC = 0x54524143;  // "TRAC"
+  static constexpr uint32_t VERSION = 1;
+  uint32_t magic_;
+  uint32_t version_;
+};
+
+/**
+ * PageAccessTraceWriter records the pins and unpins a buffer pool sees to a binary file, so that replacement policies
+ * can be compared offline by replaying the trace (see tools/replacer_replay).
+ *
+ * The file starts with a header, followed by one 12-byte record per event: the timestamp shifted left by two bits with
+ * the unpin and dirty flags in the low bits, then the page id. Records are buffered and written in batches. Record()
+ * is thread-safe, so several buffer pool instances can share one trace.
+ */
+class PageAccessTraceWriter {
+ public:
+  /** Size of a record in the file. */
+  static constexpr size_t RECORD_SIZE = sizeof(uint64_t) + sizeof(page_id_t);
+  /** Number of records buffered before they are written out. */
+  static constexpr size_t BATCH_SIZE = 4096;
+
+  /**
+   * @brief Start a trace, truncating the file if it exists.
+   * @param file_name the trace file
+   * @throws Exception if the file cannot be opened
+   */
+  explicit PageAccessTraceWriter(const std::string &file_name);
+
+  DISALLOW_COPY_AND_MOVE(PageAccessTraceWriter);
+
+  /** @brief Write the buffered records out and close the file. */
+  ~PageAccessTraceWriter();
+
+  /** @brief Record an event, timestamped now. */
+  void Record(page_id_t page_id, PageAccessType type, bool is_dirty);
+
+  /** @brief Write the buffered records out. */
+  void Flush();
+
+  /** @return the number of events recorded so far */
+  auto GetNumRecords() -> size_t;
+
+ private:
+  /** Write the buffered records out. Caller should hold latch_. */
+  void FlushLocked();
+
+  std::mutex latch_;
+  std::ofstream out_;
+  const std::chrono::steady_clock::time_point start_;
+  /** Encoded records not written yet. */
+  std::vector<char> buffer_;
+  size_t num_records_{0};
+};
+
+/**
+ * PageAccessTraceReader reads a trace written by PageAccessTraceWriter back, one record at a time.
+ */
+class PageAccessTraceReader {
+ public:
+  /**
+   * @brief Open a trace.
+   * @param file_name the trace file
+   * @throws Exception if the file cannot be opened or is not a trace
+   */
+  explicit PageAccessTraceReader(const std::string &file_name);
+
+  DISALLOW_COPY_AND_MOVE(PageAccessTraceReader);
+
+  /**
+   * @brief Read the next record.
+   * @param[out] record the record
+   * @return false at the end of the trace; a truncated last record is dropped
+   */
+  auto Next(PageAccessRecord *record) -> bool;
+
+ private:
+  std::ifstream in_;
+};
+
+}  // namespace bustub
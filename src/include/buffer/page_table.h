@@ -0,0 +1,132 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps the ids of the pages resident in a buffer pool to the frames holding them.
+ *
+ * It is an open-addressing hash table with linear probing over a flat, cache-line aligned array of slots. Each slot is
+ * a single 64-bit word packing the page id and the frame id, so a lookup of a resident page usually touches one cache
+ * line. The table never grows: it is sized once for the pool, with at least twice as many slots as frames.
+ *
+ * Insert() and Remove() must be serialized by the caller (the buffer pool latch). Find() takes no lock and may run
+ * concurrently with them. A concurrent Find() can miss an entry that is being inserted or rebuilt, and can return the
+ * frame of an entry that is being removed, so its answer is only a hint that the caller has to validate against the
+ * frame itself.
+ */
+class PageTable {
+ public:
+  /**
+   * @brief Create a page table for a buffer pool.
+   * @param num_frames the number of frames of the buffer pool, i.e. the maximum number of entries
+   */
+  explicit PageTable(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(PageTable);
+
+  ~PageTable() = default;
+
+  /**
+   * @brief Look up the frame holding a page. Safe to call without holding any lock.
+   * @param page_id the page to look up
+   * @param[out] frame_id the frame the page was mapped to, if found
+   * @return true if the page was found
+   */
+  inline auto Find(page_id_t page_id, frame_id_t *frame_id) const -> bool {
+    size_t slot = HashSlot(page_id);
+    for (size_t probes = 0; probes < capacity_; probes++) {
+      uint64_t entry = slots_[slot].value_.load(std::memory_order_acquire);
+      if (entry == EMPTY) {
+        return false;
+      }
+      if (PageOf(entry) == page_id) {
+        *frame_id = FrameOf(entry);
+        return true;
+      }
+      slot = (slot + 1) & mask_;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Map page_id to frame_id. page_id must not be mapped yet. Caller must serialize writers.
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * @brief Remove the mapping of page_id. Caller must serialize writers.
+   * @return true if the page was found and removed
+   */
+  auto Remove(page_id_t page_id) -> bool;
+
+  /** @return the number of pages currently mapped. Caller must serialize with writers. */
+  auto Size() const -> size_t { return size_; }
+
+  /** @return the number of slots of the table. */
+  auto Capacity() const -> size_t { return capacity_; }
+
+ private:
+  /** Slot of an unused entry. Page ids are never negative, so no live entry packs to this value. */
+  static constexpr uint64_t EMPTY = ~static_cast<uint64_t>(0);
+  /** Slot of a removed entry. Lookups probe past it, inserts may reuse it. */
+  static constexpr uint64_t TOMBSTONE = ~static_cast<uint64_t>(0) - (static_cast<uint64_t>(1) << 32);
+
+  /** A slot is a single atomic word, so that readers never observe half of an update. */
+  struct Slot {
+    std::atomic<uint64_t> value_{EMPTY};
+  };
+
+  static inline auto Pack(page_id_t page_id, frame_id_t frame_id) -> uint64_t {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+  static inline auto PageOf(uint64_t entry) -> page_id_t { return static_cast<page_id_t>(entry >> 32); }
+  static inline auto FrameOf(uint64_t entry) -> frame_id_t { return static_cast<frame_id_t>(entry & 0xFFFFFFFF); }
+
+  /** Fibonacci hashing: page ids are mostly dense and sequential, the multiplication spreads them over the table. */
+  inline auto HashSlot(page_id_t page_id) const -> size_t {
+    return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 0x9E3779B97F4A7C15ULL) >>
+                               shift_);
+  }
+
+  /** Reinsert every live entry to get rid of the accumulated tombstones. Caller must serialize writers. */
+  void Rebuild();
+
+  /** Deleter for the slot array, which is allocated with cache-line alignment. */
+  struct SlotDeleter {
+    void operator()(Slot *slots) const;
+  };
+
+  /** Number of slots, a power of two. */
+  size_t capacity_;
+  /** capacity_ - 1, to wrap probe sequences around. */
+  size_t mask_;
+  /** 64 - log2(capacity_), to take the high bits of the hash. */
+  int shift_;
+  /** Number of live entries. */
+  size_t size_{0};
+  /** Number of tombstones. */
+  size_t tombstones_{0};
+  /** The slots. */
+  std::unique_ptr<Slot[], SlotDeleter> slots_;
+};
+
+}  // namespace bustub
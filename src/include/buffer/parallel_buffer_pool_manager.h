@@ -0,0 +1,187 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/read_ahead_worker.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager shards the buffer pool into several independent BufferPoolManagerInstances so that
+ * operations on different pages do not serialize on a single latch. A page always lives in the instance selected by
+ * `page_id % num_instances`, and every instance only allocates page ids that map back to itself.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * @brief Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of individual BufferPoolManagerInstances to store
+   * @param pool_size the pool size of each BufferPoolManagerInstance
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer of each instance
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param max_pool_size the number of frames Resize() can grow each instance to, 0 to make it pool_size
+   * @param replacer_type the replacement policy of each instance
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            size_t replacer_k = LRUK_REPLACER_K, LogManager *log_manager = nullptr,
+                            size_t max_pool_size = 0, ReplacerType replacer_type = ReplacerType::LRU_K);
+
+  /**
+   * @brief Destroys an existing ParallelBufferPoolManager.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /** @brief Return the total number of frames across all the instances. */
+  auto GetPoolSize() -> size_t override;
+
+  /** @brief Return the total number of frames all the instances can grow to. */
+  auto GetMaxPoolSize() -> size_t override;
+
+  /**
+   * @brief Resize the instances so that they add up to pool_size frames, spread as evenly as possible. If one of them
+   * cannot be resized, the ones resized before it go back to their old size.
+   * @param pool_size the new total number of frames, at least one per instance
+   * @return false if the pool could not be resized
+   */
+  auto Resize(size_t pool_size) -> bool override;
+
+  /** @brief Return the number of instances the pool is sharded into. */
+  auto GetNumInstances() const -> size_t { return num_instances_; }
+
+  /** @brief Start the background flusher of every instance. See BufferPoolManagerInstance::StartBackgroundFlusher(). */
+  void StartBackgroundFlusher(double low_watermark = BACKGROUND_FLUSH_LOW_WATERMARK,
+                              double high_watermark = BACKGROUND_FLUSH_HIGH_WATERMARK);
+
+  /** @brief Stop the background flusher of every instance. */
+  void StopBackgroundFlusher();
+
+  /** @brief Record the pins and unpins of every instance to the same trace. */
+  void SetAccessTrace(PageAccessTraceWriter *trace) override;
+
+  /** @brief Enable the admission filter of every instance. See BufferPoolManagerInstance::EnableAdmissionFilter(). */
+  void EnableAdmissionFilter(size_t window_size = ADMISSION_WINDOW_SIZE);
+
+  /** @return the number of pages the background flushers of all the instances have written back */
+  auto GetFlushedPageCount() const -> uint64_t;
+
+  /** @return the number of dirty pages all the instances had to write back when evicting them */
+  auto GetEvictedDirtyPageCount() const -> uint64_t;
+
+  /** @brief Look a resident page up for an optimistic read in the instance responsible for it. */
+  auto FetchPageOptimistic(page_id_t page_id, uint64_t *version) -> Page * override;
+
+  /** @brief Make sure a page is resident in the instance responsible for it, without keeping it pinned. */
+  auto PrefetchPage(page_id_t page_id) -> bool override;
+
+  /**
+   * @return the hot pages of all the instances, interleaved: the replacers of different instances do not share a
+   * clock, so their orders can only be merged round-robin
+   */
+  auto GetHotPages() -> std::vector<page_id_t> override;
+
+  /** @return the statistics of all the instances added up */
+  auto GetStats() -> BufferPoolStatsSnapshot override;
+
+  /** @brief Set the statistics of every instance back to zero. */
+  void ResetStats() override;
+
+  /**
+   * @brief Read pages ahead on a background thread, following the chain across instances. At most an eighth of the
+   * total pool is read ahead per hint.
+   */
+  void ReadAhead(page_id_t page_id, next_page_fn next_page, size_t num_pages,
+                 std::shared_ptr<BufferAccessStrategy> strategy = nullptr) override;
+
+ protected:
+  /**
+   * @brief Return the BufferPoolManagerInstance responsible for handling the given page id.
+   * @param page_id id of page
+   * @return pointer to the BufferPoolManagerInstance responsible for handling given page id
+   */
+  auto GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance *;
+
+  /**
+   * @brief Fetch the requested page from the instance responsible for it.
+   * @param page_id id of page to be fetched
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgImp(page_id_t page_id) -> Page * override;
+
+  /**
+   * @brief Fetch the requested page from the instance responsible for it, using the instance's share of the ring of
+   * the access strategy.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, or nullptr
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * @brief Unpin the target page from the instance responsible for it.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
+
+  /**
+   * @brief Flush the target page to disk.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  auto FlushPgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Create a new page. Instances are tried in round-robin order, starting from a different instance on every
+   * call, so that new pages are spread evenly over the shards.
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPgImp(page_id_t *page_id) -> Page * override;
+
+  /**
+   * @brief Delete a page from the instance responsible for it.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  auto DeletePgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Flush all the pages of every instance to disk, and sync the disk manager once they are all written.
+   */
+  void FlushAllPgsImp() override;
+
+ private:
+  /** Number of instances the pool is sharded into. */
+  const size_t num_instances_;
+  /** The disk manager the instances share. */
+  DiskManager *disk_manager_;
+  /** The instance NewPgImp() should try first on its next call. */
+  std::atomic<size_t> next_instance_{0};
+  /** The buffer pool shards, indexed by `page_id % num_instances_`. */
+  std::vector<std::unique_ptr<BufferPoolManagerInstance>> instances_;
+  /** Serves the read-ahead hints. Declared last so that it is stopped before the instances go away. */
+  std::unique_ptr<ReadAheadWorker> read_ahead_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,94 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead_worker.h
+//
+// Identification: src/include/buffer/read_ahead_worker.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ReadAheadWorker serves the read-ahead hints of a buffer pool on a background thread, so that the pages a scan is
+ * going to need next are loaded while it is still busy with the current one.
+ *
+ * A hint names the first page of a chain and how to get from one page to the next. The chain has to be walked page by
+ * page, as the id of the next page is only known once the current one is in memory. Hints that arrive while the queue
+ * is full are dropped: read-ahead is best effort.
+ */
+class ReadAheadWorker {
+ public:
+  /**
+   * Makes sure page_id is resident in the buffer pool without keeping it pinned, and returns the id of the page
+   * following it as reported by next_page, or INVALID_PAGE_ID if the page could not be loaded. Misses go to the ring
+   * of the access strategy, if there is one.
+   */
+  using prefetch_fn = std::function<page_id_t(page_id_t page_id, BufferPoolManager::next_page_fn next_page,
+                                              BufferAccessStrategy *strategy)>;
+
+  /**
+   * @brief Create a worker. Its thread is only started by the first hint.
+   * @param prefetch loads a single page on behalf of the worker
+   */
+  explicit ReadAheadWorker(prefetch_fn prefetch) : prefetch_(std::move(prefetch)) {}
+
+  DISALLOW_COPY_AND_MOVE(ReadAheadWorker);
+
+  /** @brief Stop and join the worker thread. Pending hints are dropped. */
+  ~ReadAheadWorker();
+
+  /**
+   * @brief Queue a hint to load up to num_pages pages, starting at page_id and following next_page. The hint keeps
+   * the access strategy alive until it has been served.
+   */
+  void Schedule(page_id_t page_id, BufferPoolManager::next_page_fn next_page, size_t num_pages,
+                std::shared_ptr<BufferAccessStrategy> strategy);
+
+ private:
+  /** Maximum number of hints waiting in the queue. */
+  static constexpr size_t MAX_PENDING = 32;
+
+  struct Request {
+    page_id_t page_id_{INVALID_PAGE_ID};
+    BufferPoolManager::next_page_fn next_page_{nullptr};
+    size_t num_pages_{0};
+    std::shared_ptr<BufferAccessStrategy> strategy_;
+  };
+
+  /** Body of the worker thread. */
+  void Run();
+
+  /** Loads a single page. */
+  prefetch_fn prefetch_;
+  /** Protects the members below. */
+  std::mutex latch_;
+  /** Signalled when a hint is queued or the worker should stop. */
+  std::condition_variable cv_;
+  /** Hints not served yet. */
+  std::deque<Request> queue_;
+  /** True once the worker should stop. */
+  bool stop_{false};
+  /** The worker thread, nullptr until the first hint. */
+  std::thread *thread_{nullptr};
+};
+
+}  // namespace bustub
@@ -228,11 +228,19 @@ class Catalog {
     // TODO(chi): support both hash index and btree index
     auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
 
-    // Populate the index with all tuples in table heap
+    // Populate the index with all tuples in table heap: sort the entries, then build the tree bottom-up out of them
+    // instead of inserting them one at a time
     auto *table_meta = GetTable(table_name);
     auto *heap = table_meta->table_.get();
+    ExternalSorter<KeyType, ValueType, KeyComparator> sorter(index->GetComparator());
     for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
-      index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
+      KeyType index_key;
+      index_key.SetFromKey(tuple->KeyFromTuple(schema, key_schema, key_attrs));
+      sorter.Add(index_key, tuple->GetRid());
+    }
+    if (!index->BulkLoad(&sorter)) {
+      // The buffer pool ran out of frames; the tree gave back the pages it had built.
+      return NULL_INDEX_INFO;
     }
 
     // Get the next OID for the new index
@@ -34,6 +34,8 @@ class Transaction;
 class ExecutorContext;
 class DiskManager;
 class BufferPoolManager;
+class BufferPoolWarmer;
+class PageAccessTraceWriter;
 class LockManager;
 class TransactionManager;
 class LogManager;
@@ -211,9 +213,23 @@ class BustubInstance {
   auto MakeExecutorContext(Transaction *txn) -> std::unique_ptr<ExecutorContext>;
 
  public:
-  explicit BustubInstance(const std::string &db_file_name);
+  /**
+   * Create a BusTub instance backed by the given database file.
+   * @param db_file_name the database file
+   * @param bpm_instances number of shards of the buffer pool; more than one selects a ParallelBufferPoolManager
+   * @param warm_up_buffer_pool if true, the ids of the resident pages are saved next to the database file when the
+   * instance is destroyed, and prefetched in the background when it is created again
+   * @param direct_io if true, pages are read and written with direct I/O, so that they are only cached by the buffer
+   * pool and not by the operating system as well
+   */
+  explicit BustubInstance(const std::string &db_file_name, size_t bpm_instances = 1,
+                          bool warm_up_buffer_pool = false, bool direct_io = false);
 
-  BustubInstance();
+  /**
+   * Create a BusTub instance backed by memory.
+   * @param bpm_instances number of shards of the buffer pool; more than one selects a ParallelBufferPoolManager
+   */
+  explicit BustubInstance(size_t bpm_instances = 1);
 
   ~BustubInstance();
 
@@ -267,11 +283,24 @@ class BustubInstance {
   }
 
  private:
+  void MakeBufferPoolManager(size_t bpm_instances);
+  /** @brief Resize the buffer pool to the given number of frames, throwing if that is not possible. */
+  void SetBufferPoolSize(const std::string &value);
   void CmdDisplayTables(ResultWriter &writer);
   void CmdDisplayIndices(ResultWriter &writer);
   void CmdDisplayHelp(ResultWriter &writer);
+  void CmdDisplayDbSize(ResultWriter &writer);
+  void CmdDisplayBufferPoolStats(ResultWriter &writer);
+  /** @brief Start recording the page accesses of the buffer pool to a file, or stop if it is "off". */
+  void CmdTrace(const std::string &file_name, ResultWriter &writer);
   void WriteOneCell(const std::string &cell, ResultWriter &writer);
   std::unordered_map<std::string, std::string> session_variables_;
+  /** Sidecar file with the hot pages of the buffer pool, empty if warm-up is disabled. */
+  std::string warm_up_file_name_;
+  /** Prefetches the hot pages saved by the previous instance, nullptr if warm-up is disabled. */
+  std::unique_ptr<BufferPoolWarmer> warmer_;
+  /** The page access trace being recorded by `\trace`, nullptr if there is none. */
+  std::unique_ptr<PageAccessTraceWriter> access_trace_;
 };
 
 }  // namespace bustub
@@ -14,6 +14,7 @@
 
 #include <atomic>
 #include <chrono>  // NOLINT
+#include <cstddef>
 #include <cstdint>
 
 namespace bustub {
@@ -27,6 +28,9 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** A running background flusher checks the buffer pool at least every BACKGROUND_FLUSH_INTERVAL milliseconds. */
+extern std::chrono::milliseconds background_flush_interval;
+
 static constexpr int INVALID_PAGE_ID = -1;                                           // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                            // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                               // invalid log sequence number
@@ -36,6 +40,22 @@ static constexpr int BUFFER_POOL_SIZE = 10;
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
 static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr int READ_AHEAD_PAGES = 16;  // number of pages sequential scans ask the buffer pool to read ahead
+static constexpr int SCAN_RING_SIZE = 32;    // number of frames a large sequential scan recycles
+static constexpr int DISK_QUEUE_DEPTH = 64;  // maximum number of asynchronous page I/Os in flight per disk manager
+static constexpr int FLUSH_RUN_PAGES = 64;   // maximum number of adjacent pages flushed with a single vectored write
+static constexpr int FREE_PAGE_BATCH = 64;   // free pages reserved for reuse with a single free space map save
+static constexpr int ADMISSION_WINDOW_SIZE = 8;  // frames the pages turned away by the admission filter recycle
+static constexpr int MAX_BUFFER_POOL_SIZE = 16384;  // number of frames `SET buffer_pool_size` can grow the pool to
+static constexpr int CACHE_LINE_SIZE = 64;          // alignment that keeps objects written by different threads apart
+static constexpr int HUGE_PAGE_SIZE = 2 * 1024 * 1024;  // size of a transparent huge page
+static constexpr bool BUFFER_POOL_HUGE_PAGES = true;    // back frame data of at least HUGE_PAGE_SIZE with huge pages
+static constexpr size_t EXTERNAL_SORT_MEMORY = 16 * 1024 * 1024;  // bytes an index build sorts in memory per run
+static constexpr double INDEX_FILL_FACTOR = 0.9;  // fraction of each page a bulk loaded B+ tree fills
+// the background flusher starts writing dirty pages back when less than this fraction of the frames are clean
+static constexpr double BACKGROUND_FLUSH_LOW_WATERMARK = 0.1;
+// and stops once at least this fraction of the frames are clean
+static constexpr double BACKGROUND_FLUSH_HIGH_WATERMARK = 0.25;
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
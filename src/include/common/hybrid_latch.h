@@ -0,0 +1,94 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hybrid_latch.h
+//
+// Identification: src/include/common/hybrid_latch.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * A reader-writer latch with an additional optimistic read mode.
+ *
+ * Next to the shared mutex, the latch keeps a version counter that writers make odd when they acquire the latch and
+ * even again when they release it. An optimistic reader takes no lock at all: it remembers the version, reads the
+ * protected data and then validates that the version did not change. Readers therefore never write to the latch's
+ * cache line, which is what makes a shared RLock expensive on read-mostly data touched by many cores.
+ *
+ * Optimistic reads can see data in the middle of a modification, so the reader must not act on what it read before
+ * Validate() succeeds, and must be prepared for garbage (e.g. bound-check any size or index it reads).
+ */
+class HybridLatch {
+ public:
+  /** Acquire the write latch. */
+  void WLock() {
+    mutex_.lock();
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  /** Release the write latch. */
+  void WUnlock() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    mutex_.unlock();
+  }
+
+  /** Acquire a read latch. */
+  void RLock() { mutex_.lock_shared(); }
+
+  /** Release a read latch. */
+  void RUnlock() { mutex_.unlock_shared(); }
+
+  /**
+   * Try to acquire a read latch without blocking.
+   * @return true if the read latch was acquired
+   */
+  auto TryRLock() -> bool { return mutex_.try_lock_shared(); }
+
+  /**
+   * Start an optimistic read.
+   * @param[out] version the version to pass to Validate() once done reading
+   * @return false if a writer holds the latch, in which case the read has to be done pessimistically
+   */
+  auto TryOptimisticRead(uint64_t *version) const -> bool {
+    *version = version_.load(std::memory_order_acquire);
+    return (*version & 1) == 0;
+  }
+
+  /**
+   * Finish an optimistic read.
+   * @param version the version TryOptimisticRead() returned
+   * @return true if nobody wrote in the meantime, i.e. what was read is consistent
+   */
+  auto Validate(uint64_t version) const -> bool {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
+  /**
+   * Fail all the optimistic reads in progress without taking the latch, for owners that replace the protected data by
+   * other means, e.g. a buffer pool recycling a frame.
+   */
+  void Invalidate() { version_.fetch_add(2); }
+
+ private:
+  // The version goes first: optimistic readers only touch it, so it should share a cache line with whatever precedes
+  // the latch rather than sit behind the mutex.
+  std::atomic<uint64_t> version_{0};
+  std::shared_mutex mutex_;
+};
+
+}  // namespace bustub
@@ -18,6 +18,7 @@
 #include <unordered_set>
 
 #include "common/config.h"
+#include "common/rwlatch.h"
 #include "concurrency/lock_manager.h"
 #include "concurrency/transaction.h"
 #include "recovery/log_manager.h"
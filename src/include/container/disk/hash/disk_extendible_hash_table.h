@@ -17,6 +17,7 @@
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "container/hash/hash_function.h"
 #include "storage/page/hash_table_bucket_page.h"
@@ -13,50 +13,155 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <future>  // NOLINT
+#include <map>
 #include <mutex>   // NOLINT
 #include <string>
+#include <vector>
 
 #include "common/config.h"
+#include "storage/disk/free_space_map.h"
 
 namespace bustub {
 
+/**
+ * A page read or write to be carried out asynchronously by DiskManager::Schedule().
+ */
+struct DiskRequest {
+  /** Flag indicating whether the request is a write or a read. */
+  bool is_write_;
+  /** The page data to write, or the buffer to read the page into. Must stay valid until the request completes. */
+  char *data_;
+  /** ID of the page being read from / written to disk. */
+  page_id_t page_id_;
+  /** Set to true once the request completed successfully, or to false if the I/O failed. */
+  std::promise<bool> callback_;
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with positional I/O on a plain file descriptor, without any lock, so that any number of
+ * threads can have page I/O in flight at once. Writes are not synced to stable storage until Sync() is called.
+ *
+ * Deallocated pages are tracked in a FreeSpaceMap, which is persisted in a `.fsm` file next to the database file
+ * whenever the database file is synced.
+ *
+ * In direct I/O mode the database file is opened with O_DIRECT, so that pages cached by the buffer pool are not cached
+ * a second time by the operating system. Page buffers aligned to DIRECT_IO_ALIGNMENT, like the frames of the buffer
+ * pool, are transferred as they are; others go through an aligned bounce buffer.
  */
 class DiskManager {
  public:
+  /** Alignment of the buffers, file offsets and lengths of direct I/O. */
+  static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param direct_io if true, bypass the operating system's page cache, if the file system allows it
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool direct_io = false);
 
   /** FOR TEST / LEADERBOARD ONLY, used by DiskManagerMemory */
   DiskManager() = default;
 
-  virtual ~DiskManager() = default;
+  virtual ~DiskManager();
 
   /**
-   * Shut down the disk manager and close all the file resources.
+   * Shut down the disk manager and close all the file resources. The database file is synced first.
    */
   void ShutDown();
 
+  /**
+   * Make all the pages written so far durable. Page writes only reach the operating system, so call this wherever
+   * durability is required.
+   */
+  virtual void Sync();
+
   /**
    * Write a page to the database file.
    * @param page_id id of the page
    * @param page_data raw page data
+   * @return false on an I/O error
    */
-  virtual void WritePage(page_id_t page_id, const char *page_data);
+  virtual auto WritePage(page_id_t page_id, const char *page_data) -> bool;
+
+  /**
+   * Write a run of adjacent pages to the database file with a single vectored write.
+   * @param start_page_id id of the first page of the run
+   * @param pages raw data of the pages start_page_id, start_page_id + 1, ...
+   */
+  virtual void WritePages(page_id_t start_page_id, const std::vector<const char *> &pages);
 
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
+   * @return false on an I/O error; the part of a page past the end of the file reads as zeros
    */
-  virtual void ReadPage(page_id_t page_id, char *page_data);
+  virtual auto ReadPage(page_id_t page_id, char *page_data) -> bool;
+
+  /**
+   * Start a batch of page reads and writes. The requests of a batch may complete in any order, each one fulfills its
+   * own callback. Use this to have several I/Os in flight from a single thread.
+   *
+   * The default implementation carries the requests out one after the other before returning, asynchronous disk
+   * managers submit the whole batch at once and return right away.
+   * @param requests the requests to schedule, moved out of the vector
+   */
+  virtual void Schedule(std::vector<DiskRequest> *requests);
+
+  /**
+   * Start reading a page, see Schedule().
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, must stay valid until the returned future is ready
+   * @return a future that becomes true when the page has been read, false if the read failed
+   */
+  auto ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<bool>;
+
+  /**
+   * Start writing a page, see Schedule().
+   * @param page_id id of the page
+   * @param page_data raw page data, must stay valid and unchanged until the returned future is ready
+   * @return a future that becomes true when the page has been written, false if the write failed
+   */
+  auto WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<bool>;
+
+  /**
+   * Record that a page is no longer used, so that its space can be handed out again.
+   * @param page_id id of the page
+   */
+  void DeallocatePage(page_id_t page_id);
+
+  /**
+   * Take a deallocated page for reuse. Pages are reserved out of the free space map FREE_PAGE_BATCH at a time, and the
+   * map is saved once per batch, so that a reused page is not free any more after a crash. A crash leaks the pages
+   * still reserved, ShutDown() returns them to the map.
+   * @param residue, modulus only pages whose id is `residue` modulo `modulus` are considered
+   * @return the lowest such reserved page, or INVALID_PAGE_ID if there is none or the map could not be saved
+   */
+  auto ReuseFreePage(page_id_t residue, page_id_t modulus) -> page_id_t;
+
+  /**
+   * Give a page back that ReuseFreePage() handed out but that ended up unused. It stays reserved, and the next
+   * ReuseFreePage() of its class hands it out again.
+   * @param page_id the page to give back
+   * @param modulus the modulus it was taken with
+   */
+  void ReturnFreePage(page_id_t page_id, page_id_t modulus);
+
+  /** @return the number of pages of the database file, including the deallocated ones */
+  virtual auto GetNumPages() -> page_id_t;
+
+  /** @return the number of deallocated pages of the database file that have not been reused yet */
+  auto GetNumFreePages() -> size_t;
+
+  /** @return the number of times the free space map was written to its file */
+  auto GetNumFreeSpaceMapSaves() -> size_t { return free_space_map_.GetNumSaves(); }
 
   /**
    * Flush the entire log buffer into disk.
@@ -83,6 +188,12 @@ class DiskManager {
   /** @return the number of disk writes */
   auto GetNumWrites() const -> int;
 
+  /** @return the number of syncs of the database file */
+  auto GetNumSyncs() const -> int;
+
+  /** @return true if the database file was opened for direct I/O */
+  auto IsDirectIO() const -> bool { return direct_io_; }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -94,18 +205,34 @@ class DiskManager {
 
  protected:
   auto GetFileSize(const std::string &file_name) -> int;
+  /** Record that the db file now extends to at least `end` bytes. Safe to call concurrently. */
+  void ExtendFileSize(uint64_t end);
+  /** @return true if the page buffer can't be handed to the db file as it is, because it is opened for direct I/O */
+  auto NeedsBounceBuffer(const char *page_data) const -> bool {
+    return direct_io_ && reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT != 0;
+  }
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // descriptor of the db file, -1 if it is not open
+  int db_fd_{-1};
+  // true if db_fd_ was opened with O_DIRECT
+  bool direct_io_{false};
   std::string file_name_;
+  std::string fsm_name_;
+  // pages deallocated and not reused yet
+  FreeSpaceMap free_space_map_;
+  // pages taken out of the free space map by ReuseFreePage() and not handed out yet, by (residue, modulus), in
+  // descending order
+  std::mutex reserve_latch_;
+  std::map<std::pair<page_id_t, page_id_t>, std::vector<page_id_t>> reserved_pages_;
+  // size of the db file, kept up to date by the writes so that reads do not have to stat the file
+  std::atomic<uint64_t> db_file_size_{0};
   int num_flushes_{0};
-  int num_writes_{0};
+  std::atomic<int> num_writes_{0};
+  std::atomic<int> num_syncs_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
 };
 
 }  // namespace bustub
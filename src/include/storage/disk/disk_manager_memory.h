@@ -42,15 +42,17 @@ class DiskManagerMemory : public DiskManager {
    * Write a page to the database file.
    * @param page_id id of the page
    * @param page_data raw page data
+   * @return true
    */
-  void WritePage(page_id_t page_id, const char *page_data) override;
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override;
 
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
+   * @return true
    */
-  void ReadPage(page_id_t page_id, char *page_data) override;
+  auto ReadPage(page_id_t page_id, char *page_data) -> bool override;
 
  private:
   char *memory_;
@@ -68,8 +70,9 @@ class DiskManagerUnlimitedMemory : public DiskManager {
    * Write a page to the database file.
    * @param page_id id of the page
    * @param page_data raw page data
+   * @return true
    */
-  void WritePage(page_id_t page_id, const char *page_data) override {
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override {
     std::unique_lock<std::mutex> l(mutex_);
     if (page_id >= static_cast<int>(data_.size())) {
       data_.resize(page_id + 1);
@@ -82,28 +85,37 @@ class DiskManagerUnlimitedMemory : public DiskManager {
     l.unlock();
 
     memcpy(ptr->first.data(), page_data, BUSTUB_PAGE_SIZE);
+    return true;
   }
 
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
+   * @return false if the page was never written
    */
-  void ReadPage(page_id_t page_id, char *page_data) override {
+  auto ReadPage(page_id_t page_id, char *page_data) -> bool override {
     std::unique_lock<std::mutex> l(mutex_);
     if (page_id >= static_cast<int>(data_.size()) || page_id < 0) {
       LOG_WARN("page not exist");
-      return;
+      return false;
     }
     if (data_[page_id] == nullptr) {
       LOG_WARN("page not exist");
-      return;
+      return false;
     }
     std::shared_ptr<ProtectedPage> ptr = data_[page_id];
     std::shared_lock<std::shared_mutex> l_page(ptr->second);
     l.unlock();
 
     memcpy(page_data, ptr->first.data(), BUSTUB_PAGE_SIZE);
+    return true;
+  }
+
+  /** @return the number of pages, up to the highest one written so far */
+  auto GetNumPages() -> page_id_t override {
+    std::unique_lock<std::mutex> l(mutex_);
+    return static_cast<page_id_t>(data_.size());
   }
 
  private:
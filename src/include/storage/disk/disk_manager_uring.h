@@ -0,0 +1,114 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_uring.h
+//
+// Identification: src/include/storage/disk/disk_manager_uring.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <linux/io_uring.h>
+
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * DiskManagerUring is a DiskManager that carries out the requests passed to Schedule() asynchronously with io_uring.
+ * A whole batch is submitted to the kernel with a single system call, and up to `queue_depth` requests are in flight
+ * at once. A background thread reaps the completions and fulfills the callbacks of the requests.
+ *
+ * The synchronous ReadPage(), WritePage() and Sync() are inherited from DiskManager and work as before. If the kernel
+ * does not support io_uring, Schedule() falls back to carrying the requests out synchronously, too, and so it does for
+ * requests whose buffer is not aligned for direct I/O.
+ *
+ * All the scheduled requests must have completed before ShutDown() is called.
+ */
+class DiskManagerUring : public DiskManager {
+ public:
+  /**
+   * Creates a new disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param queue_depth the maximum number of requests in flight at once
+   * @param direct_io if true, bypass the operating system's page cache, if the file system allows it
+   */
+  explicit DiskManagerUring(const std::string &db_file, uint32_t queue_depth = DISK_QUEUE_DEPTH,
+                            bool direct_io = false);
+
+  ~DiskManagerUring() override;
+
+  /**
+   * Submit a batch of requests to the kernel. Returns once the whole batch has been submitted, which only blocks if
+   * more than `queue_depth` requests would be in flight.
+   * @param requests the requests to schedule, moved out of the vector
+   */
+  void Schedule(std::vector<DiskRequest> *requests) override;
+
+  /** @return true if requests are carried out with io_uring, false if they fall back to synchronous I/O */
+  auto IsAsync() const -> bool { return ring_fd_ >= 0; }
+
+ private:
+  /** Map the submission and completion rings of ring_fd_. */
+  auto MapRings(const io_uring_params &params) -> bool;
+
+  /**
+   * Hand `count` queued submission entries over to the kernel. The requests of the entries the kernel refuses are
+   * carried out synchronously instead. Caller must hold submit_latch_.
+   */
+  void Submit(uint32_t count);
+
+  /** Queue a submission entry for a request, user_data 0 is a wake-up of the completion thread. */
+  void QueueEntry(uint8_t opcode, char *data, page_id_t page_id, uint64_t user_data);
+
+  /** Reap completions until the disk manager is destroyed. */
+  void RunCompletions();
+
+  /** Fulfill the callback of a completed request and free it. */
+  void Complete(DiskRequest *request, int result);
+
+  /** The io_uring instance, -1 if it could not be set up. */
+  int ring_fd_{-1};
+  /** Number of submission entries, i.e. the maximum number of requests in flight. */
+  uint32_t sq_entries_{0};
+
+  /** The mapped rings. They may share a single mapping. */
+  void *sq_ring_ptr_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_ptr_{nullptr};
+  size_t cq_ring_size_{0};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+
+  /** Shared with the kernel: submission ring. */
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  /** Shared with the kernel: completion ring. */
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  io_uring_cqe *cqes_{nullptr};
+
+  /** Serializes submissions. */
+  std::mutex submit_latch_;
+  /** Signalled when requests complete and make room for more. */
+  std::condition_variable slot_cv_;
+  /** Number of requests submitted but not completed yet. Guarded by submit_latch_. */
+  uint32_t in_flight_{0};
+  /** Reaps the completions. */
+  std::thread completion_thread_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/disk/free_space_map.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap is a bitmap over the page ids of a database file, with a bit set for every page that was deallocated
+ * and can be handed out again. It is safe to use from several threads.
+ *
+ * Page ids are allocated in residue classes: a buffer pool instance `i` out of `n` only owns the ids that are `i`
+ * modulo `n`, so it asks for the lowest free page of its own class.
+ *
+ * The map is kept in a sidecar file next to the database file. Save() records the number of pages the database file
+ * had at that point, and Load() rejects a map for a file that is shorter than that, which happens when the database
+ * file was removed or recreated after the map was saved.
+ */
+class FreeSpaceMap {
+ public:
+  FreeSpaceMap() = default;
+
+  /**
+   * @brief Mark a page free.
+   * @param page_id the page that is no longer used
+   */
+  void Free(page_id_t page_id);
+
+  /**
+   * @brief Take the lowest free page whose id is `residue` modulo `modulus`, and mark it used.
+   * @return the page id, or INVALID_PAGE_ID if there is no such free page
+   */
+  auto Allocate(page_id_t residue, page_id_t modulus) -> page_id_t;
+
+  /** @return true if the page is currently free */
+  auto IsFree(page_id_t page_id) -> bool;
+
+  /** @return the number of free pages */
+  auto GetNumFree() -> size_t;
+
+  /** @return the number of times Save() wrote the map */
+  auto GetNumSaves() -> size_t;
+
+  /**
+   * @brief Write the map to a file, replacing it atomically and durably. Does nothing if the map did not change since
+   * the last Save() or Load().
+   * @param file_name the file to write
+   * @param num_pages the number of pages of the database file the map belongs to
+   * @return false if the file could not be written
+   */
+  auto Save(const std::string &file_name, page_id_t num_pages) -> bool;
+
+  /**
+   * @brief Replace the map with the one stored in a file. Free pages at or past num_pages are dropped.
+   * @param file_name the file to read
+   * @param num_pages the current number of pages of the database file
+   * @return false if the file does not exist, is corrupt or belongs to a longer database file; the map is then empty
+   */
+  auto Load(const std::string &file_name, page_id_t num_pages) -> bool;
+
+ private:
+  /** Header of the sidecar file. */
+  struct FileHeader {
+    uint32_t magic_;
+    uint32_t num_pages_;
+    uint64_t num_words_;
+  };
+  static constexpr uint32_t MAGIC = 0x4653504d;  // "FSPM"
+
+  std::mutex latch_;
+  /** One bit per page id, set if the page is free. */
+  std::vector<uint64_t> words_;
+  /** Number of bits set. */
+  size_t num_free_{0};
+  /** No word before this one has a bit set. */
+  size_t first_word_{0};
+  /** True if the map changed since it was last saved or loaded. */
+  bool dirty_{false};
+  /** Number of times the map was written. */
+  size_t num_saves_{0};
+};
+
+}  // namespace bustub
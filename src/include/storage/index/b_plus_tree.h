@@ -11,11 +11,15 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
+#include "storage/index/external_sorter.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
@@ -24,6 +28,17 @@ namespace bustub {
 
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
 
+/** How concurrent operations on a BPlusTree synchronize. */
+enum class BPlusTreeMode {
+  /** Latch crabbing: optimistic descent, restarted with write latches from the root when a page splits or merges. */
+  LATCH_CRABBING = 0,
+  /**
+   * Lehman-Yao B-link tree: every page has a high key and a right link, so a descent holds one latch at a time and
+   * moves right past concurrent splits. Removes only take the entry out of its leaf and never merge pages.
+   */
+  B_LINK,
+};
+
 /**
  * Main class providing the API for the Interactive B+ Tree.
  *
@@ -40,8 +55,10 @@ class BPlusTree {
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
 
  public:
+  // Pages hold at most as many entries as fit, which is also what a max size of 0 stands for.
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = 0, int internal_max_size = 0,
+                     BPlusTreeMode mode = BPlusTreeMode::LATCH_CRABBING);
 
   // Returns true if this B+ tree has no keys and values.
   auto IsEmpty() const -> bool;
@@ -52,6 +69,11 @@ class BPlusTree {
   // Remove a key and its value from this B+ tree.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
+  // Build this empty B+ tree bottom-up out of the entries added to a sorter, filling pages up to fill_factor. Returns
+  // false if the tree is not empty or the buffer pool runs out of frames.
+  auto BulkLoad(ExternalSorter<KeyType, ValueType, KeyComparator> *sorter, double fill_factor = INDEX_FILL_FACTOR)
+      -> bool;
+
   // return the value associated with a given key
   auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr) -> bool;
 
@@ -85,14 +107,81 @@ class BPlusTree {
 
   auto BuildTree() -> bool;
 
-  auto DfsFindPage(const KeyType &key, page_id_t current_page_id, page_id_t &leaf_page_id,
-                   Transaction *transaction = nullptr, bool is_write = false) -> LeafPage *;
+  /** What a descent to a leaf is for, which decides how the leaf is latched and which pages are safe. */
+  enum class Operation { SEARCH, INSERT, REMOVE };
+
+  auto FindLeaf(const KeyType &key, Operation op) -> Page *;
+
+  auto FindLeafOptimistic(const KeyType &key, Operation op) -> Page *;
+
+  auto FindLeafCrabbing(const KeyType &key, Operation op) -> Page *;
+
+  auto FindLeafPessimistic(const KeyType &key, Operation op, Transaction *transaction) -> Page *;
+
+  auto FindEdgeLeaf(bool rightmost) -> Page *;
+
+  auto OptimisticFindChild(const KeyType &key, Page *ptr, uint64_t version, page_id_t *child_page_id) -> bool;
+
+  auto IsSafe(BPlusTreePage *page, Operation op) const -> bool;
+
+  void ReleaseAncestors(Transaction *transaction);
+
+  static auto PageLevel(BPlusTreePage *page) -> int;
+
+  auto BLinkNextPage(BPlusTreePage *page, const KeyType &key) -> page_id_t;
+
+  auto BLinkMoveRight(Page *ptr, const KeyType &key, bool exclusive) -> Page *;
+
+  auto BLinkDescend(const KeyType &key, int level, bool exclusive, std::vector<page_id_t> *path) -> Page *;
+
+  auto BLinkFindEdgeLeaf(bool rightmost) -> Page *;
+
+  auto BLinkInsert(const KeyType &key, const ValueType &value) -> bool;
+
+  void BLinkInsertParent(std::vector<page_id_t> *path, Page *ptr, KeyType key, page_id_t new_page_id,
+                         std::vector<Page *> *new_pages);
+
+  void BLinkRemove(const KeyType &key);
+
+  /** One level of a tree being bulk loaded: how many nodes its entries are spread over, and the node being filled. */
+  struct BulkLoadLevel {
+    size_t num_entries_;
+    size_t num_nodes_;
+    size_t node_index_{0};
+    int filled_{0};
+    /** The node being filled, pinned. */
+    Page *page_{nullptr};
+    /** Every node of the level so far, to delete them again if the load fails. */
+    std::vector<page_id_t> page_ids_{};
+
+    /** The first num_entries_ % num_nodes_ nodes get one entry more than the others. */
+    auto NodeSize() const -> int {
+      return static_cast<int>(num_entries_ / num_nodes_ + (node_index_ < num_entries_ % num_nodes_ ? 1 : 0));
+    }
+  };
+
+  static auto BulkLoadNodes(size_t num_entries, int target_size, int max_size, bool internal) -> size_t;
+
+  auto BulkLoadOpenNode(std::vector<BulkLoadLevel> *levels, size_t level, const KeyType &first_key) -> bool;
+
+  auto BulkLoadAddChild(std::vector<BulkLoadLevel> *levels, size_t level, const KeyType &key, page_id_t child_page_id)
+      -> page_id_t;
 
   auto InsertLeaf(LeafPage *page_ptr, int insert_pos, const KeyType &key, const ValueType &value,
                   Transaction *transaction = nullptr) -> bool;
 
+  auto ReserveSplitPages(Transaction *transaction, std::vector<Page *> *new_pages) -> bool;
+
+  auto AllocatePages(size_t count, std::vector<Page *> *new_pages) -> bool;
+
+  void FreePages(std::vector<Page *> *new_pages);
+
+  auto HeldPage(page_id_t page_id, Transaction *transaction) -> Page *;
+
+  void ReparentChild(page_id_t child_page_id, page_id_t parent_page_id, Transaction *transaction);
+
   auto InsertParent(BPlusTreePage *page_ptr, const KeyType &key, BPlusTreePage *new_page_ptr,
-                    Transaction *transaction = nullptr) -> bool;
+                    std::vector<Page *> *new_pages, Transaction *transaction = nullptr) -> bool;
 
   void ReallocatLeafPage(LeafPage *page_ptr, LeafPage *new_page_ptr, int insert_pos, const KeyType &key,
                          const ValueType &value, Transaction *transaction = nullptr);
@@ -115,6 +204,8 @@ class BPlusTree {
 
   void RemoveAllLock(Transaction *transaction, bool is_write = false);
 
+  void DeleteDeferredPages();
+
   static auto Ceil(int a, int b) -> int { return a % b == 0 ? a / b : (a / b + 1); }
 
   auto BinarySearch(int l, int r, const KeyType &key, InternalPage *ptr) -> int;
@@ -128,12 +219,19 @@ class BPlusTree {
   page_id_t root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
+  /** Bytes stored per key in the pages of the tree, see BPlusTreePage. */
+  int key_size_;
   int leaf_max_size_;
   int internal_max_size_;
+  BPlusTreeMode mode_;
+  /** Guards root_page_id_; writers that may change the root hold it in write mode from the start of the descent. */
   ReaderWriterLatch latch_;
-  std::mutex mtx_;
-  int insert_count_;
-  int remove_count_;
+  /** Pages merged away that were still pinned by a reader, to be deleted once it lets go of them. */
+  std::vector<page_id_t> deferred_deletes_;
+  /** Size of deferred_deletes_, read without the latch to skip it when it is empty. */
+  std::atomic<size_t> num_deferred_deletes_{0};
+  /** Guards deferred_deletes_. */
+  std::mutex deferred_latch_;
 };
 
 }  // namespace bustub
@@ -35,6 +35,12 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /** @brief Build the empty index out of the entries added to a sorter, see BPlusTree::BulkLoad(). */
+  auto BulkLoad(ExternalSorter<KeyType, ValueType, KeyComparator> *sorter, double fill_factor = INDEX_FILL_FACTOR)
+      -> bool;
+
+  auto GetComparator() const -> const KeyComparator & { return comparator_; }
+
   auto GetBeginIterator() -> INDEXITERATOR_TYPE;
 
   auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
@@ -0,0 +1,111 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sorter.h
+//
+// Identification: src/include/storage/index/external_sorter.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define EXTERNAL_SORTER_TYPE ExternalSorter<KeyType, ValueType, KeyComparator>
+
+/**
+ * ExternalSorter sorts the (key, value) entries an index is built from, with a bounded amount of memory.
+ *
+ * Entries are buffered until the buffer holds memory_limit bytes; the buffer is then sorted and written out to a
+ * temporary file as a run. Sort() merges the runs, at most MERGE_FAN_IN at a time, until a single sorted run is left,
+ * which Next() then reads back sequentially. When everything fits in memory, nothing is written to disk.
+ *
+ * Keys are unique in the output: of the entries with equal keys, only the first one added is kept, as
+ * BPlusTree::Insert() would keep it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class ExternalSorter {
+ public:
+  /**
+   * Maximum number of runs merged in one pass, which bounds the runs read at once, not the files open: a run is an
+   * anonymous temporary file that is gone once closed, so every run stays open until it is merged.
+   */
+  static constexpr size_t MERGE_FAN_IN = 64;
+
+  /**
+   * @brief Create a new ExternalSorter.
+   * @param comparator orders the keys
+   * @param memory_limit bytes of entries buffered before a run is written out
+   */
+  explicit ExternalSorter(const KeyComparator &comparator, size_t memory_limit = EXTERNAL_SORT_MEMORY);
+
+  DISALLOW_COPY_AND_MOVE(ExternalSorter);
+
+  ~ExternalSorter();
+
+  /** @brief Add an entry. Must not be called after Sort(). */
+  void Add(const KeyType &key, const ValueType &value);
+
+  /** @brief Sort the entries added so far, merging the runs written out if there are any. */
+  void Sort();
+
+  /**
+   * @brief Read the next entry in key order. Must be called after Sort().
+   * @return false once every entry was read
+   */
+  auto Next(MappingType *entry) -> bool;
+
+  /** @return the number of entries Next() returns, known after Sort() */
+  auto Size() const -> size_t { return size_; }
+
+  /** @return the number of runs written out to disk */
+  auto GetNumRuns() const -> size_t { return num_runs_; }
+
+ private:
+  /** The key and run of an entry in the merge heap; the same keys are taken from earlier runs first. */
+  struct MergeEntry {
+    MappingType entry_;
+    size_t run_;
+  };
+
+  void SortBuffer();
+
+  void SpillRun();
+
+  auto MergeRuns(const std::vector<FILE *> &runs, FILE *output) -> size_t;
+
+  static auto NewRunFile() -> FILE *;
+
+  static void WriteEntry(FILE *file, const MappingType &entry);
+
+  static auto ReadEntry(FILE *file, MappingType *entry) -> bool;
+
+  KeyComparator comparator_;
+  /** Entries the buffer holds before it is written out as a run. */
+  size_t max_buffered_;
+  /** Entries not written out yet; after Sort() without runs, the sorted output. */
+  std::vector<MappingType> buffer_;
+  /** Runs written out, in the order the entries were added. */
+  std::vector<FILE *> runs_;
+  /** Number of runs written out, not counting those written while merging. */
+  size_t num_runs_{0};
+  /** After Sort() with runs, the sorted output, read from the start. */
+  FILE *output_{nullptr};
+  /** Position of the next entry in buffer_ when the output is in memory. */
+  size_t next_{0};
+  size_t size_{0};
+  bool sorted_{false};
+};
+
+}  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
 
 #include "storage/table/tuple.h"
@@ -94,13 +95,31 @@ class GenericComparator {
     return 0;
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
+  GenericComparator(const GenericComparator &other)
+      : key_schema_{other.key_schema_}, integer_key_{other.integer_key_} {}
+
+  /**
+   * @return the number of leading bytes of a key the key schema can use. Keys are zeroed before a tuple is copied in,
+   * so the rest of a key is always zero, unless a column is stored out of line, past the fixed-size part of the tuple.
+   */
+  inline auto GetKeySize() const -> size_t {
+    if (key_schema_->GetUnlinedColumnCount() > 0) {
+      return KeySize;
+    }
+    return std::min<size_t>(KeySize, key_schema_->GetLength());
+  }
+
+  /** @return true if the key schema is a single INTEGER column, which keys hold as a plain int32_t */
+  inline auto IsIntegerKey() const -> bool { return integer_key_; }
 
   // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  explicit GenericComparator(Schema *key_schema)
+      : key_schema_(key_schema),
+        integer_key_(key_schema->GetColumnCount() == 1 && key_schema->GetColumn(0).GetType() == TypeId::INTEGER) {}
 
  private:
   Schema *key_schema_;
+  bool integer_key_;
 };
 
 }  // namespace bustub
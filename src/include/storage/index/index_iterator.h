@@ -46,10 +46,21 @@ class IndexIterator {
 
  private:
   // add your own private member variables here
+  void SkipExhaustedLeaves();
+
+  /** Read-ahead follows the chain of leaf pages. */
+  static auto NextLeafPage(Page *page) -> page_id_t;
+
   BufferPoolManager *buffer_pool_manager_;
+  /** The leaf the iterator is on, pinned. It is only read-latched while the iterator reads it. */
+  Page *page_;
   LeafPage *leaf_page_;
   page_id_t page_id_;
   int index_;
+  /** The entry operator*() returns, copied out of the leaf, which only stores a prefix of the key. */
+  MappingType entry_;
+  /** Number of leaves to move past before asking the buffer pool to read ahead again. */
+  size_t read_ahead_countdown_{0};
 };
 
 }  // namespace bustub
@@ -10,15 +10,17 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <algorithm>
 #include <queue>
 #include <vector>
 
+#include "storage/page/b_plus_tree_key_search.h"
 #include "storage/page/b_plus_tree_page.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
-#define INTERNAL_PAGE_HEADER_SIZE 24
+#define INTERNAL_PAGE_HEADER_SIZE (36 + sizeof(KeyType))
 #define INTERNAL_PAGE_SIZE ((BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
@@ -29,28 +31,71 @@ namespace bustub {
  * should ignore the first key.
  *
  * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ *  ---------------------------------------------------------------------------------------------
+ * | HEADER | KEY(1) | KEY(2) | ... | KEY(n) | (free) | PAGE_ID(1) | PAGE_ID(2) | ... | PAGE_ID(n) | (free)
+ *  ---------------------------------------------------------------------------------------------
+ * where every KEY takes the first KeySize bytes of the key, and the keys are kept apart from the page ids, as in leaf
+ * pages.
+ *
+ * The header adds to the common one the right link, the level and the high key, which only B-link mode maintains:
+ *  -----------------------------------------------------------------
+ * | CommonHeader (28) | NextPageId (4) | Level (4) | HighKey (key) |
+ *  -----------------------------------------------------------------
+ * The level counts up from the leaves, which are at level 0. The high key bounds the keys of the subtree from above,
+ * except on the last page of a level, whose next page is INVALID_PAGE_ID.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
  public:
   // must call initialize method after "create" a new node
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE);
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE,
+            int key_size = sizeof(KeyType));
+  // the number of entries that fit into a page with keys of key_size bytes
+  static auto Capacity(int key_size) -> int {
+    return static_cast<int>((BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (key_size + sizeof(ValueType)));
+  }
   auto KeyAt(int index) const -> KeyType;
   void SetKeyAt(int index, const KeyType &key);
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+  auto GetLevel() const -> int { return level_; }
+  void SetLevel(int level) { level_ = level; }
+  auto GetHighKey() const -> KeyType { return high_key_; }
+  void SetHighKey(const KeyType &high_key) { high_key_ = high_key; }
   auto ValueAt(int index) const -> ValueType;
   void SetValueAt(int index, const ValueType &value);
-  auto ArrPtr(int index) -> MappingType * { return array_ + index; }
-  static auto CellSize() -> size_t { return sizeof(MappingType); }
+  // the first index in [begin, end) whose key is not less than key, or greater than key if upper is set
+  auto KeyBound(int begin, int end, const KeyType &key, const KeyComparator &cmp, bool upper = false) const -> int {
+    return KeySearch<KeyType, KeyComparator>::Bound(KeyPtr(0), StoredKeySize(), begin, end, key, cmp, upper);
+  }
+  // copy num entries of src, from src_index on, to this page at index
+  void CopyEntries(const BPlusTreeInternalPage *src, int src_index, int index, int num);
   auto FindKeyPos(const KeyType &key, const KeyComparator &cmp) const -> int;
   auto FindValuePos(const ValueType &value) const -> int;
   void MoveBack(int index);
   void MoveForward(int index);
 
  private:
-  // Flexible array member for page data.
-  MappingType array_[1];
+  page_id_t next_page_id_;
+  int level_;
+  KeyType high_key_;
+
+  // A page read without a latch may hold anything: the key size and indexes are clamped so that entries are always
+  // read from within the page.
+  auto StoredKeySize() const -> size_t { return std::min<size_t>(GetKeySize(), sizeof(KeyType)); }
+  auto Slot(int index) const -> size_t {
+    return std::min<size_t>(index, Capacity(static_cast<int>(StoredKeySize())) - 1);
+  }
+  auto KeyPtr(int index) const -> const char * { return array_ + Slot(index) * StoredKeySize(); }
+  auto KeyPtr(int index) -> char * { return array_ + Slot(index) * StoredKeySize(); }
+  auto ValuePtr(int index) const -> const char * {
+    return array_ + Capacity(static_cast<int>(StoredKeySize())) * StoredKeySize() + Slot(index) * sizeof(ValueType);
+  }
+  auto ValuePtr(int index) -> char * {
+    return array_ + Capacity(static_cast<int>(StoredKeySize())) * StoredKeySize() + Slot(index) * sizeof(ValueType);
+  }
+
+  // Flexible array member for page data: the keys, then the values.
+  char array_[1];
 };
 }  // namespace bustub
@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_key_search.h
+//
+// Identification: src/include/storage/page/b_plus_tree_key_search.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+/**
+ * Binary search through the comparator over keys stored back to back, key_size bytes apart, with the rest of each key
+ * cut off (see BPlusTreePage).
+ * @return the first index in [begin, end) whose key is greater than or equal to key, or greater than key if upper is
+ * set; end if there is none
+ */
+template <typename KeyType, typename KeyComparator>
+auto BinarySearchKeys(const char *keys, size_t key_size, int begin, int end, const KeyType &key,
+                      const KeyComparator &cmp, bool upper) -> int {
+  while (begin < end) {
+    int middle = begin + (end - begin) / 2;
+    KeyType middle_key{};
+    memcpy(reinterpret_cast<void *>(&middle_key), keys + middle * key_size, key_size);
+    int res = cmp(middle_key, key);
+    if (res < 0 || (upper && res == 0)) {
+      begin = middle + 1;
+    } else {
+      end = middle;
+    }
+  }
+  return begin;
+}
+
+/**
+ * KeySearch finds where a key falls among the sorted keys of a B+ tree page. In general it is BinarySearchKeys(); it
+ * is specialized at compile time for the keys of BPlusTreeIndexForOneIntegerColumn, see below.
+ */
+template <typename KeyType, typename KeyComparator>
+class KeySearch {
+ public:
+  /** @return see BinarySearchKeys() */
+  static auto Bound(const char *keys, size_t key_size, int begin, int end, const KeyType &key,
+                    const KeyComparator &cmp, bool upper) -> int {
+    return BinarySearchKeys(keys, key_size, begin, end, key, cmp, upper);
+  }
+};
+
+/**
+ * Keys of a single INTEGER column are plain int32_t values stored back to back, so they are compared as integers
+ * instead of being deserialized into Values column by column: a binary search narrows the range down to a block of
+ * keys, whose keys below the bound are then counted with SIMD compares. Other schemas of the same key size still go
+ * through the comparator. A NULL integer is the smallest int32_t, and sorts first.
+ */
+template <>
+class KeySearch<GenericKey<4>, GenericComparator<4>> {
+ public:
+  /** Keys left to the SIMD count once the binary search narrowed the range down. */
+  static constexpr int SEARCH_BLOCK = 32;
+
+  static auto Bound(const char *keys, size_t key_size, int begin, int end, const GenericKey<4> &key,
+                    const GenericComparator<4> &cmp, bool upper) -> int {
+    if (!cmp.IsIntegerKey() || key_size != sizeof(int32_t)) {
+      return BinarySearchKeys(keys, key_size, begin, end, key, cmp, upper);
+    }
+    int32_t target;
+    memcpy(&target, key.data_, sizeof(int32_t));
+    return CountBelow(keys, begin, end, target, upper);
+  }
+
+  /**
+   * @return begin plus the number of keys in [begin, end) less than target, or less than or equal to it if or_equal is
+   * set; the keys are sorted, so that is also where target falls
+   */
+  static auto CountBelow(const char *keys, int begin, int end, int32_t target, bool or_equal) -> int;
+};
+
+}  // namespace bustub
@@ -10,15 +10,17 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
+#include "storage/page/b_plus_tree_key_search.h"
 #include "storage/page/b_plus_tree_page.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
-#define LEAF_PAGE_HEADER_SIZE 28
+#define LEAF_PAGE_HEADER_SIZE (32 + sizeof(KeyType))
 #define LEAF_PAGE_SIZE ((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
 
 /**
@@ -27,33 +29,50 @@ namespace bustub {
  * page. Only support unique key.
  *
  * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
+ *  ---------------------------------------------------------------------------------
+ * | HEADER | KEY(1) | KEY(2) | ... | KEY(n) | (free) | RID(1) | RID(2) | ... | RID(n) | (free)
+ *  ---------------------------------------------------------------------------------
+ * where every KEY takes the first KeySize bytes of the key, so that LEAF_PAGE_SIZE is only the capacity for keys
+ * stored whole. The keys are kept apart from the record ids, which start after room for Capacity() keys, so that a
+ * search only reads the keys.
  *
- *  Header format (size in byte, 28 bytes in total):
+ *  Header format (size in byte, 32 bytes + key size in total):
  *  ---------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
- *  -----------------------------------------------
- * | ParentPageId (4) | PageId (4) | NextPageId (4)
- *  -----------------------------------------------
+ *  ---------------------------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | KeySize (4) | NextPageId (4) | HighKey (key) |
+ *  ---------------------------------------------------------------------------------
+ *
+ * In B-link mode the next page is the right link and the high key bounds the keys of the page from above; the last
+ * leaf, whose next page is INVALID_PAGE_ID, has no bound. Latch crabbing does not maintain the high key.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE);
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE,
+            int key_size = sizeof(KeyType));
+  // the number of entries that fit into a page with keys of key_size bytes
+  static auto Capacity(int key_size) -> int {
+    return static_cast<int>((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (key_size + sizeof(ValueType)));
+  }
   // helper methods
   auto GetNextPageId() const -> page_id_t;
   void SetNextPageId(page_id_t next_page_id);
+  auto GetHighKey() const -> KeyType { return high_key_; }
+  void SetHighKey(const KeyType &high_key) { high_key_ = high_key; }
   auto KeyAt(int index) const -> KeyType;
   auto ValueAt(int index) const -> ValueType;
   void SetKeyAt(int index, const KeyType &key);
   void SetValueAt(int index, const ValueType &value);
-  static auto CellSize() -> size_t { return sizeof(MappingType); }
-  auto ArrPtr(int index) -> MappingType * { return array_ + index; }
+  // the first index in [begin, end) whose key is not less than key, or greater than key if upper is set
+  auto KeyBound(int begin, int end, const KeyType &key, const KeyComparator &cmp, bool upper = false) const -> int {
+    return KeySearch<KeyType, KeyComparator>::Bound(KeyPtr(0), StoredKeySize(), begin, end, key, cmp, upper);
+  }
+  // copy num entries of src, from src_index on, to this page at index
+  void CopyEntries(const BPlusTreeLeafPage *src, int src_index, int index, int num);
   auto FindInsertPos(const KeyType &key, const KeyComparator &cmp) const -> int;
   auto FindKeyPos(const KeyType &key, const KeyComparator &cmp) const -> int;
   void MoveBack(int index);
@@ -61,7 +80,24 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
  private:
   page_id_t next_page_id_;
-  // Flexible array member for page data.
-  MappingType array_[1];
+  KeyType high_key_;
+
+  // A page read without a latch may hold anything: the key size and indexes are clamped so that entries are always
+  // read from within the page.
+  auto StoredKeySize() const -> size_t { return std::min<size_t>(GetKeySize(), sizeof(KeyType)); }
+  auto Slot(int index) const -> size_t {
+    return std::min<size_t>(index, Capacity(static_cast<int>(StoredKeySize())) - 1);
+  }
+  auto KeyPtr(int index) const -> const char * { return array_ + Slot(index) * StoredKeySize(); }
+  auto KeyPtr(int index) -> char * { return array_ + Slot(index) * StoredKeySize(); }
+  auto ValuePtr(int index) const -> const char * {
+    return array_ + Capacity(static_cast<int>(StoredKeySize())) * StoredKeySize() + Slot(index) * sizeof(ValueType);
+  }
+  auto ValuePtr(int index) -> char * {
+    return array_ + Capacity(static_cast<int>(StoredKeySize())) * StoredKeySize() + Slot(index) * sizeof(ValueType);
+  }
+
+  // Flexible array member for page data: the keys, then the values.
+  char array_[1];
 };
 }  // namespace bustub
@@ -33,12 +33,15 @@ enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
  * It actually serves as a header part for each B+ tree page and
  * contains information shared by both leaf page and internal page.
  *
- * Header format (size in byte, 24 bytes in total):
+ * Header format (size in byte, 28 bytes in total):
  * ----------------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  * ----------------------------------------------------------------------------
- * | ParentPageId (4) | PageId(4) |
+ * | ParentPageId (4) | PageId(4) | KeySize (4) |
  * ----------------------------------------------------------------------------
+ *
+ * KeySize is the number of leading bytes of every key the page stores: the key schema never uses the rest of the
+ * fixed-size key, which is always zero, so it is cut off instead of taking space in every entry.
  */
 class BPlusTreePage {
  public:
@@ -64,6 +67,9 @@ class BPlusTreePage {
 
   void SetLSN(lsn_t lsn = INVALID_LSN);
 
+  auto GetKeySize() const -> int;
+  void SetKeySize(int key_size);
+
  private:
   // member variable, attributes that both internal and leaf page share
   IndexPageType page_type_ __attribute__((__unused__));
@@ -72,6 +78,7 @@ class BPlusTreePage {
   int max_size_ __attribute__((__unused__));
   page_id_t parent_page_id_ __attribute__((__unused__));
   page_id_t page_id_ __attribute__((__unused__));
+  int key_size_ __attribute__((__unused__));
 };
 
 }  // namespace bustub
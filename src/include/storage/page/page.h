@@ -12,11 +12,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <memory>
 
 #include "common/config.h"
-#include "common/rwlatch.h"
+#include "common/hybrid_latch.h"
 
 namespace bustub {
 
@@ -24,14 +26,17 @@ namespace bustub {
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * The data itself lives elsewhere. Pages are cache-line aligned, and everything the buffer pool's hit path and
+ * optimistic readers look at (data pointer, page id, pin count, dirty flag, latch version) fits in the first line.
  */
-class Page {
+class alignas(CACHE_LINE_SIZE) Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManagerInstance;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. Allocates the page data and zeros it out. */
+  Page() : data_(new char[BUSTUB_PAGE_SIZE]), owned_data_(data_) { ResetMemory(); }
 
   /** Default destructor. */
   ~Page() = default;
@@ -57,6 +62,19 @@ class Page {
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
 
+  /** Acquire the page read latch if that does not block. @return true if the latch was acquired */
+  inline auto TryRLatch() -> bool { return rwlatch_.TryRLock(); }
+
+  /**
+   * Start reading the page optimistically, without latching it. See HybridLatch.
+   * @param[out] version the version to validate the read against
+   * @return false if the page is write-latched
+   */
+  inline auto TryOptimisticRead(uint64_t *version) const -> bool { return rwlatch_.TryOptimisticRead(version); }
+
+  /** @return true if the page did not change since TryOptimisticRead() returned version */
+  inline auto ValidateOptimisticRead(uint64_t version) const -> bool { return rwlatch_.Validate(version); }
+
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
@@ -78,16 +96,29 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, BUSTUB_PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[BUSTUB_PAGE_SIZE]{};
-  /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  /**
+   * Constructor of the frames of a buffer pool, whose data lives in memory the buffer pool owns. The memory must
+   * already be zeroed; it is not touched here, so that frames that are never used cost no memory.
+   */
+  explicit Page(char *data) : data_(data) {}
+
+  /** The actual data of the page, BUSTUB_PAGE_SIZE bytes. */
+  char *data_;
+  /**
+   * The ID of this page. The buffer pool reads the page metadata without holding its latch on the hit path, so it is
+   * kept in atomics.
+   */
+  std::atomic<page_id_t> page_id_ = INVALID_PAGE_ID;
+  /** The pin count of this page, or -1 while the buffer pool is taking the frame over for another page. */
+  std::atomic<int> pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
-  /** Page latch. */
-  ReaderWriterLatch rwlatch_;
+  std::atomic<bool> is_dirty_ = false;
+  /** The page data, if the page allocated it itself. */
+  std::unique_ptr<char[]> owned_data_;
+  /** Page latch. The buffer pool invalidates its optimistic readers when the frame is given to another page. */
+  HybridLatch rwlatch_;
 };
 
+static_assert(sizeof(Page) <= 2 * CACHE_LINE_SIZE, "page metadata should take two cache lines");
+
 }  // namespace bustub
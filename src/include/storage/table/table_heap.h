@@ -12,6 +12,9 @@
 
 #pragma once
 
+#include <memory>
+
+#include "buffer/buffer_access_strategy.h"
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
@@ -99,8 +102,12 @@ class TableHeap {
    */
   auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock = true) -> bool;
 
-  /** @return the begin iterator of this table */
-  auto Begin(Transaction *txn) -> TableIterator;
+  /**
+   * @param txn transaction performing the scan
+   * @param strategy the buffer access strategy to fetch the pages of the scan with, nullptr for the default one
+   * @return the begin iterator of this table
+   */
+  auto Begin(Transaction *txn, std::shared_ptr<BufferAccessStrategy> strategy = nullptr) -> TableIterator;
 
   /** @return the end iterator of this table */
   auto End() -> TableIterator;
@@ -13,7 +13,9 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -29,10 +31,15 @@ class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_),
+        read_ahead_countdown_(other.read_ahead_countdown_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -54,6 +61,8 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
+    read_ahead_countdown_ = other.read_ahead_countdown_;
     return *this;
   }
 
@@ -61,6 +70,10 @@ class TableIterator {
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** The buffer access strategy the pages of the scan are fetched with, nullptr for the default one. */
+  std::shared_ptr<BufferAccessStrategy> strategy_;
+  /** Number of pages to move past before asking the buffer pool to read ahead again. */
+  size_t read_ahead_countdown_{0};
 };
 
 }  // namespace bustub
@@ -10,33 +10,60 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <mutex>  // NOLINT
+#include <new>
 #include <string>
 #include <thread>  // NOLINT
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/macros.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
 static char *buffer_used;
 
+namespace {
+
+/** A page-sized buffer suitable for direct I/O, for callers whose own buffer is not. */
+struct BounceBuffer {
+  BounceBuffer() : data_(static_cast<char *>(std::aligned_alloc(DiskManager::DIRECT_IO_ALIGNMENT, BUSTUB_PAGE_SIZE))) {
+    if (data_ == nullptr) {
+      throw std::bad_alloc();
+    }
+  }
+  ~BounceBuffer() { std::free(data_); }  // NOLINT
+  DISALLOW_COPY_AND_MOVE(BounceBuffer);
+  char *data_;
+};
+
+}  // namespace
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io) : file_name_(db_file) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  fsm_name_ = file_name_.substr(0, n) + ".fsm";
 
   log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
   // directory or file does not exist
@@ -49,27 +76,54 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
     }
   }
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+  if (direct_io) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);  // NOLINT
+    if (db_fd_ < 0 && errno == EINVAL) {
+      LOG_DEBUG("the file system does not support direct I/O, falling back to buffered I/O");
     }
+    direct_io_ = db_fd_ >= 0;
+  }
+  if (db_fd_ < 0) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);  // NOLINT
+  }
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) == 0) {
+    db_file_size_ = static_cast<uint64_t>(stat_buf.st_size);
+  }
+  if (!free_space_map_.Load(fsm_name_, GetNumPages())) {
+    // Left behind by an older database file of the same name, it must not be picked up once this one has grown.
+    remove(fsm_name_.c_str());
   }
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() {
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+}
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  {
-    std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+  if (db_fd_ >= 0) {
+    {
+      // The reserved pages are saved as used, put them back so that they are not lost.
+      std::scoped_lock lock(reserve_latch_);
+      for (auto &entry : reserved_pages_) {
+        for (page_id_t page_id : entry.second) {
+          free_space_map_.Free(page_id);
+        }
+      }
+      reserved_pages_.clear();
+    }
+    Sync();
+    close(db_fd_);
+    db_fd_ = -1;
   }
   log_io_.close();
 }
@@ -77,49 +131,213 @@ void DiskManager::ShutDown() {
 /**
  * Write the contents of the specified page into disk file
  */
-void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
-  // set write cursor to offset
+auto DiskManager::WritePage(page_id_t page_id, const char *page_data) -> bool {
+  if (NeedsBounceBuffer(page_data)) {
+    BounceBuffer bounce;
+    memcpy(bounce.data_, page_data, BUSTUB_PAGE_SIZE);
+    return WritePage(page_id, bounce.data_);
+  }
+  uint64_t offset = static_cast<uint64_t>(page_id) * BUSTUB_PAGE_SIZE;
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, BUSTUB_PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
+  size_t written = 0;
+  while (written < BUSTUB_PAGE_SIZE) {
+    ssize_t rc = pwrite(db_fd_, page_data + written, BUSTUB_PAGE_SIZE - written, offset + written);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (rc <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return false;
+    }
+    written += rc;
+  }
+  ExtendFileSize(offset + BUSTUB_PAGE_SIZE);
+  return true;
+}
+
+/**
+ * Write the contents of adjacent pages into disk file
+ */
+void DiskManager::WritePages(page_id_t start_page_id, const std::vector<const char *> &pages) {
+  bool bounce = std::any_of(pages.begin(), pages.end(), [this](const char *page) { return NeedsBounceBuffer(page); });
+  if (db_fd_ < 0 || bounce) {
+    // Subclasses that keep the pages elsewhere only know how to write them one by one, and so does direct I/O from
+    // unaligned buffers.
+    for (size_t i = 0; i < pages.size(); i++) {
+      WritePage(start_page_id + static_cast<page_id_t>(i), pages[i]);
+    }
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  std::vector<iovec> iov(pages.size());
+  for (size_t i = 0; i < pages.size(); i++) {
+    iov[i].iov_base = const_cast<char *>(pages[i]);  // NOLINT
+    iov[i].iov_len = BUSTUB_PAGE_SIZE;
+  }
+  uint64_t offset = static_cast<uint64_t>(start_page_id) * BUSTUB_PAGE_SIZE;
+  size_t done = 0;
+  while (done < iov.size()) {
+    ssize_t rc = pwritev(db_fd_, &iov[done], static_cast<int>(std::min<size_t>(iov.size() - done, IOV_MAX)), offset);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    offset += rc;
+    // Skip the pages written completely, and the written part of a page written partially.
+    while (rc > 0) {
+      if (static_cast<size_t>(rc) >= iov[done].iov_len) {
+        rc -= iov[done].iov_len;
+        done++;
+      } else {
+        iov[done].iov_base = static_cast<char *>(iov[done].iov_base) + rc;
+        iov[done].iov_len -= rc;
+        rc = 0;
+      }
+    }
+  }
+  num_writes_ += static_cast<int>(pages.size());
+  ExtendFileSize(offset);
+}
+
+void DiskManager::ExtendFileSize(uint64_t end) {
+  // Concurrent writers race to extend the file, so only ever move the cached size forwards.
+  uint64_t size = db_file_size_;
+  while (size < end && !db_file_size_.compare_exchange_weak(size, end)) {
+  }
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
-void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * BUSTUB_PAGE_SIZE;
+auto DiskManager::ReadPage(page_id_t page_id, char *page_data) -> bool {
+  if (NeedsBounceBuffer(page_data)) {
+    BounceBuffer bounce;
+    bool success = ReadPage(page_id, bounce.data_);
+    memcpy(page_data, bounce.data_, BUSTUB_PAGE_SIZE);
+    return success;
+  }
+  uint64_t offset = static_cast<uint64_t>(page_id) * BUSTUB_PAGE_SIZE;
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (offset >= db_file_size_) {
     LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, BUSTUB_PAGE_SIZE);
-    if (db_io_.bad()) {
+    memset(page_data, 0, BUSTUB_PAGE_SIZE);
+    return true;
+  }
+  size_t read_count = 0;
+  while (read_count < BUSTUB_PAGE_SIZE) {
+    ssize_t rc = pread(db_fd_, page_data + read_count, BUSTUB_PAGE_SIZE - read_count, offset + read_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0) {
       LOG_DEBUG("I/O error while reading");
-      return;
+      return false;
     }
-    // if file ends before reading BUSTUB_PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < BUSTUB_PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+    if (rc == 0) {
+      break;
     }
+    read_count += rc;
   }
+  // if file ends before reading BUSTUB_PAGE_SIZE
+  if (read_count < BUSTUB_PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+  }
+  return true;
+}
+
+/**
+ * Carry out a batch of requests synchronously
+ */
+void DiskManager::Schedule(std::vector<DiskRequest> *requests) {
+  for (auto &request : *requests) {
+    bool success =
+        request.is_write_ ? WritePage(request.page_id_, request.data_) : ReadPage(request.page_id_, request.data_);
+    request.callback_.set_value(success);
+  }
+  requests->clear();
+}
+
+auto DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<bool> {
+  std::vector<DiskRequest> requests;
+  requests.push_back(DiskRequest{false, page_data, page_id, {}});
+  auto future = requests.back().callback_.get_future();
+  Schedule(&requests);
+  return future;
+}
+
+auto DiskManager::WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<bool> {
+  // A write only ever reads from data_.
+  std::vector<DiskRequest> requests;
+  requests.push_back(DiskRequest{true, const_cast<char *>(page_data), page_id, {}});  // NOLINT
+  auto future = requests.back().callback_.get_future();
+  Schedule(&requests);
+  return future;
+}
+
+/**
+ * Flush the db file to stable storage
+ */
+void DiskManager::Sync() {
+  if (db_fd_ < 0) {
+    return;
+  }
+  num_syncs_ += 1;
+  if (fsync(db_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+  }
+  free_space_map_.Save(fsm_name_, GetNumPages());
+}
+
+void DiskManager::DeallocatePage(page_id_t page_id) { free_space_map_.Free(page_id); }
+
+auto DiskManager::ReuseFreePage(page_id_t residue, page_id_t modulus) -> page_id_t {
+  std::scoped_lock lock(reserve_latch_);
+  auto &reserved = reserved_pages_[{residue, modulus}];
+  if (reserved.empty()) {
+    for (int i = 0; i < FREE_PAGE_BATCH; i++) {
+      page_id_t page_id = free_space_map_.Allocate(residue, modulus);
+      if (page_id == INVALID_PAGE_ID) {
+        break;
+      }
+      reserved.push_back(page_id);
+    }
+    // The map on disk must stop listing the pages before any of them is written again: after a crash, a map that
+    // still has them free would hand them out to a second owner.
+    if (!reserved.empty() && !fsm_name_.empty() && !free_space_map_.Save(fsm_name_, GetNumPages())) {
+      for (page_id_t page_id : reserved) {
+        free_space_map_.Free(page_id);
+      }
+      reserved.clear();
+    }
+    std::reverse(reserved.begin(), reserved.end());
+  }
+  if (reserved.empty()) {
+    return INVALID_PAGE_ID;
+  }
+  page_id_t page_id = reserved.back();
+  reserved.pop_back();
+  return page_id;
+}
+
+void DiskManager::ReturnFreePage(page_id_t page_id, page_id_t modulus) {
+  std::scoped_lock lock(reserve_latch_);
+  auto &reserved = reserved_pages_[{page_id % modulus, modulus}];
+  reserved.insert(std::upper_bound(reserved.begin(), reserved.end(), page_id, std::greater<>()), page_id);
+}
+
+auto DiskManager::GetNumPages() -> page_id_t { return static_cast<page_id_t>(db_file_size_ / BUSTUB_PAGE_SIZE); }
+
+auto DiskManager::GetNumFreePages() -> size_t {
+  std::scoped_lock lock(reserve_latch_);
+  size_t num_free = free_space_map_.GetNumFree();
+  for (auto &entry : reserved_pages_) {
+    num_free += entry.second.size();
+  }
+  return num_free;
 }
 
 /**
@@ -194,6 +412,11 @@ auto DiskManager::GetNumFlushes() const -> int { return num_flushes_; }
  */
 auto DiskManager::GetNumWrites() const -> int { return num_writes_; }
 
+/**
+ * Returns number of syncs of the db file made so far
+ */
+auto DiskManager::GetNumSyncs() const -> int { return num_syncs_; }
+
 /**
  * Returns true if the log is currently being flushed
  */
@@ -0,0 +1,276 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_uring.cpp
+//
+// Identification: src/storage/disk/disk_manager_uring.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_uring.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+
+// There is no liburing in the build environment, the few system calls needed are issued directly.
+auto IoUringSetup(uint32_t entries, io_uring_params *params) -> int {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+auto IoUringEnter(int ring_fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags) -> int {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+template <typename T>
+auto RingField(void *ring, uint32_t offset) -> T * {
+  return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+
+}  // namespace
+
+DiskManagerUring::DiskManagerUring(const std::string &db_file, uint32_t queue_depth, bool direct_io)
+    : DiskManager(db_file, direct_io) {
+  if (db_fd_ < 0) {
+    return;
+  }
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  ring_fd_ = IoUringSetup(queue_depth, &params);
+  if (ring_fd_ < 0) {
+    LOG_DEBUG("io_uring is not available, falling back to synchronous I/O");
+    return;
+  }
+  if (!MapRings(params)) {
+    LOG_DEBUG("could not map the io_uring rings, falling back to synchronous I/O");
+    close(ring_fd_);
+    ring_fd_ = -1;
+    return;
+  }
+  sq_entries_ = params.sq_entries;
+  completion_thread_ = std::thread([this] { RunCompletions(); });
+}
+
+DiskManagerUring::~DiskManagerUring() {
+  if (ring_fd_ < 0) {
+    return;
+  }
+  {
+    // Wake the completion thread up with a no-op, it drains the requests still in flight and exits. The no-op is not
+    // counted as in flight, the completion ring has room for twice the submission entries.
+    std::scoped_lock lock(submit_latch_);
+    QueueEntry(IORING_OP_NOP, nullptr, INVALID_PAGE_ID, 0);
+    Submit(1);
+  }
+  completion_thread_.join();
+  munmap(sqes_, sqes_size_);
+  if (cq_ring_ptr_ != sq_ring_ptr_) {
+    munmap(cq_ring_ptr_, cq_ring_size_);
+  }
+  munmap(sq_ring_ptr_, sq_ring_size_);
+  close(ring_fd_);
+}
+
+auto DiskManagerUring::MapRings(const io_uring_params &params) -> bool {
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ptr_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                      IORING_OFF_SQ_RING);
+  if (sq_ring_ptr_ == MAP_FAILED) {
+    return false;
+  }
+  if (single_mmap) {
+    cq_ring_ptr_ = sq_ring_ptr_;
+  } else {
+    cq_ring_ptr_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                        IORING_OFF_CQ_RING);
+    if (cq_ring_ptr_ == MAP_FAILED) {
+      munmap(sq_ring_ptr_, sq_ring_size_);
+      return false;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    if (cq_ring_ptr_ != sq_ring_ptr_) {
+      munmap(cq_ring_ptr_, cq_ring_size_);
+    }
+    munmap(sq_ring_ptr_, sq_ring_size_);
+    return false;
+  }
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+  sq_tail_ = RingField<unsigned>(sq_ring_ptr_, params.sq_off.tail);
+  sq_mask_ = RingField<unsigned>(sq_ring_ptr_, params.sq_off.ring_mask);
+  sq_array_ = RingField<unsigned>(sq_ring_ptr_, params.sq_off.array);
+  cq_head_ = RingField<unsigned>(cq_ring_ptr_, params.cq_off.head);
+  cq_tail_ = RingField<unsigned>(cq_ring_ptr_, params.cq_off.tail);
+  cq_mask_ = RingField<unsigned>(cq_ring_ptr_, params.cq_off.ring_mask);
+  cqes_ = RingField<io_uring_cqe>(cq_ring_ptr_, params.cq_off.cqes);
+  return true;
+}
+
+void DiskManagerUring::Schedule(std::vector<DiskRequest> *requests) {
+  if (ring_fd_ < 0) {
+    DiskManager::Schedule(requests);
+    return;
+  }
+  std::unique_lock lock(submit_latch_);
+  uint32_t queued = 0;
+  for (auto &request : *requests) {
+    if (NeedsBounceBuffer(request.data_)) {
+      bool success =
+          request.is_write_ ? WritePage(request.page_id_, request.data_) : ReadPage(request.page_id_, request.data_);
+      request.callback_.set_value(success);
+      continue;
+    }
+    // Every submitted request needs a free completion slot. Hand the entries queued so far over before waiting, or
+    // the requests we wait for could be our own.
+    while (in_flight_ + queued == sq_entries_) {
+      if (queued > 0) {
+        in_flight_ += queued;
+        Submit(queued);
+        queued = 0;
+      } else {
+        slot_cv_.wait(lock);
+      }
+    }
+    auto *pending = new DiskRequest(std::move(request));
+    QueueEntry(pending->is_write_ ? IORING_OP_WRITE : IORING_OP_READ, pending->data_, pending->page_id_,
+               reinterpret_cast<uint64_t>(pending));
+    queued++;
+  }
+  if (queued > 0) {
+    in_flight_ += queued;
+    Submit(queued);
+  }
+  requests->clear();
+}
+
+void DiskManagerUring::QueueEntry(uint8_t opcode, char *data, page_id_t page_id, uint64_t user_data) {
+  // Entries are handed over to the kernel right after being queued, so the submission ring is never full here.
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  io_uring_sqe *sqe = &sqes_[index];
+  std::memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = db_fd_;
+  sqe->addr = reinterpret_cast<uint64_t>(data);
+  sqe->len = opcode == IORING_OP_NOP ? 0 : BUSTUB_PAGE_SIZE;
+  sqe->off = opcode == IORING_OP_NOP ? 0 : static_cast<uint64_t>(page_id) * BUSTUB_PAGE_SIZE;
+  sqe->user_data = user_data;
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+}
+
+void DiskManagerUring::Submit(uint32_t count) {
+  while (count > 0) {
+    int submitted = IoUringEnter(ring_fd_, count, 0, 0);
+    if (submitted < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+        std::this_thread::yield();
+        continue;
+      }
+      LOG_DEBUG("io_uring_enter failed: %s", strerror(errno));
+      // The kernel consumes the submission ring in order, so the entries it did not take are the last count ones.
+      // Take them back and carry their requests out synchronously, or their callers would wait for them forever.
+      unsigned tail = *sq_tail_ - count;
+      std::vector<DiskRequest *> unsubmitted;
+      for (unsigned entry = tail; entry != *sq_tail_; entry++) {
+        uint64_t user_data = sqes_[entry & *sq_mask_].user_data;
+        if (user_data != 0) {
+          unsubmitted.push_back(reinterpret_cast<DiskRequest *>(user_data));
+        }
+      }
+      __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+      in_flight_ -= static_cast<uint32_t>(unsubmitted.size());
+      for (auto *request : unsubmitted) {
+        Complete(request, -EAGAIN);
+      }
+      slot_cv_.notify_all();
+      return;
+    }
+    count -= static_cast<uint32_t>(submitted);
+  }
+}
+
+void DiskManagerUring::RunCompletions() {
+  bool stop = false;
+  while (true) {
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+      if (stop) {
+        std::scoped_lock lock(submit_latch_);
+        if (in_flight_ == 0) {
+          return;
+        }
+      }
+      IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+      continue;
+    }
+    uint32_t reaped = 0;
+    for (; head != tail; head++) {
+      io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+      if (cqe->user_data == 0) {
+        stop = true;
+      } else {
+        Complete(reinterpret_cast<DiskRequest *>(cqe->user_data), cqe->res);
+        reaped++;
+      }
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    {
+      std::scoped_lock lock(submit_latch_);
+      in_flight_ -= reaped;
+    }
+    slot_cv_.notify_all();
+  }
+}
+
+void DiskManagerUring::Complete(DiskRequest *request, int result) {
+  bool success = true;
+  if (result == BUSTUB_PAGE_SIZE) {
+    if (request->is_write_) {
+      num_writes_ += 1;
+      ExtendFileSize(static_cast<uint64_t>(request->page_id_ + 1) * BUSTUB_PAGE_SIZE);
+    }
+  } else if (result == -EINTR || result == -EAGAIN) {
+    // Interrupted requests are rare, finish them off synchronously.
+    success = request->is_write_ ? WritePage(request->page_id_, request->data_)
+                                 : ReadPage(request->page_id_, request->data_);
+  } else if (result >= 0 && request->is_write_) {
+    success = WritePage(request->page_id_, request->data_);
+  } else if (result >= 0) {
+    // A short read: the page is (partly) past the end of the file, or the kernel stopped early.
+    uint64_t end = static_cast<uint64_t>(request->page_id_) * BUSTUB_PAGE_SIZE + result;
+    if (end >= db_file_size_) {
+      std::memset(request->data_ + result, 0, BUSTUB_PAGE_SIZE - result);
+    } else {
+      success = ReadPage(request->page_id_, request->data_);
+    }
+  } else {
+    LOG_DEBUG("I/O error on page %d: %s", request->page_id_, strerror(-result));
+    success = false;
+  }
+  request->callback_.set_value(success);
+  delete request;
+}
+
+}  // namespace bustub
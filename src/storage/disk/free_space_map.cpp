@@ -0,0 +1,193 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/disk/free_space_map.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/free_space_map.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+
+#include "common/logger.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+namespace {
+
+auto WriteAll(int fd, const void *data, size_t size) -> bool {
+  const char *bytes = static_cast<const char *>(data);
+  while (size > 0) {
+    ssize_t rc = write(fd, bytes, size);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      return false;
+    }
+    bytes += rc;
+    size -= rc;
+  }
+  return true;
+}
+
+auto ReadAll(int fd, void *data, size_t size) -> bool {
+  char *bytes = static_cast<char *>(data);
+  while (size > 0) {
+    ssize_t rc = read(fd, bytes, size);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      return false;
+    }
+    bytes += rc;
+    size -= rc;
+  }
+  return true;
+}
+
+/** Sync the directory of a file, which makes a rename onto the file durable. */
+auto SyncDirectory(const std::string &file_name) -> bool {
+  size_t slash = file_name.rfind('/');
+  std::string dir_name = slash == std::string::npos ? "." : file_name.substr(0, std::max<size_t>(slash, 1));
+  int fd = open(dir_name.c_str(), O_RDONLY | O_DIRECTORY);  // NOLINT
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = fsync(fd) == 0;
+  close(fd);
+  return ok;
+}
+
+}  // namespace
+
+void FreeSpaceMap::Free(page_id_t page_id) {
+  BUSTUB_ASSERT(page_id >= 0, "Invalid page id");
+  std::scoped_lock lock(latch_);
+  size_t word = static_cast<size_t>(page_id) / 64;
+  uint64_t bit = static_cast<uint64_t>(1) << (page_id % 64);
+  if (word >= words_.size()) {
+    words_.resize(word + 1, 0);
+  }
+  if ((words_[word] & bit) != 0) {
+    return;
+  }
+  words_[word] |= bit;
+  num_free_++;
+  first_word_ = std::min(first_word_, word);
+  dirty_ = true;
+}
+
+auto FreeSpaceMap::Allocate(page_id_t residue, page_id_t modulus) -> page_id_t {
+  std::scoped_lock lock(latch_);
+  if (num_free_ == 0) {
+    return INVALID_PAGE_ID;
+  }
+  // Skip the leading empty words for good, whatever the residue class.
+  while (first_word_ < words_.size() && words_[first_word_] == 0) {
+    first_word_++;
+  }
+  for (size_t word = first_word_; word < words_.size(); word++) {
+    uint64_t bits = words_[word];
+    while (bits != 0) {
+      int offset = __builtin_ctzll(bits);
+      auto page_id = static_cast<page_id_t>(word * 64 + offset);
+      if (page_id % modulus == residue) {
+        words_[word] &= ~(static_cast<uint64_t>(1) << offset);
+        num_free_--;
+        dirty_ = true;
+        return page_id;
+      }
+      bits &= bits - 1;
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+auto FreeSpaceMap::IsFree(page_id_t page_id) -> bool {
+  std::scoped_lock lock(latch_);
+  size_t word = static_cast<size_t>(page_id) / 64;
+  return word < words_.size() && (words_[word] & (static_cast<uint64_t>(1) << (page_id % 64))) != 0;
+}
+
+auto FreeSpaceMap::GetNumSaves() -> size_t {
+  std::scoped_lock lock(latch_);
+  return num_saves_;
+}
+
+auto FreeSpaceMap::GetNumFree() -> size_t {
+  std::scoped_lock lock(latch_);
+  return num_free_;
+}
+
+auto FreeSpaceMap::Save(const std::string &file_name, page_id_t num_pages) -> bool {
+  std::scoped_lock lock(latch_);
+  if (!dirty_) {
+    return true;
+  }
+  // Write a new file and rename it over the old one, so that a crash leaves either the old or the new map behind.
+  std::string tmp_name = file_name + ".tmp";
+  int fd = open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);  // NOLINT
+  if (fd < 0) {
+    LOG_DEBUG("can't open free space map file");
+    return false;
+  }
+  FileHeader header{MAGIC, static_cast<uint32_t>(num_pages), words_.size()};
+  bool ok = WriteAll(fd, &header, sizeof(header)) && WriteAll(fd, words_.data(), words_.size() * sizeof(uint64_t)) &&
+            fsync(fd) == 0;
+  close(fd);
+  if (!ok || rename(tmp_name.c_str(), file_name.c_str()) != 0 || !SyncDirectory(file_name)) {
+    LOG_DEBUG("I/O error while writing the free space map");
+    return false;
+  }
+  dirty_ = false;
+  num_saves_++;
+  return true;
+}
+
+auto FreeSpaceMap::Load(const std::string &file_name, page_id_t num_pages) -> bool {
+  std::scoped_lock lock(latch_);
+  words_.clear();
+  num_free_ = 0;
+  first_word_ = 0;
+  dirty_ = false;
+  int fd = open(file_name.c_str(), O_RDONLY);  // NOLINT
+  if (fd < 0) {
+    return false;
+  }
+  FileHeader header;
+  bool ok = ReadAll(fd, &header, sizeof(header)) && header.magic_ == MAGIC &&
+            header.num_pages_ <= static_cast<uint32_t>(num_pages);
+  if (ok) {
+    words_.resize(header.num_words_);
+    ok = ReadAll(fd, words_.data(), words_.size() * sizeof(uint64_t));
+  }
+  close(fd);
+  if (!ok) {
+    LOG_DEBUG("ignoring stale or corrupt free space map");
+    words_.clear();
+    return false;
+  }
+  // Pages past the end of the file are handed out by growing the file anyway.
+  words_.resize(std::min<size_t>(words_.size(), (static_cast<size_t>(num_pages) + 63) / 64));
+  if (num_pages % 64 != 0 && words_.size() == (static_cast<size_t>(num_pages) + 63) / 64) {
+    words_.back() &= (static_cast<uint64_t>(1) << (num_pages % 64)) - 1;
+  }
+  for (uint64_t word : words_) {
+    num_free_ += __builtin_popcountll(word);
+  }
+  return true;
+}
+
+}  // namespace bustub
@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -11,16 +12,17 @@
 namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, BPlusTreeMode mode)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
-      leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {
-  insert_count_ = 0;
-  remove_count_ = 0;
-}
+      key_size_(static_cast<int>(std::min(comparator.GetKeySize(), sizeof(KeyType)))),
+      leaf_max_size_(leaf_max_size > 0 ? std::min(leaf_max_size, LeafPage::Capacity(key_size_))
+                                       : LeafPage::Capacity(key_size_)),
+      internal_max_size_(internal_max_size > 0 ? std::min(internal_max_size, InternalPage::Capacity(key_size_))
+                                               : InternalPage::Capacity(key_size_)),
+      mode_(mode) {}
 
 /*
  * Helper function to decide whether current b+tree is empty
@@ -37,109 +39,131 @@ auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return root_page_id_ == INVALID_P
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) -> bool {
-  std::scoped_lock<std::mutex> latch(mtx_);
-  latch_.RLock();
-  page_id_t page = INVALID_PAGE_ID;
-  LeafPage *page_ptr = DfsFindPage(key, root_page_id_, page, transaction);
-  if (page_ptr == nullptr) {
+  Page *leaf_page = FindLeaf(key, Operation::SEARCH);
+  if (leaf_page == nullptr) {
     return false;
   }
+  auto page_ptr = reinterpret_cast<LeafPage *>(leaf_page->GetData());
   int size = page_ptr->GetSize();
-  Page *last_leaf_page = buffer_pool_manager_->FetchPage(page_ptr->GetPageId());
-  int i = FindIf(0, size, key, page_ptr);
+  int i = size > 0 ? FindIf(0, size, key, page_ptr) : -1;
   bool flag = false;
   if (i != -1) {
     result->push_back(page_ptr->ValueAt(i));
     flag = true;
   }
-  buffer_pool_manager_->UnpinPage(last_leaf_page->GetPageId(), false);
-  buffer_pool_manager_->UnpinPage(last_leaf_page->GetPageId(), false);
-  last_leaf_page->RUnlatch();
+  leaf_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
   return flag;
 }
 
+/*
+ * Release every latch the transaction holds in this tree, from the leaf up, unpinning the pages and deleting the ones
+ * that were merged away. A nullptr in the page set stands for latch_, which guards root_page_id_.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::RemoveAllLock(Transaction *transaction, bool is_write) {
   auto page_set = transaction->GetPageSet();
   auto delete_set = transaction->GetDeletedPageSet();
-  bool flag = page_set->empty();
-  if (is_write) {
-    while (!flag) {
-      Page *ptr = page_set->back();
-      page_set->pop_back();
-      page_id_t id = ptr->GetPageId();
-      if (delete_set->count(id) != 0) {
-        buffer_pool_manager_->UnpinPage(id, true);
-        buffer_pool_manager_->DeletePage(id);
-      } else {
-        buffer_pool_manager_->UnpinPage(id, true);
-      }
-      if (page_set->empty()) {
-        delete_set->clear();
-      }
-      flag = page_set->empty();
-      ptr->WUnlatch();
+  while (!page_set->empty()) {
+    Page *ptr = page_set->back();
+    page_set->pop_back();
+    if (ptr == nullptr) {
+      latch_.WUnlock();
+      continue;
     }
-  } else {
-    while (!flag) {
-      Page *ptr = page_set->back();
-      page_set->pop_back();
-      page_id_t id = ptr->GetPageId();
-      if (delete_set->count(id) != 0) {
-        buffer_pool_manager_->UnpinPage(id, false);
-        buffer_pool_manager_->DeletePage(id);
-      } else {
-        buffer_pool_manager_->UnpinPage(id, false);
-      }
-      if (page_set->empty()) {
-        delete_set->clear();
-      }
-      flag = page_set->empty();
+    page_id_t id = ptr->GetPageId();
+    if (is_write) {
+      ptr->WUnlatch();
+    } else {
       ptr->RUnlatch();
     }
+    buffer_pool_manager_->UnpinPage(id, is_write);
+    if (delete_set->count(id) != 0 && !buffer_pool_manager_->DeletePage(id)) {
+      // A reader that got to the page before it was merged away still pins it.
+      std::scoped_lock lock(deferred_latch_);
+      deferred_deletes_.push_back(id);
+      num_deferred_deletes_ = deferred_deletes_.size();
+    }
+  }
+  delete_set->clear();
+  if (is_write) {
+    DeleteDeferredPages();
   }
 }
 
+/*
+ * Try again to delete the pages whose deletion failed because they were pinned, keeping the ones still pinned.
+ */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::BinarySearch(int l, int r, const KeyType &key, InternalPage *ptr) -> int {
-  int lim = r;
-  r--;
-  int middle = 0;
-  while (l < r) {
-    middle = l + (r - l) / 2;
-    auto res = comparator_(ptr->KeyAt(middle), key);
-    if (res >= 0) {
-      r = middle;
-    } else {
-      l = middle + 1;
+void BPLUSTREE_TYPE::DeleteDeferredPages() {
+  if (num_deferred_deletes_ == 0) {
+    return;
+  }
+  std::scoped_lock lock(deferred_latch_);
+  auto pinned = std::remove_if(deferred_deletes_.begin(), deferred_deletes_.end(),
+                               [this](page_id_t page_id) { return buffer_pool_manager_->DeletePage(page_id); });
+  deferred_deletes_.erase(pinned, deferred_deletes_.end());
+  num_deferred_deletes_ = deferred_deletes_.size();
+}
+
+/*
+ * Release the latches the transaction holds above the page it is about to latch, once that page is known to absorb
+ * the change without splitting or merging. None of them was modified yet.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseAncestors(Transaction *transaction) {
+  auto page_set = transaction->GetPageSet();
+  while (!page_set->empty()) {
+    Page *ptr = page_set->front();
+    page_set->pop_front();
+    if (ptr == nullptr) {
+      latch_.WUnlock();
+      continue;
     }
+    ptr->WUnlatch();
+    buffer_pool_manager_->UnpinPage(ptr->GetPageId(), false);
+  }
+}
+
+/*
+ * Whether a page can take the operation without splitting or merging, so that nothing above it changes. Inserting
+ * splits a full page; removing merges or borrows into a page that falls under half full, and collapses a root that
+ * is down to its last entry.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::IsSafe(BPlusTreePage *page, Operation op) const -> bool {
+  if (op == Operation::SEARCH) {
+    return true;
   }
-  if (comparator_(ptr->KeyAt(l), key) > 0) {
-    l--;
+  int size = page->GetSize();
+  if (op == Operation::INSERT) {
+    return size < page->GetMaxSize();
   }
-  if (l == lim) {
-    l--;
+  if (page->IsRootPage()) {
+    return page->IsLeafPage() ? size > 1 : size > 2;
   }
-  return l;
+  return size > Ceil(page->GetMaxSize(), 2);
 }
 
+/*
+ * @return : the index of the child of an internal page to descend into for key, among the children l - 1 to r - 1,
+ * that is the last index in [l, r) whose key is less than or equal to key, or l - 1
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BinarySearch(int l, int r, const KeyType &key, InternalPage *ptr) -> int {
+  return ptr->KeyBound(l, r, key, comparator_, true) - 1;
+}
+
+/*
+ * @return : the index of key among the entries l to r - 1 of a leaf, or -1
+ */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::FindIf(int l, int r, const KeyType &key, LeafPage *ptr) -> int {
-  r--;
-  int middle = 0;
-  while (l < r) {
-    middle = l + (r - l) / 2;
-    auto res = comparator_(ptr->KeyAt(middle), key);
-    if (res >= 0) {
-      r = middle;
-    } else {
-      l = middle + 1;
-    }
-  }
-  if (comparator_(ptr->KeyAt(l), key) != 0) {
+  int pos = ptr->KeyBound(l, r, key, comparator_);
+  if (pos == r || comparator_(ptr->KeyAt(pos), key) != 0) {
     return -1;
   }
-  return l;
+  return pos;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -155,44 +179,182 @@ auto BPLUSTREE_TYPE::FindValue(BPlusTreePage *page, InternalPage *pare_page) ->
   return pos;
 }
 
-// 查找叶节点
+/*
+ * Find the leaf that may hold key and return it pinned, read-latched for a search and write-latched otherwise.
+ * With latch crabbing, the descent is optimistic first and crabs down with read latches if that fails.
+ * @return : nullptr if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeaf(const KeyType &key, Operation op) -> Page * {
+  if (mode_ == BPlusTreeMode::B_LINK) {
+    return BLinkDescend(key, 0, op != Operation::SEARCH, nullptr);
+  }
+  Page *page = FindLeafOptimistic(key, op);
+  if (page != nullptr) {
+    return page;
+  }
+  return FindLeafCrabbing(key, op);
+}
+
+/*
+ * Descend without pinning or latching the internal pages, validating every read against the version of the page,
+ * then latch the leaf and check that its parent did not change since it pointed to it.
+ * @return : nullptr if the tree is empty, a page is not resident or a read was invalidated by a concurrent change
+ */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::DfsFindPage(const KeyType &key, page_id_t current_page_id, page_id_t &leaf_page_id,
-                                 Transaction *transaction, bool is_write) -> LeafPage * {
-  if (current_page_id == INVALID_PAGE_ID) {
+auto BPLUSTREE_TYPE::FindLeafOptimistic(const KeyType &key, Operation op) -> Page * {
+  uint64_t version = 0;
+  latch_.RLock();
+  page_id_t page_id = root_page_id_;
+  Page *ptr = page_id == INVALID_PAGE_ID ? nullptr : buffer_pool_manager_->FetchPageOptimistic(page_id, &version);
+  latch_.RUnlock();
+  Page *parent_ptr = nullptr;
+  uint64_t parent_version = 0;
+  while (true) {
+    page_id_t child_page_id = INVALID_PAGE_ID;
+    if (ptr == nullptr || !OptimisticFindChild(key, ptr, version, &child_page_id)) {
+      return nullptr;
+    }
+    if (child_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    parent_ptr = ptr;
+    parent_version = version;
+    page_id = child_page_id;
+    ptr = buffer_pool_manager_->FetchPageOptimistic(page_id, &version);
+    // The child's version is only meaningful if the parent still pointed to it when it was taken.
+    if (!parent_ptr->ValidateOptimisticRead(parent_version)) {
+      return nullptr;
+    }
+  }
+  Page *leaf_page = buffer_pool_manager_->FetchPage(page_id);
+  if (leaf_page == nullptr) {
     return nullptr;
   }
-  Page *ptr = buffer_pool_manager_->FetchPage(current_page_id);
-  if (is_write) {
-    ptr->WLatch();
+  if (op == Operation::SEARCH) {
+    leaf_page->RLatch();
   } else {
-    ptr->RLatch();
+    leaf_page->WLatch();
   }
-  auto page_p = reinterpret_cast<BPlusTreePage *>(ptr->GetData());
-  if (!(page_p->IsLeafPage())) {
-    auto page_ptr = reinterpret_cast<InternalPage *>(page_p);
-    int size = page_ptr->GetSize();
-    int i = BinarySearch(1, size, key, page_ptr);
-    page_id_t next_page = page_ptr->ValueAt(i);
-    if (current_page_id == root_page_id_ && !is_write) {
-      latch_.RUnlock();
-    }
-    if (!is_write) {
-      ptr->RUnlatch();
-      buffer_pool_manager_->UnpinPage(current_page_id, false);
+  bool valid = false;
+  if (parent_ptr != nullptr) {
+    valid = parent_ptr->ValidateOptimisticRead(parent_version);
+  } else {
+    // A root leaf is the whole tree as long as it is still the root.
+    latch_.RLock();
+    valid = root_page_id_ == page_id;
+    latch_.RUnlock();
+  }
+  if (!valid) {
+    if (op == Operation::SEARCH) {
+      leaf_page->RUnlatch();
     } else {
-      transaction->AddIntoPageSet(ptr);
+      leaf_page->WUnlatch();
     }
-    return DfsFindPage(key, next_page, leaf_page_id, transaction, is_write);
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    return nullptr;
   }
-  if (current_page_id == root_page_id_ && !is_write) {
+  return leaf_page;
+}
+
+/*
+ * Descend holding read latches, releasing each page once its child is latched. The leaf is write-latched unless
+ * searching: a page turning out to be a leaf is latched again in write mode while its parent is still held, so it
+ * cannot be split or merged in between.
+ * @return : nullptr if the tree is empty or the pool has no frame for a page on the way
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafCrabbing(const KeyType &key, Operation op) -> Page * {
+  latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
     latch_.RUnlock();
+    return nullptr;
   }
-  if (is_write) {
+  Page *parent_ptr = nullptr;
+  Page *ptr = buffer_pool_manager_->FetchPage(root_page_id_);
+  if (ptr == nullptr) {
+    latch_.RUnlock();
+    return nullptr;
+  }
+  ptr->RLatch();
+  while (true) {
+    auto page_p = reinterpret_cast<BPlusTreePage *>(ptr->GetData());
+    if (page_p->IsLeafPage() && op != Operation::SEARCH) {
+      ptr->RUnlatch();
+      ptr->WLatch();
+    }
+    if (parent_ptr == nullptr) {
+      latch_.RUnlock();
+    } else {
+      parent_ptr->RUnlatch();
+      buffer_pool_manager_->UnpinPage(parent_ptr->GetPageId(), false);
+    }
+    if (page_p->IsLeafPage()) {
+      return ptr;
+    }
+    auto page_ptr = reinterpret_cast<InternalPage *>(page_p);
+    parent_ptr = ptr;
+    ptr = buffer_pool_manager_->FetchPage(page_ptr->ValueAt(BinarySearch(1, page_ptr->GetSize(), key, page_ptr)));
+    if (ptr == nullptr) {
+      parent_ptr->RUnlatch();
+      buffer_pool_manager_->UnpinPage(parent_ptr->GetPageId(), false);
+      return nullptr;
+    }
+    ptr->RLatch();
+  }
+}
+
+/*
+ * Descend holding write latches, for an insert or remove that has to split or merge. The caller holds latch_ and
+ * pushed nullptr for it into the page set. Every latched page joins the page set, and whenever a page is safe for the
+ * operation, the latches above it are released since nothing above it will change.
+ * @return : the leaf, which is also the last page of the page set, or nullptr if the pool has no frame for a page on
+ * the way; the caller releases the page set either way
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPessimistic(const KeyType &key, Operation op, Transaction *transaction) -> Page * {
+  Page *ptr = buffer_pool_manager_->FetchPage(root_page_id_);
+  while (ptr != nullptr) {
+    ptr->WLatch();
+    auto page_p = reinterpret_cast<BPlusTreePage *>(ptr->GetData());
+    if (IsSafe(page_p, op)) {
+      ReleaseAncestors(transaction);
+    }
     transaction->AddIntoPageSet(ptr);
+    if (page_p->IsLeafPage()) {
+      return ptr;
+    }
+    auto page_ptr = reinterpret_cast<InternalPage *>(page_p);
+    ptr = buffer_pool_manager_->FetchPage(page_ptr->ValueAt(BinarySearch(1, page_ptr->GetSize(), key, page_ptr)));
   }
-  leaf_page_id = page_p->GetPageId();
-  return reinterpret_cast<LeafPage *>(page_p);
+  return nullptr;
+}
+
+/*
+ * Find the child of a page to descend into without pinning or latching the page, by validating the read against the
+ * version of the page latch. Everything read before the validation may be garbage, so the size is bound-checked
+ * before it is used to index the page.
+ * @return : false if the page changed while it was read; otherwise child_page_id is INVALID_PAGE_ID for a leaf
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::OptimisticFindChild(const KeyType &key, Page *ptr, uint64_t version, page_id_t *child_page_id)
+    -> bool {
+  auto page_p = reinterpret_cast<BPlusTreePage *>(ptr->GetData());
+  page_id_t next_page = INVALID_PAGE_ID;
+  if (!page_p->IsLeafPage()) {
+    auto page_ptr = reinterpret_cast<InternalPage *>(page_p);
+    int size = page_ptr->GetSize();
+    if (size < 2 || size > internal_max_size_ + 1 || size > InternalPage::Capacity(key_size_) ||
+        page_ptr->GetKeySize() != key_size_) {
+      return false;
+    }
+    next_page = page_ptr->ValueAt(BinarySearch(1, size, key, page_ptr));
+  }
+  if (!ptr->ValidateOptimisticRead(version)) {
+    return false;
+  }
+  *child_page_id = next_page;
+  return true;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -207,7 +369,7 @@ auto BPLUSTREE_TYPE::BuildTree() -> bool {
   }
   root_page_id_ = page_ptr->GetPageId();
   auto page = reinterpret_cast<LeafPage *>(page_ptr->GetData());
-  page->Init(root_page_id_, INVALID_PAGE_ID, leaf_max_size_);
+  page->Init(root_page_id_, INVALID_PAGE_ID, leaf_max_size_, key_size_);
   UpdateRootPageId();
   buffer_pool_manager_->UnpinPage(root_page_id_, true);
   return true;
@@ -225,23 +387,45 @@ auto BPLUSTREE_TYPE::BuildTree() -> bool {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  std::scoped_lock<std::mutex> latch(mtx_);
+  if (mode_ == BPlusTreeMode::B_LINK) {
+    return BLinkInsert(key, value);
+  }
+  Page *leaf_page = FindLeaf(key, Operation::INSERT);
+  if (leaf_page != nullptr) {
+    auto page_ptr = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+    int pos = page_ptr->FindInsertPos(key, comparator_);
+    bool is_safe = pos != -1 && IsSafe(page_ptr, Operation::INSERT);
+    if (is_safe) {
+      page_ptr->MoveBack(pos);
+      page_ptr->SetKeyAt(pos, key);
+      page_ptr->SetValueAt(pos, value);
+      page_ptr->IncreaseSize();
+    }
+    leaf_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), is_safe);
+    if (pos == -1 || is_safe) {
+      return pos != -1;
+    }
+  }
+  // The leaf is full or the tree is empty: start over from the root with write latches.
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &local_transaction;
+  }
   latch_.WLock();
-  insert_count_++;
+  transaction->AddIntoPageSet(nullptr);
   if (root_page_id_ == INVALID_PAGE_ID && !BuildTree()) {
-    latch_.WUnlock();
+    RemoveAllLock(transaction, true);
     return false;
   }
-  page_id_t page = INVALID_PAGE_ID;
-  LeafPage *page_ptr = DfsFindPage(key, root_page_id_, page, transaction, true);
-  if (page_ptr == nullptr) {
-    latch_.WUnlock();
-    throw std::logic_error("DfsFindPage return nullptr!");
+  Page *leaf_ptr = FindLeafPessimistic(key, Operation::INSERT, transaction);
+  if (leaf_ptr == nullptr) {
+    RemoveAllLock(transaction, true);
     return false;
   }
+  auto page_ptr = reinterpret_cast<LeafPage *>(leaf_ptr->GetData());
   int pos = page_ptr->FindInsertPos(key, comparator_);
   if (pos == -1) {
-    latch_.WUnlock();
     RemoveAllLock(transaction, true);
     return false;
   }
@@ -249,12 +433,17 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
   if (size < page_ptr->GetMaxSize()) {
     return InsertLeaf(page_ptr, pos, key, value, transaction);
   }
-  page_id_t id = INVALID_PAGE_ID;
-  Page *new_page_ptr = buffer_pool_manager_->NewPage(&id);
+  std::vector<Page *> new_pages;
+  if (!ReserveSplitPages(transaction, &new_pages)) {
+    RemoveAllLock(transaction, true);
+    return false;
+  }
+  Page *new_page_ptr = new_pages.back();
+  new_pages.pop_back();
   auto new_leaf_ptr = reinterpret_cast<LeafPage *>(new_page_ptr->GetData());
-  new_leaf_ptr->Init(new_page_ptr->GetPageId(), INVALID_PAGE_ID, leaf_max_size_);
+  new_leaf_ptr->Init(new_page_ptr->GetPageId(), INVALID_PAGE_ID, leaf_max_size_, key_size_);
   ReallocatLeafPage(page_ptr, new_leaf_ptr, pos, key, value, transaction);
-  return InsertParent(page_ptr, new_leaf_ptr->KeyAt(0), new_leaf_ptr, transaction);
+  return InsertParent(page_ptr, new_leaf_ptr->KeyAt(0), new_leaf_ptr, &new_pages, transaction);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -266,28 +455,13 @@ void BPLUSTREE_TYPE::ReallocatLeafPage(LeafPage *page_ptr, LeafPage *new_page_pt
   new_page_ptr->SetSize(new_size);
   page_ptr->SetSize(len);
   if (insert_pos < len) {
-    auto src_ptr = page_ptr->ArrPtr(len - 1);
-    auto dst_ptr = new_page_ptr->ArrPtr(0);
-    size_t num = new_size;
-    if (num > 0) {
-      memcpy(reinterpret_cast<void *>(dst_ptr), reinterpret_cast<void *>(src_ptr), num * page_ptr->CellSize());
-    }
+    new_page_ptr->CopyEntries(page_ptr, len - 1, 0, new_size);
     page_ptr->MoveBack(insert_pos);
     page_ptr->SetKeyAt(insert_pos, key);
     page_ptr->SetValueAt(insert_pos, value);
   } else {
-    auto src_ptr = page_ptr->ArrPtr(len);
-    auto dst_ptr = new_page_ptr->ArrPtr(0);
-    size_t num = insert_pos - len;
-    if (num > 0) {
-      memcpy(reinterpret_cast<void *>(dst_ptr), reinterpret_cast<void *>(src_ptr), num * page_ptr->CellSize());
-    }
-    src_ptr = page_ptr->ArrPtr(insert_pos);
-    dst_ptr = new_page_ptr->ArrPtr(insert_pos - len + 1);
-    num = size - insert_pos;
-    if (num > 0) {
-      memcpy(reinterpret_cast<void *>(dst_ptr), reinterpret_cast<void *>(src_ptr), num * page_ptr->CellSize());
-    }
+    new_page_ptr->CopyEntries(page_ptr, len, 0, insert_pos - len);
+    new_page_ptr->CopyEntries(page_ptr, insert_pos, insert_pos - len + 1, size - insert_pos);
     new_page_ptr->SetKeyAt(insert_pos - len, key);
     new_page_ptr->SetValueAt(insert_pos - len, value);
   }
@@ -302,115 +476,171 @@ auto BPLUSTREE_TYPE::InsertLeaf(LeafPage *page_ptr, int insert_pos, const KeyTyp
   page_ptr->SetKeyAt(insert_pos, key);
   page_ptr->SetValueAt(insert_pos, value);
   page_ptr->IncreaseSize();
-  latch_.WUnlock();
   RemoveAllLock(transaction, true);
   return true;
 }
 
+/*
+ * Allocate every page an insert into a full leaf needs before anything changes, so that running out of frames leaves
+ * the tree as it was: one for each full page in the page set, and a new root if the topmost one is full, which makes
+ * it the root.
+ * @return : false if the buffer pool ran out of frames, new_pages is empty then
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::ReserveSplitPages(Transaction *transaction, std::vector<Page *> *new_pages) -> bool {
+  size_t needed = 0;
+  bool topmost = true;
+  for (Page *ptr : *transaction->GetPageSet()) {
+    if (ptr == nullptr) {
+      continue;
+    }
+    if (!IsSafe(reinterpret_cast<BPlusTreePage *>(ptr->GetData()), Operation::INSERT)) {
+      needed += topmost ? 2 : 1;
+    }
+    topmost = false;
+  }
+  return AllocatePages(needed, new_pages);
+}
+
+/*
+ * Allocate new pages until there are count of them in new_pages, all pinned.
+ * @return : false if the buffer pool ran out of frames, new_pages is empty then
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::AllocatePages(size_t count, std::vector<Page *> *new_pages) -> bool {
+  while (new_pages->size() < count) {
+    page_id_t id = INVALID_PAGE_ID;
+    Page *ptr = buffer_pool_manager_->NewPage(&id);
+    if (ptr == nullptr) {
+      FreePages(new_pages);
+      return false;
+    }
+    new_pages->push_back(ptr);
+  }
+  return true;
+}
+
+/* Give back the pages allocated in advance that a split did not use. */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FreePages(std::vector<Page *> *new_pages) {
+  for (Page *page : *new_pages) {
+    page_id_t id = page->GetPageId();
+    buffer_pool_manager_->UnpinPage(id, false);
+    buffer_pool_manager_->DeletePage(id);
+  }
+  new_pages->clear();
+}
+
+/*
+ * @return : the page of the page set with the given id, or nullptr if the transaction does not hold it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::HeldPage(page_id_t page_id, Transaction *transaction) -> Page * {
+  for (Page *ptr : *transaction->GetPageSet()) {
+    if (ptr != nullptr && ptr->GetPageId() == page_id) {
+      return ptr;
+    }
+  }
+  return nullptr;
+}
+
+/*
+ * Point a child that moved to another page at its new parent, under its write latch unless it is in the page set
+ * already. The child is not pinned by the split or merge, so a pool that is momentarily out of frames is waited out.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReparentChild(page_id_t child_page_id, page_id_t parent_page_id, Transaction *transaction) {
+  Page *held = HeldPage(child_page_id, transaction);
+  if (held != nullptr) {
+    reinterpret_cast<BPlusTreePage *>(held->GetData())->SetParentPageId(parent_page_id);
+    return;
+  }
+  Page *ptr = buffer_pool_manager_->FetchPage(child_page_id);
+  while (ptr == nullptr) {
+    std::this_thread::yield();
+    ptr = buffer_pool_manager_->FetchPage(child_page_id);
+  }
+  ptr->WLatch();
+  reinterpret_cast<BPlusTreePage *>(ptr->GetData())->SetParentPageId(parent_page_id);
+  ptr->WUnlatch();
+  buffer_pool_manager_->UnpinPage(child_page_id, true);
+}
+
+/*
+ * Insert the separator of a page that was split into its parent, splitting the parent in turn if it is full. The
+ * page that was split is write-latched in the page set, with its parent right before it; the new page is pinned but
+ * not latched, and the pages to split into were taken out of new_pages in advance.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::InsertParent(BPlusTreePage *page_ptr, const KeyType &key, BPlusTreePage *new_page_ptr,
-                                  Transaction *transaction) -> bool {
+                                  std::vector<Page *> *new_pages, Transaction *transaction) -> bool {
   if (page_ptr->GetPageId() == root_page_id_) {
-    page_id_t id = INVALID_PAGE_ID;
-    Page *page = buffer_pool_manager_->NewPage(&id);
+    Page *page = new_pages->back();
+    new_pages->pop_back();
+    page_id_t id = page->GetPageId();
     auto new_page = reinterpret_cast<InternalPage *>(page->GetData());
-    new_page->Init(page->GetPageId(), INVALID_PAGE_ID, internal_max_size_);
+    new_page->Init(page->GetPageId(), INVALID_PAGE_ID, internal_max_size_, key_size_);
     new_page->SetKeyAt(1, key);
     new_page->SetValueAt(0, page_ptr->GetPageId());
     new_page->SetValueAt(1, new_page_ptr->GetPageId());
     new_page->SetSize(2);
     page_ptr->SetParentPageId(new_page->GetPageId());
-    new_page_ptr->SetParentPageId(new_page->GetPageId());
+    ReparentChild(new_page_ptr->GetPageId(), new_page->GetPageId(), transaction);
     root_page_id_ = id;
-    // latch_.WUnlock();
-    // RemoveAllLock(transaction, true);
     UpdateRootPageId();
     buffer_pool_manager_->UnpinPage(new_page_ptr->GetPageId(), true);
     buffer_pool_manager_->UnpinPage(new_page->GetPageId(), true);
-    latch_.WUnlock();
     RemoveAllLock(transaction, true);
     return true;
   }
-  auto page =
-      reinterpret_cast<InternalPage *>((buffer_pool_manager_->FetchPage(page_ptr->GetParentPageId()))->GetData());
+  auto page_set = transaction->GetPageSet();
+  auto it = std::find_if(page_set->begin(), page_set->end(), [page_ptr](Page *ptr) {
+    return ptr != nullptr && ptr->GetPageId() == page_ptr->GetPageId();
+  });
+  auto page = reinterpret_cast<InternalPage *>((*std::prev(it))->GetData());
   int size = page->GetSize();
   int i = 0;
   if (page_ptr->IsLeafPage()) {
-    i = BinarySearch(0, size, (reinterpret_cast<LeafPage *>(page_ptr))->KeyAt(page_ptr->GetSize() - 1), page);
+    i = BinarySearch(1, size, (reinterpret_cast<LeafPage *>(page_ptr))->KeyAt(page_ptr->GetSize() - 1), page);
   } else {
-    i = BinarySearch(0, size, (reinterpret_cast<InternalPage *>(page_ptr))->KeyAt(page_ptr->GetSize() - 1), page);
+    i = BinarySearch(1, size, (reinterpret_cast<InternalPage *>(page_ptr))->KeyAt(page_ptr->GetSize() - 1), page);
   }
   if (size < page->GetMaxSize()) {
     page->MoveBack(i + 1);
     page->SetKeyAt(i + 1, key);
     page->SetValueAt(i + 1, new_page_ptr->GetPageId());
     page->IncreaseSize();
-    page_ptr->SetParentPageId(page->GetPageId());
-    new_page_ptr->SetParentPageId(page->GetPageId());
+    ReparentChild(new_page_ptr->GetPageId(), page->GetPageId(), transaction);
     buffer_pool_manager_->UnpinPage(new_page_ptr->GetPageId(), true);
-    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
-    latch_.WUnlock();
     RemoveAllLock(transaction, true);
     return true;
   }
-  page_id_t id = INVALID_PAGE_ID;
-  Page *temp_page = buffer_pool_manager_->NewPage(&id);
+  Page *temp_page = new_pages->back();
+  new_pages->pop_back();
+  page_id_t id = temp_page->GetPageId();
   auto new_inter_page = reinterpret_cast<InternalPage *>(temp_page->GetData());
-  new_inter_page->Init(temp_page->GetPageId(), INVALID_PAGE_ID, internal_max_size_);
+  new_inter_page->Init(temp_page->GetPageId(), INVALID_PAGE_ID, internal_max_size_, key_size_);
   KeyType temp;
   int len = Ceil(size + 1, 2);
   int new_size = size + 1 - len;
   i++;
   if (i < len) {
-    auto src_ptr = page->ArrPtr(len - 1);
-    auto dst_ptr = new_inter_page->ArrPtr(0);
-    size_t num = size + 1 - len;
-    if (num > 0) {
-      memcpy(reinterpret_cast<void *>(dst_ptr), reinterpret_cast<void *>(src_ptr), num * page->CellSize());
-    }
+    new_inter_page->CopyEntries(page, len - 1, 0, size + 1 - len);
     new_inter_page->SetSize(new_size);
     page->SetSize(len);
     temp = page->KeyAt(len - 1);
     page->MoveBack(i);
     page->SetKeyAt(i, key);
     page->SetValueAt(i, new_page_ptr->GetPageId());
-    new_page_ptr->SetParentPageId(page->GetPageId());
-    for (int j = 0; j < new_size; j++) {
-      auto p =
-          reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(new_inter_page->ValueAt(j))->GetData());
-      p->SetParentPageId(id);
-      buffer_pool_manager_->UnpinPage(p->GetPageId(), true);
-    }
-    buffer_pool_manager_->UnpinPage(new_page_ptr->GetPageId(), true);
-    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
-    InsertParent(page, temp, new_inter_page, transaction);
+    ReparentChild(new_page_ptr->GetPageId(), page->GetPageId(), transaction);
   } else if (i == len) {
-    auto src_ptr = page->ArrPtr(len);
-    auto dst_ptr = new_inter_page->ArrPtr(1);
-    size_t num = size - len;
-    if (num > 0) {
-      memcpy(reinterpret_cast<void *>(dst_ptr), reinterpret_cast<void *>(src_ptr), num * page->CellSize());
-    }
+    new_inter_page->CopyEntries(page, len, 1, size - len);
     new_inter_page->SetValueAt(0, new_page_ptr->GetPageId());
     new_inter_page->SetSize(new_size);
-    new_page_ptr->SetParentPageId(page->GetPageId());
-    for (int j = 0; j < new_size; j++) {
-      auto p =
-          reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(new_inter_page->ValueAt(j))->GetData());
-      p->SetParentPageId(id);
-      buffer_pool_manager_->UnpinPage(p->GetPageId(), true);
-    }
     page->SetSize(len);
-    buffer_pool_manager_->UnpinPage(new_page_ptr->GetPageId(), true);
-    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
-    InsertParent(page, key, new_inter_page, transaction);
+    temp = key;
   } else {
-    auto src_ptr = page->ArrPtr(len);
-    auto dst_ptr = new_inter_page->ArrPtr(0);
-    size_t num = size - len;
-    if (num > 0) {
-      memcpy(reinterpret_cast<void *>(dst_ptr), reinterpret_cast<void *>(src_ptr), num * page->CellSize());
-    }
+    new_inter_page->CopyEntries(page, len, 0, size - len);
     page->SetSize(len);
     new_inter_page->SetSize(new_size - 1);
     int pos = i - len;
@@ -419,18 +649,12 @@ auto BPLUSTREE_TYPE::InsertParent(BPlusTreePage *page_ptr, const KeyType &key, B
     new_inter_page->SetKeyAt(pos, key);
     new_inter_page->SetValueAt(pos, new_page_ptr->GetPageId());
     new_inter_page->IncreaseSize();
-    new_page_ptr->SetParentPageId(new_inter_page->GetPageId());
-    for (int j = 0; j < new_size; j++) {
-      auto p =
-          reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(new_inter_page->ValueAt(j))->GetData());
-      p->SetParentPageId(id);
-      buffer_pool_manager_->UnpinPage(p->GetPageId(), true);
-    }
-    buffer_pool_manager_->UnpinPage(new_page_ptr->GetPageId(), true);
-    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
-    InsertParent(page, temp, new_inter_page, transaction);
   }
-  return true;
+  for (int j = 0; j < new_size; j++) {
+    ReparentChild(new_inter_page->ValueAt(j), id, transaction);
+  }
+  buffer_pool_manager_->UnpinPage(new_page_ptr->GetPageId(), true);
+  return InsertParent(page, temp, new_inter_page, new_pages, transaction);
 }
 
 /*****************************************************************************
@@ -445,26 +669,48 @@ auto BPLUSTREE_TYPE::InsertParent(BPlusTreePage *page_ptr, const KeyType &key, B
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
-  std::scoped_lock<std::mutex> latch(mtx_);
+  if (mode_ == BPlusTreeMode::B_LINK) {
+    BLinkRemove(key);
+    return;
+  }
+  Page *leaf_page = FindLeaf(key, Operation::REMOVE);
+  if (leaf_page == nullptr) {
+    return;
+  }
+  auto leaf_page_ptr = reinterpret_cast<LeafPage *>(leaf_page->GetData());
+  int pos = leaf_page_ptr->FindKeyPos(key, comparator_);
+  bool is_safe = pos != -1 && IsSafe(leaf_page_ptr, Operation::REMOVE);
+  if (is_safe) {
+    leaf_page_ptr->MoveForward(pos + 1);
+  }
+  leaf_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), is_safe);
+  if (pos == -1 || is_safe) {
+    return;
+  }
+  // The leaf would underflow: start over from the root with write latches.
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr) {
+    transaction = &local_transaction;
+  }
   latch_.WLock();
-  remove_count_++;
+  transaction->AddIntoPageSet(nullptr);
   if (root_page_id_ == INVALID_PAGE_ID) {
-    latch_.WUnlock();
+    RemoveAllLock(transaction, true);
     return;
   }
-  page_id_t leaf_page_id;
-  LeafPage *leaf_page = DfsFindPage(key, root_page_id_, leaf_page_id, transaction, true);
-  if (leaf_page == nullptr) {
-    latch_.WUnlock();
+  Page *leaf_ptr = FindLeafPessimistic(key, Operation::REMOVE, transaction);
+  if (leaf_ptr == nullptr) {
+    RemoveAllLock(transaction, true);
     return;
   }
-  int pos = leaf_page->FindKeyPos(key, comparator_);
+  auto page_ptr = reinterpret_cast<LeafPage *>(leaf_ptr->GetData());
+  pos = page_ptr->FindKeyPos(key, comparator_);
   if (pos == -1) {
-    latch_.WUnlock();
     RemoveAllLock(transaction, true);
     return;
   }
-  DeleteEntry(reinterpret_cast<BPlusTreePage *>(leaf_page), key, pos, transaction);
+  DeleteEntry(reinterpret_cast<BPlusTreePage *>(page_ptr), key, pos, transaction);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -481,27 +727,22 @@ void BPLUSTREE_TYPE::DeleteEntry(BPlusTreePage *page_ptr, const KeyType &key, in
     if (!page_ptr->IsLeafPage()) {
       if (page_ptr->GetSize() == 1) {
         auto id = (reinterpret_cast<InternalPage *>(page_ptr))->ValueAt(0);
-        auto child_page_ptr = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(id)->GetData());
-        root_page_id_ = child_page_ptr->GetPageId();
-        child_page_ptr->SetParentPageId(INVALID_PAGE_ID);
+        root_page_id_ = id;
+        ReparentChild(id, INVALID_PAGE_ID, transaction);
         transaction->AddIntoDeletedPageSet(page_ptr->GetPageId());
-        latch_.WUnlock();
-        buffer_pool_manager_->UnpinPage(id, true);
-        RemoveAllLock(transaction, true);
         UpdateRootPageId();
+        RemoveAllLock(transaction, true);
         return;
       }
     } else {
       if (page_ptr->GetSize() == 0) {
         root_page_id_ = INVALID_PAGE_ID;
         transaction->AddIntoDeletedPageSet(page_ptr->GetPageId());
-        latch_.WUnlock();
-        RemoveAllLock(transaction, true);
         UpdateRootPageId();
+        RemoveAllLock(transaction, true);
         return;
       }
     }
-    latch_.WUnlock();
     RemoveAllLock(transaction, true);
     return;
   }
@@ -521,7 +762,9 @@ void BPLUSTREE_TYPE::DeleteEntry(BPlusTreePage *page_ptr, const KeyType &key, in
       bro = lef_bro;
     }
     if (bro == nullptr) {
-      throw std::logic_error("Can't find brother when remove!");
+      // The pool had no frame for the sibling. The page is left under half full, which the tree copes with, rather
+      // than failing a remove that already happened.
+      RemoveAllLock(transaction, true);
       return;
     }
     if (page_ptr->GetSize() + bro->GetSize() <= page_ptr->GetMaxSize()) {
@@ -538,7 +781,6 @@ void BPLUSTREE_TYPE::DeleteEntry(BPlusTreePage *page_ptr, const KeyType &key, in
       }
     }
   } else {
-    latch_.WUnlock();
     RemoveAllLock(transaction, true);
   }
 }
@@ -548,36 +790,25 @@ void BPLUSTREE_TYPE::Merge(BPlusTreePage *lef_page_ptr, const KeyType &key, BPlu
                            Transaction *transaction) {
   int pos = lef_page_ptr->GetSize();
   if (!lef_page_ptr->IsLeafPage()) {
-    size_t cell_size = (reinterpret_cast<InternalPage *>(rig_page_ptr))->CellSize();
-    auto src_ptr = (reinterpret_cast<InternalPage *>(rig_page_ptr))->ArrPtr(0);
-    auto dst_ptr = (reinterpret_cast<InternalPage *>(lef_page_ptr))->ArrPtr(pos);
     int num = rig_page_ptr->GetSize();
     for (int j = 0; j < num; j++) {
-      auto p = reinterpret_cast<BPlusTreePage *>(
-          buffer_pool_manager_->FetchPage((reinterpret_cast<InternalPage *>(rig_page_ptr))->ValueAt(j))->GetData());
-      p->SetParentPageId(lef_page_ptr->GetPageId());
-      buffer_pool_manager_->UnpinPage(p->GetPageId(), true);
+      ReparentChild((reinterpret_cast<InternalPage *>(rig_page_ptr))->ValueAt(j), lef_page_ptr->GetPageId(), transaction);
     }
-    memcpy(reinterpret_cast<void *>(dst_ptr), reinterpret_cast<void *>(src_ptr), num * cell_size);
+    (reinterpret_cast<InternalPage *>(lef_page_ptr))
+        ->CopyEntries(reinterpret_cast<InternalPage *>(rig_page_ptr), 0, pos, num);
     (reinterpret_cast<InternalPage *>(lef_page_ptr))->SetKeyAt(pos, key);
     lef_page_ptr->SetSize(pos + num);
   } else {
-    size_t cell_size = (reinterpret_cast<LeafPage *>(rig_page_ptr))->CellSize();
     auto lef_page = reinterpret_cast<LeafPage *>(lef_page_ptr);
     auto rig_page = reinterpret_cast<LeafPage *>(rig_page_ptr);
     lef_page->SetNextPageId(rig_page->GetNextPageId());
-    auto src_ptr = rig_page->ArrPtr(0);
-    auto dst_ptr = lef_page->ArrPtr(pos);
-    size_t num = rig_page->GetSize();
-    memcpy(reinterpret_cast<void *>(dst_ptr), reinterpret_cast<void *>(src_ptr), num * cell_size);
+    int num = rig_page->GetSize();
+    lef_page->CopyEntries(rig_page, 0, pos, num);
     lef_page->SetSize(pos + num);
   }
   auto pare_page =
-      reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(lef_page_ptr->GetParentPageId())->GetData());
-  transaction->AddIntoPageSet(bro_ptr);
-  bro_ptr->WLatch();
+      reinterpret_cast<BPlusTreePage *>(HeldPage(lef_page_ptr->GetParentPageId(), transaction)->GetData());
   transaction->AddIntoDeletedPageSet(rig_page_ptr->GetPageId());
-  buffer_pool_manager_->UnpinPage(pare_page->GetPageId(), true);
   int delete_pos = FindValue(rig_page_ptr, reinterpret_cast<InternalPage *>(pare_page));
   if (!lef_page_ptr->IsLeafPage()) {
     (reinterpret_cast<InternalPage *>(lef_page_ptr))
@@ -599,9 +830,7 @@ void BPLUSTREE_TYPE::ReallocateInRemoveLeft(BPlusTreePage *lef_page_ptr, const K
     rig_page->MoveBack(0);
     rig_page->SetKeyAt(1, key);
     page_id_t id = lef_page->ValueAt(lef_page->GetSize() - 1);
-    auto p = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(id)->GetData());
-    p->SetParentPageId(rig_page->GetPageId());
-    buffer_pool_manager_->UnpinPage(id, true);
+    ReparentChild(id, rig_page->GetPageId(), transaction);
     rig_page->SetValueAt(0, id);
     rig_page->IncreaseSize();
     lef_page->DecreaseSize();
@@ -616,15 +845,12 @@ void BPLUSTREE_TYPE::ReallocateInRemoveLeft(BPlusTreePage *lef_page_ptr, const K
     rig_page->IncreaseSize();
     lef_page->DecreaseSize();
   }
-  auto pare_page = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(pare_id)->GetData());
+  auto pare_page = reinterpret_cast<InternalPage *>(HeldPage(pare_id, transaction)->GetData());
   int pos = pare_page->FindKeyPos(key, comparator_);
   if (pos == -1) {
     throw std::logic_error("Internal page find key pos error! not found");
   }
   pare_page->SetKeyAt(pos, temp);
-  buffer_pool_manager_->UnpinPage(lef_page_ptr->GetPageId(), true);
-  buffer_pool_manager_->UnpinPage(pare_page->GetPageId(), true);
-  latch_.WUnlock();
   RemoveAllLock(transaction, true);
 }
 
@@ -640,9 +866,7 @@ void BPLUSTREE_TYPE::ReallocateInRemoveRight(BPlusTreePage *lef_page_ptr, const
     temp = rig_page->KeyAt(1);
     lef_page->SetKeyAt(lef_page->GetSize(), key);
     page_id_t id = rig_page->ValueAt(0);
-    auto p = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(id)->GetData());
-    p->SetParentPageId(lef_page->GetPageId());
-    buffer_pool_manager_->UnpinPage(id, true);
+    ReparentChild(id, lef_page->GetPageId(), transaction);
     lef_page->SetValueAt(lef_page->GetSize(), id);
     lef_page->IncreaseSize();
     rig_page->MoveForward(1);
@@ -656,18 +880,20 @@ void BPLUSTREE_TYPE::ReallocateInRemoveRight(BPlusTreePage *lef_page_ptr, const
     rig_page->MoveForward(1);
     temp = rig_page->KeyAt(0);
   }
-  auto pare_page = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(pare_id)->GetData());
+  auto pare_page = reinterpret_cast<InternalPage *>(HeldPage(pare_id, transaction)->GetData());
   int pos = pare_page->FindKeyPos(key, comparator_);
   if (pos == -1) {
     throw std::logic_error("Internal page find key pos error! not found");
   }
   pare_page->SetKeyAt(pos, temp);
-  buffer_pool_manager_->UnpinPage(rig_page_ptr->GetPageId(), true);
-  buffer_pool_manager_->UnpinPage(pare_page->GetPageId(), true);
-  latch_.WUnlock();
   RemoveAllLock(transaction, true);
 }
 
+/*
+ * The sibling is write-latched and joins the page set, so that it is released along with the rest of the path. The
+ * parent is held in the page set, so nobody else can be waiting for it from above. lef_bro and rig_bro both stay
+ * nullptr if the sibling could not be fetched.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::FindBrother(BPlusTreePage *page, page_id_t parent_page_id, BPlusTreePage *&lef_bro,
                                  BPlusTreePage *&rig_bro, Page *&bro_ptr, Transaction *transaction) -> KeyType {
@@ -677,7 +903,7 @@ auto BPLUSTREE_TYPE::FindBrother(BPlusTreePage *page, page_id_t parent_page_id,
     throw std::logic_error("FindBrother error due to the parent is INVALID");
     return KeyType();
   }
-  auto parent_page_ptr = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(parent_page_id)->GetData());
+  auto parent_page_ptr = reinterpret_cast<InternalPage *>(HeldPage(parent_page_id, transaction)->GetData());
   int pos = FindValue(page, parent_page_ptr);
   {
     page_id_t temp = parent_page_ptr->ValueAt(pos);
@@ -689,25 +915,493 @@ auto BPLUSTREE_TYPE::FindBrother(BPlusTreePage *page, page_id_t parent_page_id,
   if (pos < size - 1) {
     page_id_t id = parent_page_ptr->ValueAt(pos + 1);
     Page *ptr = buffer_pool_manager_->FetchPage(id);
+    if (ptr == nullptr) {
+      return KeyType();
+    }
+    ptr->WLatch();
+    transaction->AddIntoPageSet(ptr);
     rig_bro = reinterpret_cast<BPlusTreePage *>(ptr->GetData());
-    KeyType key = parent_page_ptr->KeyAt(pos + 1);
-    buffer_pool_manager_->UnpinPage(parent_page_id, false);
     bro_ptr = ptr;
-    return key;
+    return parent_page_ptr->KeyAt(pos + 1);
   }
   if (pos > 0) {
     page_id_t id = parent_page_ptr->ValueAt(pos - 1);
     Page *ptr = buffer_pool_manager_->FetchPage(id);
+    if (ptr == nullptr) {
+      return KeyType();
+    }
+    ptr->WLatch();
+    transaction->AddIntoPageSet(ptr);
     lef_bro = reinterpret_cast<BPlusTreePage *>(ptr->GetData());
-    KeyType key = parent_page_ptr->KeyAt(pos);
-    buffer_pool_manager_->UnpinPage(parent_page_id, false);
     bro_ptr = ptr;
-    return key;
+    return parent_page_ptr->KeyAt(pos);
   }
-  buffer_pool_manager_->UnpinPage(parent_page_id, false);
   return KeyType();
 }
 
+/*****************************************************************************
+ * B-LINK
+ *****************************************************************************/
+/*
+ * Level of a page, counting up from the leaves at 0. It never changes, since pages are only ever split.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::PageLevel(BPlusTreePage *page) -> int {
+  return page->IsLeafPage() ? 0 : reinterpret_cast<InternalPage *>(page)->GetLevel();
+}
+
+/*
+ * @return : the right sibling of the page if key is not below its high key, INVALID_PAGE_ID if key belongs to the page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BLinkNextPage(BPlusTreePage *page, const KeyType &key) -> page_id_t {
+  page_id_t next_page_id = INVALID_PAGE_ID;
+  KeyType high_key;
+  if (page->IsLeafPage()) {
+    auto leaf_page_ptr = reinterpret_cast<LeafPage *>(page);
+    next_page_id = leaf_page_ptr->GetNextPageId();
+    high_key = leaf_page_ptr->GetHighKey();
+  } else {
+    auto inter_page_ptr = reinterpret_cast<InternalPage *>(page);
+    next_page_id = inter_page_ptr->GetNextPageId();
+    high_key = inter_page_ptr->GetHighKey();
+  }
+  if (next_page_id == INVALID_PAGE_ID || comparator_(key, high_key) < 0) {
+    return INVALID_PAGE_ID;
+  }
+  return next_page_id;
+}
+
+/*
+ * Follow right links from a latched page until reaching the page whose range holds key, which the page split off since
+ * the pointer to it was read. Writers latch the next page before releasing the current one.
+ * @return : that page, pinned and latched in the same mode
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BLinkMoveRight(Page *ptr, const KeyType &key, bool exclusive) -> Page * {
+  while (true) {
+    page_id_t next_page_id = BLinkNextPage(reinterpret_cast<BPlusTreePage *>(ptr->GetData()), key);
+    if (next_page_id == INVALID_PAGE_ID) {
+      return ptr;
+    }
+    Page *next_ptr = buffer_pool_manager_->FetchPage(next_page_id);
+    if (exclusive) {
+      next_ptr->WLatch();
+      ptr->WUnlatch();
+    } else {
+      ptr->RUnlatch();
+      next_ptr->RLatch();
+    }
+    buffer_pool_manager_->UnpinPage(ptr->GetPageId(), false);
+    ptr = next_ptr;
+  }
+}
+
+/*
+ * Descend to the page of the given level whose range holds key, latching one page at a time. A page is released before
+ * its child is latched: the child may split in between, which moving right makes up for.
+ * @parameter: path    if not nullptr, receives the ids of the pages the descent went through above the level
+ * @return : the page, pinned and latched in write mode if exclusive, read mode otherwise; nullptr if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BLinkDescend(const KeyType &key, int level, bool exclusive, std::vector<page_id_t> *path)
+    -> Page * {
+  latch_.RLock();
+  page_id_t page_id = root_page_id_;
+  latch_.RUnlock();
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  while (true) {
+    Page *ptr = buffer_pool_manager_->FetchPage(page_id);
+    ptr->RLatch();
+    bool is_target = PageLevel(reinterpret_cast<BPlusTreePage *>(ptr->GetData())) == level;
+    if (is_target && exclusive) {
+      // The page may split before the write latch is granted, but it keeps its left half.
+      ptr->RUnlatch();
+      ptr->WLatch();
+    }
+    ptr = BLinkMoveRight(ptr, key, is_target && exclusive);
+    if (is_target) {
+      return ptr;
+    }
+    auto page_ptr = reinterpret_cast<InternalPage *>(ptr->GetData());
+    if (path != nullptr) {
+      path->push_back(ptr->GetPageId());
+    }
+    page_id = page_ptr->ValueAt(BinarySearch(1, page_ptr->GetSize(), key, page_ptr));
+    ptr->RUnlatch();
+    buffer_pool_manager_->UnpinPage(ptr->GetPageId(), false);
+  }
+}
+
+/*
+ * Descend along the leftmost or rightmost pointers one latch at a time. Splits keep the leftmost page in place, and the
+ * rightmost page of each level is the one without a right link.
+ * @return : the first or last leaf, pinned and read-latched, or nullptr if the tree is empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BLinkFindEdgeLeaf(bool rightmost) -> Page * {
+  latch_.RLock();
+  page_id_t page_id = root_page_id_;
+  latch_.RUnlock();
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  while (true) {
+    Page *ptr = buffer_pool_manager_->FetchPage(page_id);
+    ptr->RLatch();
+    auto page_ptr = reinterpret_cast<BPlusTreePage *>(ptr->GetData());
+    while (rightmost) {
+      page_id_t next_page_id = page_ptr->IsLeafPage() ? reinterpret_cast<LeafPage *>(page_ptr)->GetNextPageId()
+                                                      : reinterpret_cast<InternalPage *>(page_ptr)->GetNextPageId();
+      if (next_page_id == INVALID_PAGE_ID) {
+        break;
+      }
+      ptr->RUnlatch();
+      buffer_pool_manager_->UnpinPage(ptr->GetPageId(), false);
+      ptr = buffer_pool_manager_->FetchPage(next_page_id);
+      ptr->RLatch();
+      page_ptr = reinterpret_cast<BPlusTreePage *>(ptr->GetData());
+    }
+    if (page_ptr->IsLeafPage()) {
+      return ptr;
+    }
+    auto inter_page_ptr = reinterpret_cast<InternalPage *>(page_ptr);
+    page_id = inter_page_ptr->ValueAt(rightmost ? inter_page_ptr->GetSize() - 1 : 0);
+    ptr->RUnlatch();
+    buffer_pool_manager_->UnpinPage(ptr->GetPageId(), false);
+  }
+}
+
+/*
+ * Insert into the leaf, splitting it if it is full. The new right half is linked in before the leaf is released, so
+ * it is reachable before the parent knows about it. A split allocates a page for every level of the path and a new
+ * root first, as the ancestors are not latched yet to tell which of them are full; running out of frames then fails
+ * the insert before anything changes.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BLinkInsert(const KeyType &key, const ValueType &value) -> bool {
+  std::vector<page_id_t> path;
+  Page *ptr = BLinkDescend(key, 0, true, &path);
+  if (ptr == nullptr) {
+    latch_.WLock();
+    bool built = BuildTree();
+    latch_.WUnlock();
+    if (!built) {
+      return false;
+    }
+    ptr = BLinkDescend(key, 0, true, &path);
+  }
+  auto page_ptr = reinterpret_cast<LeafPage *>(ptr->GetData());
+  int pos = page_ptr->FindInsertPos(key, comparator_);
+  if (pos == -1) {
+    ptr->WUnlatch();
+    buffer_pool_manager_->UnpinPage(ptr->GetPageId(), false);
+    return false;
+  }
+  if (page_ptr->GetSize() < page_ptr->GetMaxSize()) {
+    page_ptr->MoveBack(pos);
+    page_ptr->SetKeyAt(pos, key);
+    page_ptr->SetValueAt(pos, value);
+    page_ptr->IncreaseSize();
+    ptr->WUnlatch();
+    buffer_pool_manager_->UnpinPage(ptr->GetPageId(), true);
+    return true;
+  }
+  std::vector<Page *> new_pages;
+  if (!AllocatePages(path.size() + 2, &new_pages)) {
+    ptr->WUnlatch();
+    buffer_pool_manager_->UnpinPage(ptr->GetPageId(), false);
+    return false;
+  }
+  Page *new_page_ptr = new_pages.back();
+  new_pages.pop_back();
+  page_id_t id = new_page_ptr->GetPageId();
+  auto new_leaf_ptr = reinterpret_cast<LeafPage *>(new_page_ptr->GetData());
+  new_leaf_ptr->Init(id, INVALID_PAGE_ID, leaf_max_size_, key_size_);
+  ReallocatLeafPage(page_ptr, new_leaf_ptr, pos, key, value);
+  KeyType separator = new_leaf_ptr->KeyAt(0);
+  new_leaf_ptr->SetHighKey(page_ptr->GetHighKey());
+  page_ptr->SetHighKey(separator);
+  buffer_pool_manager_->UnpinPage(id, true);
+  BLinkInsertParent(&path, ptr, separator, id, &new_pages);
+  FreePages(&new_pages);
+  return true;
+}
+
+/*
+ * Post the split of a write-latched page to its parent: key separates the page from new_page_id, its new right
+ * sibling. The parent is the last page of the path, or the page it split into on the right; it is latched before
+ * the child is released. A page that split while it was the root gets a new root instead, and a page that has no
+ * parent on the path because the tree grew since the descent finds it from the new root.
+ * Splits take their pages from new_pages, whose last page is kept for a new root. A parent split beyond them, which
+ * the path did not account for as the tree grew meanwhile, allocates its own page, or leaves the split unposted if
+ * there is no frame for it or for the parent: the new page stays reachable through its left sibling.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BLinkInsertParent(std::vector<page_id_t> *path, Page *ptr, KeyType key, page_id_t new_page_id,
+                                       std::vector<Page *> *new_pages) {
+  while (true) {
+    int level = PageLevel(reinterpret_cast<BPlusTreePage *>(ptr->GetData()));
+    Page *parent_ptr = nullptr;
+    if (!path->empty()) {
+      parent_ptr = buffer_pool_manager_->FetchPage(path->back());
+      path->pop_back();
+      if (parent_ptr == nullptr) {
+        ptr->WUnlatch();
+        buffer_pool_manager_->UnpinPage(ptr->GetPageId(), true);
+        return;
+      }
+      parent_ptr->WLatch();
+      parent_ptr = BLinkMoveRight(parent_ptr, key, true);
+    } else {
+      latch_.WLock();
+      if (root_page_id_ == ptr->GetPageId()) {
+        Page *root_ptr = new_pages->back();
+        new_pages->pop_back();
+        page_id_t id = root_ptr->GetPageId();
+        auto root_page = reinterpret_cast<InternalPage *>(root_ptr->GetData());
+        root_page->Init(id, INVALID_PAGE_ID, internal_max_size_, key_size_);
+        root_page->SetLevel(level + 1);
+        root_page->SetValueAt(0, ptr->GetPageId());
+        root_page->SetKeyAt(1, key);
+        root_page->SetValueAt(1, new_page_id);
+        root_page->SetSize(2);
+        root_page_id_ = id;
+        UpdateRootPageId();
+        latch_.WUnlock();
+        buffer_pool_manager_->UnpinPage(id, true);
+        ptr->WUnlatch();
+        buffer_pool_manager_->UnpinPage(ptr->GetPageId(), true);
+        return;
+      }
+      latch_.WUnlock();
+      parent_ptr = BLinkDescend(key, level + 1, true, path);
+    }
+    ptr->WUnlatch();
+    buffer_pool_manager_->UnpinPage(ptr->GetPageId(), true);
+
+    auto page = reinterpret_cast<InternalPage *>(parent_ptr->GetData());
+    int size = page->GetSize();
+    int pos = BinarySearch(1, size, key, page) + 1;
+    if (size < page->GetMaxSize()) {
+      page->MoveBack(pos);
+      page->SetKeyAt(pos, key);
+      page->SetValueAt(pos, new_page_id);
+      page->IncreaseSize();
+      parent_ptr->WUnlatch();
+      buffer_pool_manager_->UnpinPage(parent_ptr->GetPageId(), true);
+      return;
+    }
+    // Split the parent as well: the upper half moves to a new right sibling, and its first key goes up a level.
+    std::vector<std::pair<KeyType, page_id_t>> entries;
+    entries.reserve(size + 1);
+    for (int i = 0; i < size; i++) {
+      entries.emplace_back(page->KeyAt(i), page->ValueAt(i));
+    }
+    entries.insert(entries.begin() + pos, {key, new_page_id});
+    page_id_t id = INVALID_PAGE_ID;
+    Page *new_ptr = nullptr;
+    if (new_pages->size() > 1) {
+      new_ptr = new_pages->back();
+      new_pages->pop_back();
+      id = new_ptr->GetPageId();
+    } else {
+      new_ptr = buffer_pool_manager_->NewPage(&id);
+      if (new_ptr == nullptr) {
+        parent_ptr->WUnlatch();
+        buffer_pool_manager_->UnpinPage(parent_ptr->GetPageId(), false);
+        return;
+      }
+    }
+    int len = Ceil(size + 1, 2);
+    auto new_inter_page = reinterpret_cast<InternalPage *>(new_ptr->GetData());
+    new_inter_page->Init(id, INVALID_PAGE_ID, internal_max_size_, key_size_);
+    new_inter_page->SetLevel(page->GetLevel());
+    for (int i = 0; i <= size; i++) {
+      InternalPage *half = i < len ? page : new_inter_page;
+      half->SetKeyAt(i < len ? i : i - len, entries[i].first);
+      half->SetValueAt(i < len ? i : i - len, entries[i].second);
+    }
+    new_inter_page->SetSize(size + 1 - len);
+    page->SetSize(len);
+    key = entries[len].first;
+    new_inter_page->SetHighKey(page->GetHighKey());
+    new_inter_page->SetNextPageId(page->GetNextPageId());
+    page->SetHighKey(key);
+    page->SetNextPageId(id);
+    buffer_pool_manager_->UnpinPage(id, true);
+    ptr = parent_ptr;
+    new_page_id = id;
+  }
+}
+
+/*
+ * Take the entry out of its leaf. Pages are never merged or deleted in B-link mode, so that a descent can always move
+ * right from a page it read a pointer to; leaves may end up empty.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BLinkRemove(const KeyType &key) {
+  Page *ptr = BLinkDescend(key, 0, true, nullptr);
+  if (ptr == nullptr) {
+    return;
+  }
+  auto page_ptr = reinterpret_cast<LeafPage *>(ptr->GetData());
+  int pos = page_ptr->FindKeyPos(key, comparator_);
+  if (pos != -1) {
+    page_ptr->MoveForward(pos + 1);
+  }
+  ptr->WUnlatch();
+  buffer_pool_manager_->UnpinPage(ptr->GetPageId(), pos != -1);
+}
+
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+/*
+ * Sort the entries added to the sorter and build the tree out of them level by level, instead of descending from the
+ * root once per entry. Every level is filled left to right, and only the node being filled on each level is pinned.
+ * Nodes hold about fill_factor of their maximum size, but never less than half of it, which removes would take for an
+ * underflow; the entries of a level are spread evenly over its nodes, so that the last one is not left nearly empty.
+ * Right links and high keys are set too, so the tree can be used in either mode.
+ * @return : false if the tree is not empty, or the buffer pool ran out of frames, in which case the tree stays empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoad(ExternalSorter<KeyType, ValueType, KeyComparator> *sorter, double fill_factor) -> bool {
+  latch_.WLock();
+  if (root_page_id_ != INVALID_PAGE_ID) {
+    latch_.WUnlock();
+    return false;
+  }
+  sorter->Sort();
+  if (sorter->Size() == 0) {
+    latch_.WUnlock();
+    return true;
+  }
+  int leaf_size = std::clamp(static_cast<int>(leaf_max_size_ * fill_factor), Ceil(leaf_max_size_, 2), leaf_max_size_);
+  int internal_size =
+      std::clamp(static_cast<int>(internal_max_size_ * fill_factor), Ceil(internal_max_size_, 2), internal_max_size_);
+  std::vector<BulkLoadLevel> levels;
+  levels.push_back({sorter->Size(), BulkLoadNodes(sorter->Size(), leaf_size, leaf_max_size_, false)});
+  while (levels.back().num_nodes_ > 1) {
+    size_t num_children = levels.back().num_nodes_;
+    levels.push_back({num_children, BulkLoadNodes(num_children, internal_size, internal_max_size_, true)});
+  }
+
+  auto &leaves = levels[0];
+  MappingType entry;
+  while (sorter->Next(&entry)) {
+    if ((leaves.page_ == nullptr || leaves.filled_ == leaves.NodeSize()) && !BulkLoadOpenNode(&levels, 0, entry.first)) {
+      // Give back everything built so far.
+      for (auto &level : levels) {
+        if (level.page_ != nullptr) {
+          buffer_pool_manager_->UnpinPage(level.page_->GetPageId(), false);
+        }
+        for (page_id_t page_id : level.page_ids_) {
+          buffer_pool_manager_->DeletePage(page_id);
+        }
+      }
+      latch_.WUnlock();
+      return false;
+    }
+    auto leaf_page_ptr = reinterpret_cast<LeafPage *>(leaves.page_->GetData());
+    leaf_page_ptr->SetKeyAt(leaves.filled_, entry.first);
+    leaf_page_ptr->SetValueAt(leaves.filled_, entry.second);
+    leaf_page_ptr->SetSize(++leaves.filled_);
+  }
+  // The last node of every level is the rightmost one, which keeps the right link it was initialized with.
+  root_page_id_ = levels.back().page_->GetPageId();
+  for (auto &level : levels) {
+    buffer_pool_manager_->UnpinPage(level.page_->GetPageId(), true);
+  }
+  UpdateRootPageId();
+  latch_.WUnlock();
+  return true;
+}
+
+/*
+ * @return : the number of nodes num_entries entries of a level are spread over, each taking at least target_size of
+ * them, or as few nodes of at most max_size as they fit in if that leaves too many for a node
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoadNodes(size_t num_entries, int target_size, int max_size, bool internal) -> size_t {
+  size_t num_nodes = std::max<size_t>(num_entries / target_size, 1);
+  if (num_entries > num_nodes * max_size) {
+    num_nodes = (num_entries + max_size - 1) / max_size;
+  }
+  // An internal page needs two children, unless it is the root of a tree of one leaf.
+  if (internal && num_nodes > 1 && num_entries / num_nodes < 2) {
+    num_nodes = num_entries / 2;
+  }
+  return num_nodes;
+}
+
+/*
+ * Start a new node on a level, whose first key is first_key. The node filled so far on that level, if any, is complete:
+ * link it to the new one and unpin it. The new node is added to its parent right away, which opens a new parent too if
+ * the current one is full.
+ * @return : false if there is no free frame for a new node
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoadOpenNode(std::vector<BulkLoadLevel> *levels, size_t level, const KeyType &first_key)
+    -> bool {
+  auto &current = (*levels)[level];
+  page_id_t id = INVALID_PAGE_ID;
+  Page *ptr = buffer_pool_manager_->NewPage(&id);
+  if (ptr == nullptr) {
+    return false;
+  }
+  current.page_ids_.push_back(id);
+  if (current.page_ != nullptr) {
+    auto page = reinterpret_cast<BPlusTreePage *>(current.page_->GetData());
+    if (page->IsLeafPage()) {
+      reinterpret_cast<LeafPage *>(page)->SetNextPageId(id);
+      reinterpret_cast<LeafPage *>(page)->SetHighKey(first_key);
+    } else {
+      reinterpret_cast<InternalPage *>(page)->SetNextPageId(id);
+      reinterpret_cast<InternalPage *>(page)->SetHighKey(first_key);
+    }
+    buffer_pool_manager_->UnpinPage(current.page_->GetPageId(), true);
+    current.node_index_++;
+  }
+  current.page_ = ptr;
+  current.filled_ = 0;
+  page_id_t parent_page_id = INVALID_PAGE_ID;
+  if (level + 1 < levels->size()) {
+    parent_page_id = BulkLoadAddChild(levels, level + 1, first_key, id);
+    if (parent_page_id == INVALID_PAGE_ID) {
+      return false;
+    }
+  }
+  if (level == 0) {
+    reinterpret_cast<LeafPage *>(ptr->GetData())->Init(id, parent_page_id, leaf_max_size_, key_size_);
+  } else {
+    auto inter_page_ptr = reinterpret_cast<InternalPage *>(ptr->GetData());
+    inter_page_ptr->Init(id, parent_page_id, internal_max_size_, key_size_);
+    inter_page_ptr->SetLevel(static_cast<int>(level));
+  }
+  return true;
+}
+
+/*
+ * Append a child to the node being filled on an internal level, opening a new node first if that one is full.
+ * @return : the page id of the node the child went into, its parent, or INVALID_PAGE_ID if there is no free frame for it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoadAddChild(std::vector<BulkLoadLevel> *levels, size_t level, const KeyType &key,
+                                      page_id_t child_page_id) -> page_id_t {
+  auto &current = (*levels)[level];
+  if ((current.page_ == nullptr || current.filled_ == current.NodeSize()) && !BulkLoadOpenNode(levels, level, key)) {
+    return INVALID_PAGE_ID;
+  }
+  auto inter_page_ptr = reinterpret_cast<InternalPage *>(current.page_->GetData());
+  inter_page_ptr->SetKeyAt(current.filled_, key);
+  inter_page_ptr->SetValueAt(current.filled_, child_page_id);
+  inter_page_ptr->SetSize(++current.filled_);
+  return current.page_->GetPageId();
+}
+
 /*****************************************************************************
  * INDEX ITERATOR
  *****************************************************************************/
@@ -718,17 +1412,12 @@ auto BPLUSTREE_TYPE::FindBrother(BPlusTreePage *page, page_id_t parent_page_id,
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
-  std::scoped_lock<std::mutex> latch(mtx_);
-  if (root_page_id_ == INVALID_PAGE_ID) {
+  Page *leaf_page = FindEdgeLeaf(false);
+  if (leaf_page == nullptr) {
     return INDEXITERATOR_TYPE();
   }
-  auto page_ptr = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(root_page_id_)->GetData());
-  while (!(page_ptr->IsLeafPage())) {
-    page_id_t child_page_id = (reinterpret_cast<InternalPage *>(page_ptr))->ValueAt(0);
-    buffer_pool_manager_->UnpinPage(page_ptr->GetPageId(), false);
-    page_ptr = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(child_page_id)->GetData());
-  }
-  page_id_t id = page_ptr->GetPageId();
+  page_id_t id = leaf_page->GetPageId();
+  leaf_page->RUnlatch();
   buffer_pool_manager_->UnpinPage(id, false);
   return INDEXITERATOR_TYPE(buffer_pool_manager_, id);
 }
@@ -740,16 +1429,13 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
-  std::scoped_lock<std::mutex> latch(mtx_);
-  if (root_page_id_ == INVALID_PAGE_ID) {
-    return INDEXITERATOR_TYPE();
-  }
-  page_id_t leaf_page_id = INVALID_PAGE_ID;
-  LeafPage *page_ptr = DfsFindPage(key, root_page_id_, leaf_page_id);
-  if (page_ptr == nullptr) {
+  Page *leaf_page = FindLeaf(key, Operation::SEARCH);
+  if (leaf_page == nullptr) {
     return INDEXITERATOR_TYPE();
   }
-  int pos = page_ptr->FindKeyPos(key, comparator_);
+  page_id_t leaf_page_id = leaf_page->GetPageId();
+  int pos = reinterpret_cast<LeafPage *>(leaf_page->GetData())->FindKeyPos(key, comparator_);
+  leaf_page->RUnlatch();
   buffer_pool_manager_->UnpinPage(leaf_page_id, false);
   if (pos == -1) {
     return INDEXITERATOR_TYPE();
@@ -764,22 +1450,57 @@ auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE {
-  std::scoped_lock<std::mutex> latch(mtx_);
-  if (root_page_id_ == INVALID_PAGE_ID) {
+  Page *leaf_page = FindEdgeLeaf(true);
+  if (leaf_page == nullptr) {
     return INDEXITERATOR_TYPE();
   }
-  auto page_ptr = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(root_page_id_)->GetData());
-  while (!(page_ptr->IsLeafPage())) {
-    page_id_t child_page_id = (reinterpret_cast<InternalPage *>(page_ptr))->ValueAt(page_ptr->GetSize() - 1);
-    buffer_pool_manager_->UnpinPage(page_ptr->GetPageId(), false);
-    page_ptr = reinterpret_cast<BPlusTreePage *>(buffer_pool_manager_->FetchPage(child_page_id)->GetData());
-  }
-  page_id_t id = page_ptr->GetPageId();
-  int index = page_ptr->GetSize();
+  page_id_t id = leaf_page->GetPageId();
+  int index = reinterpret_cast<LeafPage *>(leaf_page->GetData())->GetSize();
+  leaf_page->RUnlatch();
   buffer_pool_manager_->UnpinPage(id, false);
   return INDEXITERATOR_TYPE(buffer_pool_manager_, id, index);
 }
 
+/*
+ * Crab down the leftmost or rightmost path with read latches.
+ * @return : the first or last leaf, pinned and read-latched, or nullptr if the tree is empty or the pool has no frame
+ * for a page on the way
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindEdgeLeaf(bool rightmost) -> Page * {
+  if (mode_ == BPlusTreeMode::B_LINK) {
+    return BLinkFindEdgeLeaf(rightmost);
+  }
+  latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    latch_.RUnlock();
+    return nullptr;
+  }
+  Page *ptr = buffer_pool_manager_->FetchPage(root_page_id_);
+  if (ptr == nullptr) {
+    latch_.RUnlock();
+    return nullptr;
+  }
+  ptr->RLatch();
+  latch_.RUnlock();
+  auto page_ptr = reinterpret_cast<BPlusTreePage *>(ptr->GetData());
+  while (!(page_ptr->IsLeafPage())) {
+    auto inter_page_ptr = reinterpret_cast<InternalPage *>(page_ptr);
+    Page *child_ptr = buffer_pool_manager_->FetchPage(inter_page_ptr->ValueAt(rightmost ? page_ptr->GetSize() - 1 : 0));
+    if (child_ptr != nullptr) {
+      child_ptr->RLatch();
+    }
+    ptr->RUnlatch();
+    buffer_pool_manager_->UnpinPage(ptr->GetPageId(), false);
+    if (child_ptr == nullptr) {
+      return nullptr;
+    }
+    ptr = child_ptr;
+    page_ptr = reinterpret_cast<BPlusTreePage *>(ptr->GetData());
+  }
+  return ptr;
+}
+
 /**
  * @return Page id of the root of this tree
  */
@@ -800,6 +1521,8 @@ auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t { return root_page_id_; }
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
   auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  // Other trees update their own records in the same page.
+  header_page->WLatch();
   if (insert_record != 0) {
     // create a new record<index_name + root_page_id> in header_page
     header_page->InsertRecord(index_name_, root_page_id_);
@@ -807,6 +1530,7 @@ void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
+  header_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
@@ -0,0 +1,191 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sorter.cpp
+//
+// Identification: src/storage/index/external_sorter.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/external_sorter.h"
+
+#include <algorithm>
+#include <queue>
+#include <type_traits>
+
+#include "common/exception.h"
+#include "common/rid.h"
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+INDEX_TEMPLATE_ARGUMENTS
+EXTERNAL_SORTER_TYPE::ExternalSorter(const KeyComparator &comparator, size_t memory_limit)
+    : comparator_(comparator), max_buffered_(std::max<size_t>(1, memory_limit / sizeof(MappingType))) {
+  static_assert(std::is_trivially_copyable_v<KeyType> && std::is_trivially_copyable_v<ValueType>,
+                "entries are written out to runs byte for byte");
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+EXTERNAL_SORTER_TYPE::~ExternalSorter() {
+  for (FILE *run : runs_) {
+    fclose(run);
+  }
+  if (output_ != nullptr) {
+    fclose(output_);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORTER_TYPE::Add(const KeyType &key, const ValueType &value) {
+  BUSTUB_ASSERT(!sorted_, "cannot add entries after sorting");
+  if (buffer_.size() >= max_buffered_) {
+    SpillRun();
+  }
+  buffer_.emplace_back(key, value);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORTER_TYPE::Sort() {
+  BUSTUB_ASSERT(!sorted_, "entries are already sorted");
+  sorted_ = true;
+  if (runs_.empty()) {
+    SortBuffer();
+    size_ = buffer_.size();
+    return;
+  }
+  if (!buffer_.empty()) {
+    SpillRun();
+  }
+  std::vector<MappingType>().swap(buffer_);
+  while (runs_.size() > 1) {
+    // Merging neighbouring runs keeps the earliest of the entries with equal keys first.
+    std::vector<FILE *> merged;
+    for (size_t begin = 0; begin < runs_.size(); begin += MERGE_FAN_IN) {
+      std::vector<FILE *> group(runs_.begin() + begin, runs_.begin() + std::min(begin + MERGE_FAN_IN, runs_.size()));
+      if (group.size() == 1) {
+        merged.push_back(group[0]);
+        continue;
+      }
+      FILE *output = NewRunFile();
+      MergeRuns(group, output);
+      for (FILE *run : group) {
+        fclose(run);
+      }
+      merged.push_back(output);
+    }
+    runs_ = std::move(merged);
+  }
+  output_ = runs_[0];
+  runs_.clear();
+  fseek(output_, 0, SEEK_END);
+  size_ = static_cast<size_t>(ftell(output_)) / (sizeof(KeyType) + sizeof(ValueType));
+  rewind(output_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_SORTER_TYPE::Next(MappingType *entry) -> bool {
+  BUSTUB_ASSERT(sorted_, "entries must be sorted first");
+  if (output_ != nullptr) {
+    return ReadEntry(output_, entry);
+  }
+  if (next_ == buffer_.size()) {
+    return false;
+  }
+  *entry = buffer_[next_++];
+  return true;
+}
+
+/*
+ * Sort the buffered entries and drop the duplicate keys. The sort is stable, so the first entry added for a key stays.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORTER_TYPE::SortBuffer() {
+  auto less = [this](const MappingType &a, const MappingType &b) { return comparator_(a.first, b.first) < 0; };
+  auto equal = [this](const MappingType &a, const MappingType &b) { return comparator_(a.first, b.first) == 0; };
+  std::stable_sort(buffer_.begin(), buffer_.end(), less);
+  buffer_.erase(std::unique(buffer_.begin(), buffer_.end(), equal), buffer_.end());
+}
+
+/*
+ * Write the buffered entries out as a new run, sorted and without duplicate keys.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORTER_TYPE::SpillRun() {
+  SortBuffer();
+  FILE *run = NewRunFile();
+  for (const auto &entry : buffer_) {
+    WriteEntry(run, entry);
+  }
+  rewind(run);
+  runs_.push_back(run);
+  num_runs_++;
+  buffer_.clear();
+}
+
+/*
+ * Merge sorted runs into output, keeping only the entry of the earliest run for equal keys. The output is rewound.
+ * @return : the number of entries written
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_SORTER_TYPE::MergeRuns(const std::vector<FILE *> &runs, FILE *output) -> size_t {
+  auto greater = [this](const MergeEntry &a, const MergeEntry &b) {
+    int cmp = comparator_(a.entry_.first, b.entry_.first);
+    return cmp > 0 || (cmp == 0 && a.run_ > b.run_);
+  };
+  std::priority_queue<MergeEntry, std::vector<MergeEntry>, decltype(greater)> heap(greater);
+  for (size_t run = 0; run < runs.size(); run++) {
+    MergeEntry head{{}, run};
+    if (ReadEntry(runs[run], &head.entry_)) {
+      heap.push(head);
+    }
+  }
+  size_t count = 0;
+  KeyType last_key;
+  while (!heap.empty()) {
+    MergeEntry head = heap.top();
+    heap.pop();
+    if (count == 0 || comparator_(head.entry_.first, last_key) != 0) {
+      WriteEntry(output, head.entry_);
+      last_key = head.entry_.first;
+      count++;
+    }
+    if (ReadEntry(runs[head.run_], &head.entry_)) {
+      heap.push(head);
+    }
+  }
+  rewind(output);
+  return count;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_SORTER_TYPE::NewRunFile() -> FILE * {
+  FILE *file = std::tmpfile();
+  if (file == nullptr) {
+    throw Exception("cannot create a temporary file for an external sort run");
+  }
+  return file;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void EXTERNAL_SORTER_TYPE::WriteEntry(FILE *file, const MappingType &entry) {
+  if (fwrite(&entry.first, sizeof(KeyType), 1, file) != 1 || fwrite(&entry.second, sizeof(ValueType), 1, file) != 1) {
+    throw Exception("cannot write an external sort run");
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto EXTERNAL_SORTER_TYPE::ReadEntry(FILE *file, MappingType *entry) -> bool {
+  return fread(&entry->first, sizeof(KeyType), 1, file) == 1 && fread(&entry->second, sizeof(ValueType), 1, file) == 1;
+}
+
+template class ExternalSorter<GenericKey<4>, RID, GenericComparator<4>>;
+template class ExternalSorter<GenericKey<8>, RID, GenericComparator<8>>;
+template class ExternalSorter<GenericKey<16>, RID, GenericComparator<16>>;
+template class ExternalSorter<GenericKey<32>, RID, GenericComparator<32>>;
+template class ExternalSorter<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
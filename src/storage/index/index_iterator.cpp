@@ -14,9 +14,12 @@ namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *buffer_pool_manager, page_id_t page_id, int index)
     : buffer_pool_manager_(buffer_pool_manager), page_id_(page_id), index_(index) {
+  page_ = nullptr;
   leaf_page_ = nullptr;
   if (page_id_ != INVALID_PAGE_ID) {
-    leaf_page_ = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(page_id)->GetData());
+    page_ = buffer_pool_manager_->FetchPage(page_id);
+    leaf_page_ = reinterpret_cast<LeafPage *>(page_->GetData());
+    SkipExhaustedLeaves();
   }
 }
 
@@ -32,10 +35,10 @@ auto INDEXITERATOR_TYPE::IsEnd() -> bool {
   if (page_id_ == INVALID_PAGE_ID) {
     return true;
   }
-  if (index_ == leaf_page_->GetSize() - 1 && leaf_page_->GetNextPageId() == INVALID_PAGE_ID) {
-    return true;
-  }
-  return false;
+  page_->RLatch();
+  bool is_end = index_ == leaf_page_->GetSize() - 1 && leaf_page_->GetNextPageId() == INVALID_PAGE_ID;
+  page_->RUnlatch();
+  return is_end;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -46,7 +49,10 @@ auto INDEXITERATOR_TYPE::operator*() -> const MappingType & {
   if (page_id_ == INVALID_PAGE_ID) {
     return temp;
   }
-  return *(leaf_page_->ArrPtr(index_));
+  page_->RLatch();
+  entry_ = {leaf_page_->KeyAt(index_), leaf_page_->ValueAt(index_)};
+  page_->RUnlatch();
+  return entry_;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -54,20 +60,52 @@ auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
   if (page_id_ == INVALID_PAGE_ID) {
     throw std::runtime_error("page_id is invalid!");
   }
-  if (index_ < leaf_page_->GetSize() - 1) {
-    index_++;
-  } else {
+  index_++;
+  SkipExhaustedLeaves();
+  return *this;
+}
+
+/*
+ * Move on to the next leaf with entries once the current one is exhausted. The last leaf is never left, so that
+ * the iterator ends up equal to End(). Leaves are only empty in B-link mode, which does not merge them away.
+ *
+ * The read latch is handed over from leaf to leaf. A writer may hold the next leaf while it waits for this one, since
+ * a merge latches the left sibling last, so the next latch is only waited for once this one is released. The next
+ * leaf stays pinned meanwhile: if it is merged away, it still holds the entries and the link that were moved left.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+  page_->RLatch();
+  while (index_ >= leaf_page_->GetSize() && leaf_page_->GetNextPageId() != INVALID_PAGE_ID) {
     page_id_t next = leaf_page_->GetNextPageId();
-    if (next == INVALID_PAGE_ID) {
-      index_++;
-    } else {
-      buffer_pool_manager_->UnpinPage(page_id_, false);
-      leaf_page_ = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(next)->GetData());
-      page_id_ = next;
-      index_ = 0;
+    Page *next_page = buffer_pool_manager_->FetchPage(next);
+    bool latched = next_page->TryRLatch();
+    page_->RUnlatch();
+    if (!latched) {
+      next_page->RLatch();
+    }
+    buffer_pool_manager_->UnpinPage(page_id_, false);
+    page_ = next_page;
+    leaf_page_ = reinterpret_cast<LeafPage *>(page_->GetData());
+    page_id_ = next;
+    index_ = 0;
+    if (read_ahead_countdown_ == 0) {
+      page_id_t read_ahead = leaf_page_->GetNextPageId();
+      page_->RUnlatch();
+      buffer_pool_manager_->ReadAhead(read_ahead, NextLeafPage, READ_AHEAD_PAGES);
+      page_->RLatch();
+      read_ahead_countdown_ = READ_AHEAD_PAGES / 2;
     }
+    read_ahead_countdown_--;
   }
-  return *this;
+  page_->RUnlatch();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::NextLeafPage(Page *page) -> page_id_t {
+  // The leaf may have been merged away and its page reused since the hint was given.
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  return leaf->IsLeafPage() ? leaf->GetNextPageId() : INVALID_PAGE_ID;
 }
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
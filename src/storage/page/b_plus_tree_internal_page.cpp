@@ -25,15 +25,18 @@ namespace bustub {
  * max page size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size, int key_size) {
   SetParentPageId(parent_id);
   SetPageId(page_id);
-  if (static_cast<uint64_t>(max_size) > INTERNAL_PAGE_SIZE) {
-    max_size = INTERNAL_PAGE_SIZE;
+  SetKeySize(key_size);
+  if (max_size < 0 || max_size > Capacity(key_size)) {
+    max_size = Capacity(key_size);
   }
   SetMaxSize(max_size);
   SetPageType(IndexPageType::INTERNAL_PAGE);
   SetSize(0);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetLevel(1);
   SetLSN();
 }
 
@@ -42,20 +45,32 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType { return (array_ + index)->first; }
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType {
+  KeyType key{};
+  memcpy(reinterpret_cast<void *>(&key), KeyPtr(index), StoredKeySize());
+  return key;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) { (array_ + index)->first = key; }
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
+  memcpy(KeyPtr(index), reinterpret_cast<const void *>(&key), StoredKeySize());
+}
 
 /*
  * Helper method to get the value associated with input "index"(a.k.a array
  * offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType { return (array_ + index)->second; }
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType {
+  ValueType value;
+  memcpy(reinterpret_cast<void *>(&value), ValuePtr(index), sizeof(ValueType));
+  return value;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetValueAt(int index, const ValueType &value) { (array_ + index)->second = value; }
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetValueAt(int index, const ValueType &value) {
+  memcpy(ValuePtr(index), reinterpret_cast<const void *>(&value), sizeof(ValueType));
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::FindValuePos(const ValueType &value) const -> int {
@@ -68,60 +83,40 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::FindValuePos(const ValueType &value) const
   return -1;
 }
 
+/*
+ * @return : the index of key among the valid keys, from index 1 on, or -1 if the page does not hold it
+ */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::FindKeyPos(const KeyType &key, const KeyComparator &cmp) const -> int {
-  // for (int i = 1; i < GetSize(); i++) {
-  //   auto temp = KeyAt(i);
-  //   if (cmp(temp, key) == 0) {
-  //     return i;
-  //   }
-  // }
-  // return 0;
-  int l = 1;
-  int r = GetSize() - 1;
-  int middle = 0;
-  while (l < r) {
-    middle = l + (r - l) / 2;
-    auto res = cmp(KeyAt(middle), key);
-    if (res >= 0) {
-      r = middle;
-    } else {
-      l = middle + 1;
-    }
-  }
-  if (cmp(KeyAt(l), key) != 0) {
+  int pos = KeyBound(1, GetSize(), key, cmp);
+  if (pos >= GetSize() || cmp(KeyAt(pos), key) != 0) {
     return -1;
   }
-  return l;
+  return pos;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveBack(int index) {
-  char buff[BUSTUB_PAGE_SIZE] = {0};
-  auto src_ptr = reinterpret_cast<void *>(ArrPtr(index));
-  size_t num = GetSize() - index;
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyEntries(const BPlusTreeInternalPage *src, int src_index, int index, int num) {
   if (num <= 0) {
     return;
   }
-  memcpy(reinterpret_cast<void *>(buff), src_ptr, num * CellSize());
-  auto dsc_ptr = reinterpret_cast<void *>(ArrPtr(index + 1));
-  memcpy(dsc_ptr, reinterpret_cast<void *>(buff), num * CellSize());
+  memmove(KeyPtr(index), src->KeyPtr(src_index), num * StoredKeySize());
+  memmove(ValuePtr(index), src->ValuePtr(src_index), num * sizeof(ValueType));
 }
 
+/*
+ * Shift the entries from index on one slot back, to make room for an entry at index.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveBack(int index) { CopyEntries(this, index, index + 1, GetSize() - index); }
+
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveForward(int index) {
   if (index <= 0) {
     throw std::logic_error("internal page moveforward error!");
     return;
   }
-  size_t num = GetSize() - index;
-  if (num <= 0) {
-    DecreaseSize();
-    return;
-  }
-  auto src_ptr = ArrPtr(index);
-  auto dst_ptr = ArrPtr(index - 1);
-  memmove(reinterpret_cast<void *>(dst_ptr), reinterpret_cast<void *>(src_ptr), num * CellSize());
+  CopyEntries(this, index, index - 1, GetSize() - index);
   DecreaseSize();
 }
 
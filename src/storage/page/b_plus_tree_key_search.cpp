@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_key_search.cpp
+//
+// Identification: src/storage/page/b_plus_tree_key_search.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/b_plus_tree_key_search.h"
+
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace bustub {
+
+namespace {
+
+auto LoadKey(const char *keys, int index) -> int32_t {
+  int32_t key;
+  memcpy(&key, keys + index * sizeof(int32_t), sizeof(int32_t));
+  return key;
+}
+
+}  // namespace
+
+auto KeySearch<GenericKey<4>, GenericComparator<4>>::CountBelow(const char *keys, int begin, int end, int32_t target,
+                                                               bool or_equal) -> int {
+  // Counting the keys less than or equal to target is counting the keys less than target + 1.
+  if (or_equal) {
+    if (target == std::numeric_limits<int32_t>::max()) {
+      return end;
+    }
+    target++;
+  }
+  // Narrow the range down; the keys it loses on the left are all below target.
+  while (end - begin > SEARCH_BLOCK) {
+    int middle = begin + (end - begin) / 2;
+    if (LoadKey(keys, middle) < target) {
+      begin = middle + 1;
+    } else {
+      end = middle;
+    }
+  }
+  int count = begin;
+  int i = begin;
+#if defined(__SSE2__)
+  const __m128i bound = _mm_set1_epi32(target);
+  __m128i counts = _mm_setzero_si128();
+  for (; i + 4 <= end; i += 4) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i * sizeof(int32_t)));
+    // A lane is all ones, that is -1, where the key is below the bound.
+    counts = _mm_sub_epi32(counts, _mm_cmpgt_epi32(bound, block));
+  }
+  alignas(16) int32_t lanes[4];
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes), counts);
+  count += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+  for (; i < end; i++) {
+    count += static_cast<int>(LoadKey(keys, i) < target);
+  }
+  return count;
+}
+
+}  // namespace bustub
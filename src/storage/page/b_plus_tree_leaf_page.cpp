@@ -28,11 +28,12 @@ namespace bustub {
  * next page id and set max size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size, int key_size) {
   SetPageId(page_id);
   SetParentPageId(parent_id);
-  if (static_cast<uint64_t>(max_size) > LEAF_PAGE_SIZE) {
-    max_size = LEAF_PAGE_SIZE;
+  SetKeySize(key_size);
+  if (max_size < 0 || max_size > Capacity(key_size)) {
+    max_size = Capacity(key_size);
   }
   SetMaxSize(max_size);
   SetPageType(IndexPageType::LEAF_PAGE);
@@ -55,114 +56,73 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_pa
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType { return (array_ + index)->first; }
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType {
+  KeyType key{};
+  memcpy(reinterpret_cast<void *>(&key), KeyPtr(index), StoredKeySize());
+  return key;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const -> ValueType { return (array_ + index)->second; }
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const -> ValueType {
+  ValueType value;
+  memcpy(reinterpret_cast<void *>(&value), ValuePtr(index), sizeof(ValueType));
+  return value;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) { (array_ + index)->first = key; }
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
+  memcpy(KeyPtr(index), reinterpret_cast<const void *>(&key), StoredKeySize());
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::SetValueAt(int index, const ValueType &value) { (array_ + index)->second = value; }
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetValueAt(int index, const ValueType &value) {
+  memcpy(ValuePtr(index), reinterpret_cast<const void *>(&value), sizeof(ValueType));
+}
 
+/*
+ * @return : the index to insert key at, or -1 if the page already holds it
+ */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::FindInsertPos(const KeyType &key, const KeyComparator &cmp) const -> int {
-  // int len = GetSize();
-  // if (len == 0) return 0;
-  // int i = 0;
-  // for (;i < len; i++) {
-  //   auto temp_key = KeyAt(i);
-  //   int res = cmp(temp_key, key);
-  //   if (res == 0) {
-  //     return -1;
-  //   }
-  //   if (res > 0) {
-  //     break;
-  //   }
-  // }
-  // return i;
-  if (GetSize() == 0) {
-    return 0;
-  }
-  int l = 0;
-  int r = GetSize() - 1;
-  int middle = 0;
-  while (l < r) {
-    middle = l + (r - l) / 2;
-    auto res = cmp(KeyAt(middle), key);
-    if (res >= 0) {
-      r = middle;
-    } else {
-      l = middle + 1;
-    }
-  }
-  auto res = cmp(KeyAt(l), key);
-  if (res == 0) {
+  int pos = KeyBound(0, GetSize(), key, cmp);
+  if (pos < GetSize() && cmp(KeyAt(pos), key) == 0) {
     return -1;
   }
-  if (res < 0) {
-    l++;
-  }
-  return l;
+  return pos;
 }
 
+/*
+ * @return : the index of key, or -1 if the page does not hold it
+ */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::FindKeyPos(const KeyType &key, const KeyComparator &cmp) const -> int {
-  // int len = GetSize();
-  // int i = 0;
-  // for (;i < len; i++) {
-  //   auto temp_key = KeyAt(i);
-  //   int res = cmp(temp_key, key);
-  //   if (res == 0) {
-  //     return i;
-  //   }
-  // }
-  // return -1;
-  if (GetSize() == 0) {
-    return 0;
-  }
-  int l = 0;
-  int r = GetSize() - 1;
-  int middle = 0;
-  while (l < r) {
-    middle = l + (r - l) / 2;
-    auto res = cmp(KeyAt(middle), key);
-    if (res >= 0) {
-      r = middle;
-    } else {
-      l = middle + 1;
-    }
-  }
-  if (cmp(KeyAt(l), key) != 0) {
+  int pos = KeyBound(0, GetSize(), key, cmp);
+  if (pos == GetSize() || cmp(KeyAt(pos), key) != 0) {
     return -1;
   }
-  return l;
+  return pos;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveBack(int index) {
-  char buff[BUSTUB_PAGE_SIZE] = {0};
-  auto src_ptr = reinterpret_cast<void *>(ArrPtr(index));
-  size_t num = GetSize() - index;
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyEntries(const BPlusTreeLeafPage *src, int src_index, int index, int num) {
   if (num <= 0) {
     return;
   }
-  memcpy(reinterpret_cast<void *>(buff), src_ptr, num * CellSize());
-  auto dsc_ptr = reinterpret_cast<void *>(ArrPtr(index + 1));
-  memcpy(dsc_ptr, reinterpret_cast<void *>(buff), num * CellSize());
+  memmove(KeyPtr(index), src->KeyPtr(src_index), num * StoredKeySize());
+  memmove(ValuePtr(index), src->ValuePtr(src_index), num * sizeof(ValueType));
 }
 
+/*
+ * Shift the entries from index on one slot back, to make room for an entry at index.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveBack(int index) { CopyEntries(this, index, index + 1, GetSize() - index); }
+
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveForward(int index) {
-  if (index <= 0 || (GetSize() - index) <= 0) {
-    DecreaseSize();
-    return;
+  if (index > 0) {
+    CopyEntries(this, index, index - 1, GetSize() - index);
   }
-  size_t num = GetSize() - index;
-  auto src_ptr = ArrPtr(index);
-  auto dst_ptr = ArrPtr(index - 1);
-  memmove(reinterpret_cast<void *>(dst_ptr), reinterpret_cast<void *>(src_ptr), num * CellSize());
   DecreaseSize();
 }
 
@@ -60,4 +60,10 @@ void BPlusTreePage::SetPageId(page_id_t page_id) { page_id_ = page_id; }
  */
 void BPlusTreePage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
 
+/*
+ * Helper methods to get/set the number of bytes stored per key
+ */
+auto BPlusTreePage::GetKeySize() const -> int { return key_size_; }
+void BPlusTreePage::SetKeySize(int key_size) { key_size_ = key_size; }
+
 }  // namespace bustub
@@ -18,8 +18,12 @@
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+/** Read-ahead follows the chain of table pages. */
+static auto NextTablePage(Page *page) -> page_id_t { return static_cast<TablePage *>(page)->GetNextPageId(); }
+
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                             std::shared_ptr<BufferAccessStrategy> strategy)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn), strategy_(std::move(strategy)) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
     if (!table_heap_->GetTuple(tuple_->rid_, tuple_, txn_)) {
       throw bustub::Exception("read non-existing tuple");
@@ -39,7 +43,7 @@ auto TableIterator::operator->() -> Tuple * {
 
 auto TableIterator::operator++() -> TableIterator & {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
+  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId(), strategy_.get()));
   BUSTUB_ENSURE(cur_page != nullptr, "BPM full");  // all pages are pinned
 
   cur_page->RLatch();
@@ -47,11 +51,19 @@ auto TableIterator::operator++() -> TableIterator & {
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  &next_tuple_rid)) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
+      auto next_page =
+          static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId(), strategy_.get()));
       cur_page->RUnlatch();
       buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
       cur_page = next_page;
       cur_page->RLatch();
+      // Keep the following pages on their way in while this one is processed. Hints overlap by half so that the scan
+      // never catches up with the read-ahead.
+      if (read_ahead_countdown_ == 0) {
+        buffer_pool_manager->ReadAhead(cur_page->GetNextPageId(), NextTablePage, READ_AHEAD_PAGES, strategy_);
+        read_ahead_countdown_ = READ_AHEAD_PAGES / 2;
+      }
+      read_ahead_countdown_--;
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
@@ -12,12 +12,25 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <fstream>
+#include <future>  // NOLINT
+#include <iostream>
+#include <mutex>  // NOLINT
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/disk/disk_manager_uring.h"
+#include "zipfian_generator.h"
 
 namespace bustub {
 
@@ -145,4 +158,882 @@ TEST(BufferPoolManagerInstanceTest, DISABLED_SampleTest) {
   delete disk_manager;
 }
 
+/** An in-memory disk whose reads and writes take a while, so that tests can observe what happens meanwhile. */
+class SlowDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override {
+    in_flight_++;
+    std::this_thread::sleep_for(delay_);
+    bool success = DiskManagerUnlimitedMemory::WritePage(page_id, page_data);
+    {
+      std::scoped_lock<std::mutex> lock(written_latch_);
+      written_.push_back(page_id);
+    }
+    in_flight_--;
+    return success;
+  }
+
+  auto ReadPage(page_id_t page_id, char *page_data) -> bool override {
+    reads_++;
+    in_flight_++;
+    std::this_thread::sleep_for(delay_);
+    bool success = DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+    in_flight_--;
+    return success;
+  }
+
+  std::chrono::milliseconds delay_{0};
+  std::atomic<int> in_flight_{0};
+  std::atomic<int> reads_{0};
+  /** Every page written so far, in order. */
+  std::vector<page_id_t> written_;
+  std::mutex written_latch_;
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, IOOutsideLatchTest) {
+  const size_t buffer_pool_size = 4;
+  auto disk_manager = std::make_unique<SlowDiskManager>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), 2);
+
+  // Create six pages with distinct content; only the last four stay resident and they are all dirty.
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 6; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  // Keep the newest page pinned so that it can never be chosen as a victim.
+  auto *resident = bpm->FetchPage(page_ids[5]);
+  ASSERT_NE(nullptr, resident);
+
+  disk_manager->delay_ = std::chrono::milliseconds(200);
+
+  // Scenario: a miss writes back a dirty victim and reads page 0. While that is in flight, a hit on a resident page
+  // must not wait for the disk.
+  auto miss = std::async(std::launch::async, [&] { return bpm->FetchPage(page_ids[0]); });
+  while (disk_manager->in_flight_ == 0) {
+    std::this_thread::yield();
+  }
+  auto start = std::chrono::steady_clock::now();
+  auto *hit = bpm->FetchPage(page_ids[5]);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  ASSERT_NE(nullptr, hit);
+  EXPECT_LT(elapsed, std::chrono::milliseconds(100));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[5], false));
+
+  // Scenario: a second fetcher of the page being loaded waits for that load and sees the loaded content.
+  auto *same = bpm->FetchPage(page_ids[0]);
+  ASSERT_NE(nullptr, same);
+  EXPECT_EQ(0, strcmp(same->GetData(), "page 0"));
+  auto *loaded = miss.get();
+  ASSERT_EQ(loaded, same);
+  EXPECT_EQ(2, loaded->GetPinCount());
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], false));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], false));
+
+  // Scenario: fetching the page that was just evicted while its write-back is still in flight returns its latest
+  // content rather than what was on disk before.
+  disk_manager->delay_ = std::chrono::milliseconds(0);
+  std::vector<std::future<Page *>> fetches;
+  for (int i = 1; i <= 4; i++) {
+    fetches.emplace_back(std::async(std::launch::async, [&, i] { return bpm->FetchPage(page_ids[i]); }));
+  }
+  for (int i = 1; i <= 4; i++) {
+    auto *page = fetches[i - 1].get();
+    if (page != nullptr) {
+      EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_ids[i])).c_str()));
+      EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    }
+  }
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[5], false));
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BackgroundFlusherTest) {
+  const size_t buffer_pool_size = 10;
+  auto disk_manager = std::make_unique<SlowDiskManager>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), 2);
+
+  // Fill the pool with dirty pages; none of the frames can be reused without a write-back.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: the flusher notices that fewer than half of the frames are clean and writes pages back in page id order
+  // until 80% of them are.
+  bpm->StartBackgroundFlusher(0.5, 0.8);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (bpm->GetFlushedPageCount() < 8 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(8, bpm->GetFlushedPageCount());
+  {
+    std::scoped_lock<std::mutex> lock(disk_manager->written_latch_);
+    EXPECT_EQ(std::vector<page_id_t>(page_ids.begin(), page_ids.begin() + 8), disk_manager->written_);
+  }
+
+  // Scenario: the victims for new pages are the clean ones, so the foreground never writes anything back.
+  for (size_t i = 0; i < 8; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, bpm->GetEvictedDirtyPageCount());
+  bpm->StopBackgroundFlusher();
+
+  // Scenario: the pages written in the background read back intact.
+  for (size_t i = 0; i < 8; i++) {
+    auto *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_ids[i])).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ReadAheadTest) {
+  const size_t buffer_pool_size = 64;
+  const int chain_length = 20;
+  auto disk_manager = std::make_unique<SlowDiskManager>();
+  // With k = 1 the replacer is plain LRU, which makes it easy to push pages out.
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), 1);
+
+  // Build a chain of pages, each storing the id of the next one in its first bytes, then push them all out of the
+  // pool with other pages.
+  std::vector<page_id_t> chain;
+  for (int i = 0; i < chain_length; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    chain.push_back(page_id);
+  }
+  for (int i = 0; i < chain_length; i++) {
+    auto *page = bpm->FetchPage(chain[i]);
+    *reinterpret_cast<page_id_t *>(page->GetData()) = i + 1 < chain_length ? chain[i + 1] : INVALID_PAGE_ID;
+    bpm->UnpinPage(chain[i], true);
+    bpm->UnpinPage(chain[i], true);
+  }
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+
+  // Scenario: a hint for the chain loads its pages in the background, capped at an eighth of the pool.
+  disk_manager->reads_ = 0;
+  bpm->ResetStats();
+  auto next_page = [](Page *page) { return *reinterpret_cast<page_id_t *>(page->GetData()); };
+  bpm->ReadAhead(chain[0], next_page, chain_length);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (disk_manager->reads_ < 8 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(8, disk_manager->reads_);
+  // Scenario: reading ahead is not a fetch, so it is not counted as one.
+  EXPECT_EQ(0, bpm->GetStats().Get(BufferPoolCounter::FETCH));
+  EXPECT_EQ(0, bpm->GetStats().Get(BufferPoolCounter::MISS));
+
+  // Scenario: the pages read ahead are hits, and they are not left pinned.
+  for (int i = 0; i < 8; i++) {
+    auto *page = bpm->FetchPage(chain[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_EQ(i + 1 < chain_length ? chain[i + 1] : INVALID_PAGE_ID, *reinterpret_cast<page_id_t *>(page->GetData()));
+    bpm->UnpinPage(chain[i], false);
+  }
+  EXPECT_EQ(8, disk_manager->reads_);
+  EXPECT_EQ(8, bpm->GetStats().Get(BufferPoolCounter::HIT));
+  EXPECT_NE(nullptr, bpm->FetchPage(chain[8]));
+  EXPECT_EQ(9, disk_manager->reads_);
+  bpm->UnpinPage(chain[8], false);
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, AccessStrategyTest) {
+  const size_t buffer_pool_size = 20;
+  const int table_size = 50;
+  const int num_hot_pages = 5;
+  auto disk_manager = std::make_unique<SlowDiskManager>();
+  // With k = 1 the replacer is plain LRU, which a scan flushes completely without an access strategy.
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), 1);
+
+  std::vector<page_id_t> table;
+  for (int i = 0; i < table_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    table.push_back(page_id);
+  }
+  std::vector<page_id_t> hot;
+  for (int i = 0; i < num_hot_pages; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    hot.push_back(page_id);
+  }
+  auto scan = [&](BufferAccessStrategy *strategy) {
+    for (page_id_t page_id : table) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id, strategy));
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+  };
+  auto hot_page_misses = [&] {
+    disk_manager->reads_ = 0;
+    for (page_id_t page_id : hot) {
+      EXPECT_NE(nullptr, bpm->FetchPage(page_id));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+    return disk_manager->reads_.load();
+  };
+
+  // Scenario: a scan through a ring of four frames leaves the rest of the pool, and the hot pages, alone.
+  BufferAccessStrategy strategy(4);
+  scan(&strategy);
+  EXPECT_EQ(0, hot_page_misses());
+
+  // Scenario: once the ring is full, it recycles its own frames: scanning the table again reads every page that is
+  // not resident, but still does not touch the hot pages.
+  disk_manager->reads_ = 0;
+  scan(&strategy);
+  EXPECT_GE(disk_manager->reads_, table_size - static_cast<int>(buffer_pool_size));
+  EXPECT_EQ(0, hot_page_misses());
+
+  // Scenario: the same scan without a strategy flushes the hot pages out.
+  scan(nullptr);
+  EXPECT_EQ(num_hot_pages, hot_page_misses());
+}
+
+/** Race lock-free hits against evictions in a pool that uses the given replacer. */
+void ConcurrentFetchUnpin(ReplacerType replacer_type) {
+  const size_t buffer_pool_size = 16;
+  const int num_pages = 40;
+  const int num_threads = 8;
+  const int ops_per_thread = 5000;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), 2, nullptr, 0,
+                                                         replacer_type);
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: the working set is larger than the pool, so lock-free hits race with evictions of the very frames they
+  // pin. Every fetch must still return the page that was asked for, and no pin may leak.
+  std::atomic<int> mismatches{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      // Half of the accesses go to a few hot pages, which keeps the hit path busy.
+      std::uniform_int_distribution<int> hot(0, 3);
+      std::uniform_int_distribution<int> any(0, num_pages - 1);
+      for (int op = 0; op < ops_per_thread; op++) {
+        page_id_t page_id = page_ids[op % 2 == 0 ? hot(rng) : any(rng)];
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        if (page->GetPageId() != page_id ||
+            strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()) != 0) {
+          mismatches++;
+        }
+        bpm->UnpinPage(page_id, op % 7 == 0);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, mismatches);
+
+  // Every frame must be evictable again: the whole pool can be refilled with new pages.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ConcurrentFetchUnpinTest) { ConcurrentFetchUnpin(ReplacerType::LRU_K); }
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ConcurrentFetchUnpinClockTest) { ConcurrentFetchUnpin(ReplacerType::CLOCK); }
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, AsyncDiskManagerTest) {
+  const std::string db_name = "test_async.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 64;
+  const int num_threads = 4;
+  auto disk_manager = std::make_unique<DiskManagerUring>(db_name);
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), 2);
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: misses that evict dirty pages write the victim back while they load the new page. Every page must come
+  // back with the content it had when it was evicted, including the updates made in this loop.
+  std::atomic<int> mismatches{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = t; i < num_pages; i += num_threads) {
+        auto *page = bpm->FetchPage(page_ids[i]);
+        if (page == nullptr) {
+          continue;
+        }
+        if (strcmp(page->GetData(), ("page " + std::to_string(page_ids[i])).c_str()) != 0) {
+          mismatches++;
+        }
+        snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "updated %d", page_ids[i]);
+        bpm->UnpinPage(page_ids[i], true);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, mismatches);
+
+  // Scenario: flushing the pool writes the dirty pages and syncs the file.
+  bpm->FlushAllPages();
+  EXPECT_EQ(1, disk_manager->GetNumSyncs());
+  char buf[BUSTUB_PAGE_SIZE];
+  for (int i = 0; i < num_pages; i++) {
+    disk_manager->ReadPage(page_ids[i], buf);
+    EXPECT_EQ(0, strcmp(buf, ("updated " + std::to_string(page_ids[i])).c_str()));
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("test_async.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PageReuseTest) {
+  const std::string db_name = "test_reuse.db";
+  const size_t buffer_pool_size = 4;
+  remove(db_name.c_str());
+  remove("test_reuse.fsm");
+  auto disk_manager = std::make_unique<DiskManager>(db_name);
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, 2, 1, disk_manager.get(), 2);
+
+  // Instance 1 out of 2 owns the odd page ids.
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 8; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  EXPECT_EQ(15, page_ids.back());
+
+  // Scenario: deleted pages, resident or not, are handed out again before the file grows, lowest first.
+  EXPECT_TRUE(bpm->DeletePage(page_ids[5]));
+  EXPECT_TRUE(bpm->DeletePage(page_ids[1]));
+  EXPECT_EQ(2, disk_manager->GetNumFreePages());
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(page_ids[1], page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  EXPECT_TRUE(bpm->DeletePage(page_ids[3]));
+
+  // Scenario: after a restart, the free pages and the end of the allocated pages are remembered.
+  bpm->FlushAllPages();
+  bpm.reset();
+  disk_manager->ShutDown();
+  disk_manager = std::make_unique<DiskManager>(db_name);
+  EXPECT_EQ(16, disk_manager->GetNumPages());
+  EXPECT_EQ(2, disk_manager->GetNumFreePages());
+  bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, 2, 1, disk_manager.get(), 2);
+  for (page_id_t expected : {page_ids[3], page_ids[5], 17, 19}) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(expected, page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: a reader that still held the id of a deleted page fetches it back. The page is not handed out while the
+  // reader pins it, and its stale frame is dropped rather than mapped next to the new page once it is reused.
+  const page_id_t deleted = page_ids[7];
+  EXPECT_TRUE(bpm->DeletePage(deleted));
+  auto *stale = bpm->FetchPage(deleted);
+  ASSERT_NE(nullptr, stale);
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(21, page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  snprintf(stale->GetData(), BUSTUB_PAGE_SIZE, "stale");
+  EXPECT_TRUE(bpm->UnpinPage(deleted, true));
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(deleted, page_id);
+  snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "new");
+  EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  ASSERT_TRUE(bpm->FlushPage(page_id));
+  auto *fetched = bpm->FetchPage(page_id);
+  EXPECT_EQ(page, fetched);
+  EXPECT_STREQ("new", fetched->GetData());
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+
+  // Scenario: reused pages are reserved in batches, so the free space map is saved once for all of them, and the
+  // database file is not synced at all.
+  std::vector<page_id_t> batch;
+  for (int i = 0; i < 10; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    batch.push_back(page_id);
+  }
+  for (auto batch_page_id : batch) {
+    EXPECT_TRUE(bpm->DeletePage(batch_page_id));
+  }
+  const size_t num_saves = disk_manager->GetNumFreeSpaceMapSaves();
+  const int num_syncs = disk_manager->GetNumSyncs();
+  for (auto batch_page_id : batch) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(batch_page_id, page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(num_saves + 1, disk_manager->GetNumFreeSpaceMapSaves());
+  EXPECT_EQ(num_syncs, disk_manager->GetNumSyncs());
+
+  // Scenario: a page reused since the last sync is not free any more after a crash.
+  EXPECT_TRUE(bpm->DeletePage(page_ids[6]));
+  bpm->FlushAllPages();
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(page_ids[6], page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  bpm.reset();
+  auto restarted = std::make_unique<DiskManager>(db_name);
+  EXPECT_EQ(0, restarted->GetNumFreePages());
+  restarted->ShutDown();
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("test_reuse.log");
+  remove("test_reuse.fsm");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, StatsTest) {
+  const size_t buffer_pool_size = 3;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), 2);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: with every frame pinned, a new page cannot be created.
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.Get(BufferPoolCounter::PIN_FAILURE));
+  EXPECT_EQ(0, stats.Get(BufferPoolCounter::FETCH));
+
+  // Scenario: fetching resident pages counts hits.
+  for (auto id : page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(id));
+    EXPECT_TRUE(bpm->UnpinPage(id, false));
+    EXPECT_TRUE(bpm->UnpinPage(id, true));
+  }
+  stats = bpm->GetStats();
+  EXPECT_EQ(3, stats.Get(BufferPoolCounter::FETCH));
+  EXPECT_EQ(3, stats.Get(BufferPoolCounter::HIT));
+  EXPECT_EQ(0, stats.Get(BufferPoolCounter::MISS));
+  EXPECT_GT(stats.LatencyPercentile(BufferPoolLatency::HIT, 50), 0);
+
+  // Scenario: a new page evicts a dirty page, and fetching that page again is a miss. It evicts the new page, which
+  // has the fewest accesses and is clean.
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[0]));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], false));
+  stats = bpm->GetStats();
+  EXPECT_EQ(4, stats.Get(BufferPoolCounter::FETCH));
+  EXPECT_EQ(1, stats.Get(BufferPoolCounter::MISS));
+  EXPECT_EQ(2, stats.Get(BufferPoolCounter::EVICTION));
+  EXPECT_EQ(1, stats.Get(BufferPoolCounter::DIRTY_WRITE_BACK));
+  EXPECT_EQ(1, bpm->GetEvictedDirtyPageCount());
+  EXPECT_GT(stats.LatencyPercentile(BufferPoolLatency::MISS, 50), 0);
+  EXPECT_DOUBLE_EQ(0.75, stats.HitRatio());
+
+  bpm->ResetStats();
+  EXPECT_EQ(0, bpm->GetStats().Get(BufferPoolCounter::FETCH));
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FetchPageOptimisticTest) {
+  const size_t buffer_pool_size = 1;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), 2);
+
+  page_id_t page_id0;
+  Page *page0 = bpm->NewPage(&page_id0);
+  ASSERT_NE(nullptr, page0);
+  snprintf(page0->GetData(), BUSTUB_PAGE_SIZE, "Hello");
+  EXPECT_TRUE(bpm->UnpinPage(page_id0, true));
+
+  // Scenario: a resident page can be read without pinning it.
+  uint64_t version;
+  Page *page = bpm->FetchPageOptimistic(page_id0, &version);
+  ASSERT_EQ(page0, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "Hello"));
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_TRUE(page->ValidateOptimisticRead(version));
+
+  // Scenario: a write latch fails the read in progress, and blocks new ones.
+  page->WLatch();
+  EXPECT_EQ(nullptr, bpm->FetchPageOptimistic(page_id0, &version));
+  page->WUnlatch();
+  uint64_t old_version = version;
+  ASSERT_NE(nullptr, bpm->FetchPageOptimistic(page_id0, &version));
+  EXPECT_NE(old_version, version);
+
+  // Scenario: once the frame is given to another page, the read does not validate and the old page is not found.
+  page_id_t page_id1;
+  Page *page1 = bpm->NewPage(&page_id1);
+  ASSERT_EQ(page0, page1);
+  EXPECT_FALSE(page->ValidateOptimisticRead(version));
+  EXPECT_EQ(nullptr, bpm->FetchPageOptimistic(page_id0, &version));
+  EXPECT_TRUE(bpm->UnpinPage(page_id1, false));
+
+  // Scenario: deleting the page invalidates the frame too.
+  ASSERT_NE(nullptr, bpm->FetchPageOptimistic(page_id1, &version));
+  EXPECT_TRUE(bpm->DeletePage(page_id1));
+  EXPECT_FALSE(page->ValidateOptimisticRead(version));
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ResizeTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(2, disk_manager.get(), 2, nullptr, 4);
+  EXPECT_EQ(2, bpm->GetPoolSize());
+  EXPECT_EQ(4, bpm->GetMaxPoolSize());
+  EXPECT_FALSE(bpm->Resize(0));
+  EXPECT_FALSE(bpm->Resize(5));
+
+  // Scenario: growing the pool makes room for more pinned pages.
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 2; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+  }
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  ASSERT_TRUE(bpm->Resize(4));
+  EXPECT_EQ(4, bpm->GetPoolSize());
+  for (int i = 0; i < 2; i++) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+
+  // Scenario: the pool refuses to shrink while a page it would drop is pinned, and stays usable.
+  EXPECT_FALSE(bpm->Resize(2));
+  EXPECT_EQ(4, bpm->GetPoolSize());
+  for (auto id : page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(id, true));
+  }
+
+  // Scenario: once they are unpinned, the dropped pages are written back and can be fetched again.
+  ASSERT_TRUE(bpm->Resize(1));
+  EXPECT_EQ(1, bpm->GetPoolSize());
+  for (auto id : page_ids) {
+    Page *page = bpm->FetchPage(id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(id), std::string(page->GetData()));
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(id, false));
+  }
+
+  // Scenario: frames that were retired come back empty.
+  ASSERT_TRUE(bpm->Resize(4));
+  for (int i = 0; i < 3; i++) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, page->GetData()[0]);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, AdmissionFilterTest) {
+  const size_t buffer_pool_size = 3;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), 2);
+  bpm->EnableAdmissionFilter(1);
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 8; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: pages fetched over and over are admitted in place of pages nobody fetched.
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 3; i++) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i]));
+      EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    }
+  }
+  EXPECT_EQ(0, bpm->GetStats().Get(BufferPoolCounter::ADMISSION_REJECTION));
+
+  // Scenario: pages fetched once are turned away. The first one takes the frame of the admission window, and the
+  // others recycle that frame instead of evicting the hot pages.
+  bpm->ResetStats();
+  for (int i = 3; i < 8; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i]));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(5, stats.Get(BufferPoolCounter::ADMISSION_REJECTION));
+  EXPECT_EQ(5, stats.Get(BufferPoolCounter::EVICTION));
+  for (int i = 0; i < 3; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i]));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  EXPECT_EQ(2, bpm->GetStats().Get(BufferPoolCounter::HIT));
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DISABLED_AdmissionFilterBenchmark) {
+  const size_t buffer_pool_size = 500;
+  const size_t num_hot_pages = 5000;
+  const size_t num_pages = 20000;
+  const size_t trace_length = 500000;
+  // The skews of the Zipf_* distributions of TableGenerator.
+  const std::vector<std::pair<std::string, double>> skews = {
+      {"Zipf_50", 0.5}, {"Zipf_75", 0.75}, {"Zipf_95", 0.95}, {"Zipf_99", 0.99}};
+
+  std::cout << "<<< BEGIN" << std::endl;
+  std::cout << "trace\tk\tfilter\thit_ratio\trejections" << std::endl;
+  for (const auto &[name, theta] : skews) {
+    // Skewed point accesses to a set of pages larger than the pool, one in five replaced by a probe into a random
+    // cold page, which is seldom accessed again.
+    ZipfianGenerator zipf(num_hot_pages, theta, 15445);
+    std::mt19937 rng(15445);
+    std::uniform_int_distribution<page_id_t> cold(num_hot_pages, num_pages - 1);
+    std::vector<page_id_t> trace;
+    for (size_t i = 0; i < trace_length; i++) {
+      trace.push_back(i % 5 == 0 ? cold(rng) : zipf.Next());
+    }
+
+    for (size_t k : {static_cast<size_t>(2), static_cast<size_t>(LRUK_REPLACER_K)}) {
+      for (bool filter : {false, true}) {
+        auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+        auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), k);
+        if (filter) {
+          bpm->EnableAdmissionFilter();
+        }
+        for (size_t i = 0; i < num_pages; i++) {
+          page_id_t page_id;
+          ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+          bpm->UnpinPage(page_id, true);
+        }
+        bpm->ResetStats();
+        for (auto page_id : trace) {
+          ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+          bpm->UnpinPage(page_id, false);
+        }
+        auto stats = bpm->GetStats();
+        std::cout << name << "\t" << k << "\t" << (filter ? "tinylfu" : "none") << "\t" << stats.HitRatio() << "\t"
+                  << stats.Get(BufferPoolCounter::ADMISSION_REJECTION) << std::endl;
+      }
+    }
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FrameArenaTest) {
+  const size_t buffer_pool_size = 2 * HUGE_PAGE_SIZE / BUSTUB_PAGE_SIZE;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), 2);
+
+  // Scenario: the metadata of every frame starts a cache line, and its data is page-aligned, so it can be handed to
+  // direct I/O. An arena of several huge pages starts a huge page.
+  Page *pages = bpm->GetPages();
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(pages[0].GetData()) % (BUFFER_POOL_HUGE_PAGES ? HUGE_PAGE_SIZE : 1));
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(pages + i) % CACHE_LINE_SIZE);
+    EXPECT_EQ(pages[0].GetData() + i * BUSTUB_PAGE_SIZE, pages[i].GetData());
+  }
+
+  // Scenario: the frames can be used end to end.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    page->GetData()[BUSTUB_PAGE_SIZE - 1] = 1;
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+}
+
+/** @return how much anonymous memory of this process is backed by transparent huge pages, in kB */
+auto AnonHugePagesKb() -> size_t {
+  std::ifstream smaps("/proc/self/smaps_rollup");
+  std::string line;
+  while (std::getline(smaps, line)) {
+    if (line.rfind("AnonHugePages:", 0) == 0) {
+      return std::stoul(line.substr(line.find(':') + 1));
+    }
+  }
+  return 0;
+}
+
+/** Read the page id, pin count and one word of data of the pages, in order, a few times. @return ns per page */
+auto ScanPages(const std::vector<Page *> &pages) -> double {
+  const int rounds = 20;
+  uint64_t sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    for (size_t i = 0; i < pages.size(); i++) {
+      Page *page = pages[i];
+      sum += page->GetPageId() + page->GetPinCount();
+      sum += static_cast<unsigned char>(page->GetData()[(i * CACHE_LINE_SIZE) % BUSTUB_PAGE_SIZE]);
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_NE(static_cast<uint64_t>(-1), sum);
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  return static_cast<double>(ns) / (rounds * pages.size());
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DISABLED_ScanBenchmark) {
+  std::cout << "<<< BEGIN" << std::endl;
+  std::cout << "frames	layout	order	ns/page	anon_huge_kb" << std::endl;
+  for (size_t num_frames : {1024, 16384}) {
+    // The layout before the arena: every page with its own heap allocation next to its metadata.
+    auto heap_pages = std::make_unique<Page[]>(num_frames);
+    auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+    auto bpm = std::make_unique<BufferPoolManagerInstance>(num_frames, disk_manager.get());
+    for (size_t i = 0; i < num_frames; i++) {
+      page_id_t page_id;
+      Page *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      memset(page->GetData(), 1, BUSTUB_PAGE_SIZE);
+      bpm->UnpinPage(page_id, true);
+    }
+
+    std::vector<Page *> heap_order;
+    std::vector<Page *> arena_order;
+    for (size_t i = 0; i < num_frames; i++) {
+      heap_order.push_back(&heap_pages[i]);
+      arena_order.push_back(bpm->GetPages() + i);
+    }
+    for (bool random : {false, true}) {
+      const char *order = random ? "random" : "sequential";
+      if (random) {
+        std::shuffle(heap_order.begin(), heap_order.end(), std::mt19937(15445));
+        std::shuffle(arena_order.begin(), arena_order.end(), std::mt19937(15445));
+      }
+      std::cout << num_frames << "\theap\t" << order << "\t" << ScanPages(heap_order) << "\t" << AnonHugePagesKb()
+                << std::endl;
+      std::cout << num_frames << "\tarena\t" << order << "\t" << ScanPages(arena_order) << "\t" << AnonHugePagesKb()
+                << std::endl;
+    }
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+/** A disk manager that counts the vectored writes of runs of pages. */
+class RunCountingDiskManager : public DiskManager {
+ public:
+  explicit RunCountingDiskManager(const std::string &db_file) : DiskManager(db_file) {}
+
+  void WritePages(page_id_t start_page_id, const std::vector<const char *> &pages) override {
+    runs_.emplace_back(start_page_id, pages.size());
+    DiskManager::WritePages(start_page_id, pages);
+  }
+
+  std::vector<std::pair<page_id_t, size_t>> runs_;
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FlushAllPagesTest) {
+  const std::string db_name = "test_flush_all.db";
+  const size_t buffer_pool_size = 16;
+  remove(db_name.c_str());
+  auto disk_manager = std::make_unique<RunCountingDiskManager>(db_name);
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), 2);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+  }
+  // Pages 0-4 and 8-9 are dirty, the others are clean. Page 3 stays pinned, which does not keep it from being flushed.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    bool dirty = i < 5 || i == 8 || i == 9;
+    if (i != 3) {
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i], dirty));
+    }
+  }
+  bpm->FetchPage(page_ids[3])->SetLSN(0);
+  ASSERT_TRUE(bpm->UnpinPage(page_ids[3], true));
+
+  // Scenario: only the dirty pages are written, one vectored write per run of adjacent pages.
+  bpm->FlushAllPages();
+  std::vector<std::pair<page_id_t, size_t>> expected_runs = {{0, 5}, {8, 2}};
+  EXPECT_EQ(expected_runs, disk_manager->runs_);
+  EXPECT_EQ(7, disk_manager->GetNumWrites());
+  EXPECT_EQ(1, disk_manager->GetNumSyncs());
+  char buf[BUSTUB_PAGE_SIZE];
+  for (page_id_t page_id : {0, 1, 4, 8, 9}) {
+    disk_manager->ReadPage(page_id, buf);
+    EXPECT_EQ(0, strcmp(buf, ("page " + std::to_string(page_id)).c_str()));
+  }
+
+  // Scenario: flushed pages are clean and unpinned again, so a second flush writes nothing and every frame can be
+  // evicted.
+  disk_manager->runs_.clear();
+  bpm->FlushAllPages();
+  EXPECT_TRUE(disk_manager->runs_.empty());
+  ASSERT_TRUE(bpm->UnpinPage(page_ids[3], false));
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+
+  bpm.reset();
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("test_flush_all.log");
+}
+
 }  // namespace bustub
@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats_test.cpp
+//
+// Identification: test/buffer/buffer_pool_stats_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_stats.h"
+
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(BufferPoolStatsTest, ShardedCounterTest) {
+  const int num_threads = 8;
+  const int num_adds = 10000;
+  BufferPoolStats stats;
+
+  // Scenario: increments from many threads land in different shards, and the snapshot adds all of them up.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&stats] {
+      for (int i = 0; i < num_adds; i++) {
+        stats.Add(BufferPoolCounter::FETCH);
+        stats.Add(i % 4 == 0 ? BufferPoolCounter::MISS : BufferPoolCounter::HIT);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto snapshot = stats.Snapshot();
+  EXPECT_EQ(num_threads * num_adds, snapshot.Get(BufferPoolCounter::FETCH));
+  EXPECT_EQ(num_threads * num_adds / 4, snapshot.Get(BufferPoolCounter::MISS));
+  EXPECT_DOUBLE_EQ(0.75, snapshot.HitRatio());
+
+  // Scenario: snapshots add up, and a reset clears everything.
+  snapshot += stats.Snapshot();
+  EXPECT_EQ(2 * num_threads * num_adds, snapshot.Get(BufferPoolCounter::FETCH));
+  stats.Reset();
+  EXPECT_EQ(0, stats.Snapshot().Get(BufferPoolCounter::FETCH));
+  EXPECT_DOUBLE_EQ(0, stats.Snapshot().HitRatio());
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolStatsTest, LatencyHistogramTest) {
+  BufferPoolStats stats;
+  EXPECT_EQ(0, stats.Snapshot().LatencyPercentile(BufferPoolLatency::HIT, 50));
+
+  // 90 fast hits around 100ns and 10 slow ones around 1ms.
+  for (int i = 0; i < 90; i++) {
+    stats.RecordLatency(BufferPoolLatency::HIT, std::chrono::nanoseconds(100));
+  }
+  for (int i = 0; i < 10; i++) {
+    stats.RecordLatency(BufferPoolLatency::HIT, std::chrono::microseconds(1000));
+  }
+  auto snapshot = stats.Snapshot();
+  // Percentiles are the upper bound of their power-of-two bucket.
+  EXPECT_EQ(127, snapshot.LatencyPercentile(BufferPoolLatency::HIT, 50));
+  EXPECT_EQ(127, snapshot.LatencyPercentile(BufferPoolLatency::HIT, 90));
+  EXPECT_EQ(1048575, snapshot.LatencyPercentile(BufferPoolLatency::HIT, 99));
+  EXPECT_EQ(0, snapshot.LatencyPercentile(BufferPoolLatency::MISS, 99));
+}
+
+}  // namespace bustub
@@ -0,0 +1,208 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_warmer_test.cpp
+//
+// Identification: test/buffer/buffer_pool_warmer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_warmer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+namespace {
+
+const char *const DB_NAME = "test_warmer.db";
+const char *const WARM_UP_NAME = "test_warmer.warm";
+
+void RemoveFiles() {
+  remove(DB_NAME);
+  remove("test_warmer.log");
+  remove("test_warmer.fsm");
+  remove(WARM_UP_NAME);
+}
+
+/** Create a database file with num_pages pages, each holding its own id. */
+void CreateDatabase(size_t num_pages) {
+  DiskManager disk_manager(DB_NAME);
+  BufferPoolManagerInstance bpm(16, &disk_manager, 2);
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm.NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<page_id_t *>(page->GetData()) = page_id;
+    bpm.UnpinPage(page_id, true);
+  }
+  bpm.FlushAllPages();
+  disk_manager.ShutDown();
+}
+
+/** Fetch and unpin a page, checking its content. */
+void Touch(BufferPoolManager *bpm, page_id_t page_id) {
+  Page *page = bpm->FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  ASSERT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+  bpm->UnpinPage(page_id, false);
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(BufferPoolWarmerTest, SaveLoadTest) {
+  RemoveFiles();
+  CreateDatabase(20);
+  DiskManager disk_manager(DB_NAME);
+  BufferPoolManagerInstance bpm(5, &disk_manager, 2);
+
+  // Pages 3 and 7 are accessed twice, 7 last; pages 9, 11 and 15 once, in that order.
+  for (page_id_t page_id : {3, 9, 3, 11, 7, 15, 7}) {
+    Touch(&bpm, page_id);
+  }
+
+  // Scenario: the saved list is in the reverse of the eviction order.
+  ASSERT_TRUE(BufferPoolWarmer::SaveHotPages(&bpm, WARM_UP_NAME));
+  EXPECT_EQ((std::vector<page_id_t>{7, 3, 15, 11, 9}), BufferPoolWarmer::LoadHotPages(WARM_UP_NAME, 20));
+
+  // Scenario: pages past the end of the database file are dropped.
+  EXPECT_EQ((std::vector<page_id_t>{7, 3, 9}), BufferPoolWarmer::LoadHotPages(WARM_UP_NAME, 10));
+
+  // Scenario: a missing or corrupt file gives an empty list.
+  EXPECT_TRUE(BufferPoolWarmer::LoadHotPages("does_not_exist.warm", 20).empty());
+  FILE *file = fopen(WARM_UP_NAME, "w");
+  fputs("garbage", file);
+  fclose(file);
+  EXPECT_TRUE(BufferPoolWarmer::LoadHotPages(WARM_UP_NAME, 20).empty());
+
+  disk_manager.ShutDown();
+  RemoveFiles();
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolWarmerTest, WarmUpTest) {
+  RemoveFiles();
+  CreateDatabase(20);
+  std::vector<page_id_t> hot_pages{12, 4, 17, 0, 8, 1};
+
+  {
+    DiskManager disk_manager(DB_NAME);
+    BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+    for (page_id_t page_id : hot_pages) {
+      Touch(&bpm, page_id);
+    }
+    ASSERT_TRUE(BufferPoolWarmer::SaveHotPages(&bpm, WARM_UP_NAME));
+    disk_manager.ShutDown();
+  }
+
+  // Scenario: after a restart, the pages that were resident are prefetched without pinning them, and the first
+  // fetches of them are hits.
+  DiskManager disk_manager(DB_NAME);
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  auto loaded = BufferPoolWarmer::LoadHotPages(WARM_UP_NAME, disk_manager.GetNumPages());
+  ASSERT_EQ((std::vector<page_id_t>{1, 8, 0, 17}), loaded);
+  BufferPoolWarmer warmer(&bpm, loaded);
+  warmer.Wait();
+  EXPECT_EQ(4, warmer.GetNumPrefetched());
+
+  bpm.ResetStats();
+  for (page_id_t page_id : loaded) {
+    Touch(&bpm, page_id);
+  }
+  EXPECT_EQ(4, bpm.GetStats().Get(BufferPoolCounter::HIT));
+  EXPECT_EQ(0, bpm.GetStats().Get(BufferPoolCounter::MISS));
+
+  // Scenario: a list longer than the pool only prefetches what fits.
+  BufferPoolManagerInstance small_bpm(2, &disk_manager, 2);
+  BufferPoolWarmer small_warmer(&small_bpm, loaded);
+  small_warmer.Wait();
+  EXPECT_EQ(2, small_warmer.GetNumPrefetched());
+
+  disk_manager.ShutDown();
+  RemoveFiles();
+}
+
+/*
+ * Restart benchmark: a skewed workload runs against a pool that is much smaller than the database, the instance is
+ * restarted with the database file dropped from the OS page cache, and the first queries after the restart are timed
+ * with a cold pool and with a pool warmed up from the saved hot pages.
+ */
+// NOLINTNEXTLINE
+TEST(BufferPoolWarmerTest, DISABLED_RestartBenchmark) {
+  const size_t num_pages = 20000;
+  const size_t pool_size = 1000;
+  const size_t num_queries = 20000;
+  RemoveFiles();
+  CreateDatabase(num_pages);
+
+  // Most accesses go to a hot set that fits into the pool.
+  std::mt19937 gen(15445);
+  std::uniform_int_distribution<page_id_t> hot(0, static_cast<page_id_t>(pool_size) - 1);
+  std::uniform_int_distribution<page_id_t> any(0, static_cast<page_id_t>(num_pages) - 1);
+  std::vector<page_id_t> hot_set;
+  std::uniform_int_distribution<page_id_t> spread(0, static_cast<page_id_t>(num_pages / pool_size) - 1);
+  for (size_t i = 0; i < pool_size; i++) {
+    hot_set.push_back(static_cast<page_id_t>(i * (num_pages / pool_size)) + spread(gen));
+  }
+  std::vector<page_id_t> queries;
+  for (size_t i = 0; i < num_queries; i++) {
+    queries.push_back(i % 10 == 0 ? any(gen) : hot_set[hot(gen)]);
+  }
+
+  {
+    DiskManager disk_manager(DB_NAME);
+    BufferPoolManagerInstance bpm(pool_size, &disk_manager, 2);
+    for (page_id_t page_id : queries) {
+      Touch(&bpm, page_id);
+    }
+    ASSERT_TRUE(BufferPoolWarmer::SaveHotPages(&bpm, WARM_UP_NAME));
+    disk_manager.ShutDown();
+  }
+
+  auto drop_page_cache = [] {
+    int fd = open(DB_NAME, O_RDONLY);  // NOLINT
+    ASSERT_GE(fd, 0);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  };
+
+  for (bool warm_up : {false, true}) {
+    drop_page_cache();
+    DiskManager disk_manager(DB_NAME);
+    BufferPoolManagerInstance bpm(pool_size, &disk_manager, 2);
+    auto start = std::chrono::steady_clock::now();
+    if (warm_up) {
+      BufferPoolWarmer warmer(&bpm, BufferPoolWarmer::LoadHotPages(WARM_UP_NAME, num_pages));
+      warmer.Wait();
+    }
+    auto warmed = std::chrono::steady_clock::now();
+    bpm.ResetStats();
+    for (page_id_t page_id : queries) {
+      Touch(&bpm, page_id);
+    }
+    auto done = std::chrono::steady_clock::now();
+    auto stats = bpm.GetStats();
+    printf("%s: warm-up %ld ms, queries %ld ms, hit ratio %.3f, p99 fetch %lu ns\n", warm_up ? "warm" : "cold",
+           std::chrono::duration_cast<std::chrono::milliseconds>(warmed - start).count(),
+           std::chrono::duration_cast<std::chrono::milliseconds>(done - warmed).count(), stats.HitRatio(),
+           stats.LatencyPercentile(BufferPoolLatency::MISS, 99));
+    disk_manager.ShutDown();
+  }
+  RemoveFiles();
+}
+
+}  // namespace bustub
@@ -59,4 +59,34 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(ClockReplacerTest, SecondChanceTest) {
+  ClockReplacer clock_replacer(4);
+  int value;
+  ASSERT_FALSE(clock_replacer.Victim(&value));
+
+  // Scenario: every unpinned frame has its reference bit set, so the first sweep only clears them and the hand comes
+  // back around to frame 0.
+  clock_replacer.Unpin(0);
+  clock_replacer.Unpin(1);
+  clock_replacer.Unpin(2);
+  EXPECT_EQ(3, clock_replacer.Size());
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+
+  // Scenario: unpinning frame 1 again gives it a second chance, and the hand passes it over for frame 2.
+  clock_replacer.Unpin(1);
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  EXPECT_EQ(1, clock_replacer.Size());
+
+  // Scenario: a pinned frame is never a victim.
+  clock_replacer.Pin(1);
+  EXPECT_EQ(0, clock_replacer.Size());
+  ASSERT_FALSE(clock_replacer.Victim(&value));
+  clock_replacer.Unpin(3);
+  ASSERT_TRUE(clock_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
 }  // namespace bustub
@@ -0,0 +1,215 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// concurrent_clock_replacer_test.cpp
+//
+// Identification: test/buffer/concurrent_clock_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/concurrent_clock_replacer.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <set>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ConcurrentClockReplacerTest, SampleTest) {
+  ConcurrentClockReplacer replacer(7);
+  frame_id_t value;
+
+  // Scenario: frames become candidates once they are accessed and marked evictable.
+  for (frame_id_t frame = 1; frame <= 6; frame++) {
+    replacer.RecordAccess(frame);
+  }
+  for (frame_id_t frame = 1; frame <= 5; frame++) {
+    replacer.SetEvictable(frame, true);
+  }
+  replacer.SetEvictable(6, false);
+  ASSERT_EQ(5, replacer.Size());
+
+  // Scenario: every frame was referenced, so the first sweep only clears the bits and the second one evicts in hand
+  // order, skipping the pinned frame 6.
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(2, value);
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(3, value);
+  ASSERT_EQ(2, replacer.Size());
+
+  // Scenario: a hit gives frame 4 a second chance.
+  replacer.RecordAccess(4);
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(5, value);
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(4, value);
+  ASSERT_FALSE(replacer.Evict(&value));
+  ASSERT_EQ(0, replacer.Size());
+
+  // Scenario: unpinning frame 6 makes it the only candidate; removing it forgets it.
+  replacer.SetEvictable(6, true);
+  ASSERT_EQ(1, replacer.Size());
+  replacer.Remove(6);
+  ASSERT_EQ(0, replacer.Size());
+  ASSERT_FALSE(replacer.Evict(&value));
+
+  // Scenario: untracked frames are ignored.
+  replacer.SetEvictable(0, true);
+  replacer.Remove(0);
+  ASSERT_EQ(0, replacer.Size());
+}
+
+// NOLINTNEXTLINE
+TEST(ConcurrentClockReplacerTest, PeekVictimTest) {
+  ConcurrentClockReplacer replacer(3);
+  frame_id_t value;
+  ASSERT_FALSE(replacer.PeekVictim(&value));
+
+  replacer.RecordAccess(0);
+  replacer.RecordAccess(1);
+  replacer.SetEvictable(0, true);
+  replacer.SetEvictable(1, true);
+  // Both frames are referenced: the sweep clears both bits and comes back to frame 0.
+  ASSERT_TRUE(replacer.PeekVictim(&value));
+  ASSERT_EQ(0, value);
+  ASSERT_EQ(2, replacer.Size());
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+
+  // Frame 1 lost its reference bit in that sweep, and frame 2 is new.
+  replacer.RecordAccess(2);
+  replacer.SetEvictable(2, true);
+  ASSERT_TRUE(replacer.PeekVictim(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+}
+
+// NOLINTNEXTLINE
+TEST(ConcurrentClockReplacerTest, GetHotFramesTest) {
+  ConcurrentClockReplacer replacer(4);
+  frame_id_t value;
+  for (frame_id_t frame = 0; frame < 4; frame++) {
+    replacer.RecordAccess(frame);
+    replacer.SetEvictable(frame, true);
+  }
+  ASSERT_TRUE(replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+  // The sweep cleared every bit; frame 2 is hit again.
+  replacer.RecordAccess(2);
+
+  // Scenario: the referenced frame is the hottest, then the others from the last the hand reaches to the first.
+  std::vector<frame_id_t> expected{2, 3, 1};
+  ASSERT_EQ(expected, replacer.GetHotFrames());
+}
+
+// NOLINTNEXTLINE
+TEST(ConcurrentClockReplacerTest, ConcurrentTest) {
+  const size_t num_frames = 64;
+  const int num_threads = 8;
+  const int ops_per_thread = 20000;
+  ConcurrentClockReplacer replacer(num_frames);
+  // The even frames stay pinned, the odd ones are unpinned after every access.
+  auto is_pinned = [](frame_id_t frame) { return frame % 2 == 0; };
+  for (size_t frame = 0; frame < num_frames; frame++) {
+    replacer.RecordAccess(static_cast<frame_id_t>(frame));
+    replacer.SetEvictable(static_cast<frame_id_t>(frame), !is_pinned(static_cast<frame_id_t>(frame)));
+  }
+
+  // Scenario: hits on every frame race with an evictor, which must never get a pinned frame.
+  std::atomic<bool> done{false};
+  std::atomic<int> bad_evictions{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int op = 0; op < ops_per_thread; op++) {
+        auto frame = static_cast<frame_id_t>((t + op) % num_frames);
+        replacer.RecordAccess(frame);
+        if (!is_pinned(frame)) {
+          replacer.SetEvictable(frame, true);
+        }
+      }
+    });
+  }
+  std::thread evictor([&] {
+    frame_id_t frame;
+    while (!done) {
+      if (replacer.Evict(&frame) && is_pinned(frame)) {
+        bad_evictions++;
+      }
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  done = true;
+  evictor.join();
+  EXPECT_EQ(0, bad_evictions);
+
+  // Scenario: once the dust settles, the count agrees with what can actually be evicted.
+  size_t size = replacer.Size();
+  std::set<frame_id_t> rest;
+  frame_id_t frame;
+  while (replacer.Evict(&frame)) {
+    EXPECT_FALSE(is_pinned(frame));
+    EXPECT_TRUE(rest.insert(frame).second);
+  }
+  EXPECT_EQ(size, rest.size());
+  EXPECT_EQ(0, replacer.Size());
+}
+
+/** Time the buffer pool's hit path, pin and unpin of a resident frame, from several threads at once. */
+auto HitPathNanos(FrameReplacer *replacer, size_t num_frames, int num_threads) -> double {
+  const int ops_per_thread = 1000000;
+  for (size_t frame = 0; frame < num_frames; frame++) {
+    replacer->RecordAccess(static_cast<frame_id_t>(frame));
+    replacer->SetEvictable(static_cast<frame_id_t>(frame), true);
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int op = 0; op < ops_per_thread; op++) {
+        auto frame = static_cast<frame_id_t>((t + op * num_threads) % num_frames);
+        replacer->RecordAccess(frame);
+        replacer->SetEvictable(frame, false);
+        replacer->SetEvictable(frame, true);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  return static_cast<double>(ns) / ops_per_thread;
+}
+
+// NOLINTNEXTLINE
+TEST(ConcurrentClockReplacerTest, DISABLED_HitPathBenchmark) {
+  const size_t num_frames = 1024;
+  std::cout << "<<< BEGIN" << std::endl;
+  std::cout << "threads\tlru-k ns/access\tclock ns/access" << std::endl;
+  for (int threads : {1, 2, 4, 8, 16}) {
+    LRUKReplacer lru_k(num_frames, LRUK_REPLACER_K);
+    ConcurrentClockReplacer clock(num_frames);
+    std::cout << threads << "\t" << HitPathNanos(&lru_k, num_frames, threads) << "\t"
+              << HitPathNanos(&clock, num_frames, threads) << std::endl;
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+}  // namespace bustub
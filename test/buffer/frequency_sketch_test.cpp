@@ -0,0 +1,86 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frequency_sketch_test.cpp
+//
+// Identification: test/buffer/frequency_sketch_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frequency_sketch.h"
+
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FrequencySketchTest, EstimateTest) {
+  FrequencySketch sketch(1000);
+  EXPECT_EQ(0, sketch.Estimate(42));
+
+  // Scenario: an estimate is never below the actual count, and with few pages it is exact.
+  for (int i = 0; i < 5; i++) {
+    sketch.Increment(42);
+  }
+  sketch.Increment(7);
+  EXPECT_EQ(5, sketch.Estimate(42));
+  EXPECT_EQ(1, sketch.Estimate(7));
+  EXPECT_EQ(0, sketch.Estimate(43));
+
+  // Scenario: counters saturate.
+  for (int i = 0; i < 100; i++) {
+    sketch.Increment(42);
+  }
+  EXPECT_EQ(FrequencySketch::MAX_COUNT, sketch.Estimate(42));
+}
+
+// NOLINTNEXTLINE
+TEST(FrequencySketchTest, AgingTest) {
+  const size_t capacity = 16;
+  FrequencySketch sketch(capacity);
+  for (int i = 0; i < 12; i++) {
+    sketch.Increment(1);
+  }
+  EXPECT_EQ(12, sketch.Estimate(1));
+
+  // Scenario: once a sample of 10 * capacity accesses is complete, every count is halved.
+  for (size_t i = 12; i < 10 * capacity - 1; i++) {
+    sketch.Increment(2);
+  }
+  EXPECT_EQ(12, sketch.Estimate(1));
+  EXPECT_EQ(FrequencySketch::MAX_COUNT, sketch.Estimate(2));
+  sketch.Increment(2);
+  EXPECT_EQ(6, sketch.Estimate(1));
+  EXPECT_EQ(FrequencySketch::MAX_COUNT / 2, sketch.Estimate(2));
+  EXPECT_EQ(5 * capacity, sketch.GetSampleCount());
+}
+
+// NOLINTNEXTLINE
+TEST(FrequencySketchTest, ConcurrentIncrementTest) {
+  const int num_threads = 8;
+  FrequencySketch sketch(1 << 16);
+
+  // Scenario: concurrent increments of different pages do not get in each other's way.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&sketch, t] {
+      for (int i = 0; i < 3; i++) {
+        sketch.Increment(t);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < num_threads; t++) {
+    EXPECT_LE(3, sketch.Estimate(t));
+  }
+}
+
+}  // namespace bustub
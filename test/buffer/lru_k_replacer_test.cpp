@@ -5,14 +5,21 @@
 #include "buffer/lru_k_replacer.h"
 
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <iostream>
 #include <memory>
 #include <random>
 #include <set>
+#include <string>
 #include <thread>  // NOLINT
+#include <unordered_map>
 #include <vector>
 
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
 #include "gtest/gtest.h"
+#include "zipfian_generator.h"
 
 namespace bustub {
 
@@ -97,4 +104,207 @@ TEST(LRUKReplacerTest, DISABLED_SampleTest) {
   lru_replacer.Remove(1);
   ASSERT_EQ(0, lru_replacer.Size());
 }
+
+TEST(LRUKReplacerTest, GetHotFramesTest) {
+  LRUKReplacer lru_replacer(5, 2);
+
+  // Frames 0 and 2 have two accesses, 2 more recently than 0. Frames 1 and 3 have one, 3 more recently than 1.
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(3);
+  lru_replacer.SetEvictable(0, true);
+  lru_replacer.SetEvictable(3, true);
+
+  // Scenario: the frames come in the reverse of the eviction order, pinned or not. Frame 4 is not tracked.
+  ASSERT_EQ((std::vector<frame_id_t>{2, 0, 3, 1}), lru_replacer.GetHotFrames());
+
+  frame_id_t value;
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(3, value);
+  ASSERT_EQ((std::vector<frame_id_t>{2, 0, 1}), lru_replacer.GetHotFrames());
+}
+
+TEST(LRUKReplacerTest, PeekVictimTest) {
+  LRUKReplacer lru_replacer(3, 2);
+  frame_id_t value;
+  ASSERT_FALSE(lru_replacer.PeekVictim(&value));
+
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.SetEvictable(0, true);
+  lru_replacer.SetEvictable(1, true);
+
+  // Peeking does not evict: the victim stays the same until it is evicted for real.
+  ASSERT_TRUE(lru_replacer.PeekVictim(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_TRUE(lru_replacer.PeekVictim(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_EQ(2, lru_replacer.Size());
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_TRUE(lru_replacer.PeekVictim(&value));
+  ASSERT_EQ(0, value);
+}
+
+TEST(LRUKReplacerTest, EvictionOrderTest) {
+  LRUKReplacer lru_replacer(5, 2);
+  frame_id_t value;
+
+  // Frames 0 and 1 are accessed twice, 0 first. Frames 2 and 3 are accessed once, 2 first. Frame 4 stays pinned.
+  for (frame_id_t frame_id : {0, 1, 2, 0, 1, 3, 4}) {
+    lru_replacer.RecordAccess(frame_id);
+  }
+  for (frame_id_t frame_id : {0, 1, 2, 3}) {
+    lru_replacer.SetEvictable(frame_id, true);
+  }
+  ASSERT_EQ(4, lru_replacer.Size());
+
+  // Scenario: only evictable frames count, and setting the same state twice changes nothing.
+  lru_replacer.SetEvictable(4, true);
+  ASSERT_EQ(5, lru_replacer.Size());
+  lru_replacer.SetEvictable(4, false);
+  lru_replacer.SetEvictable(4, false);
+  ASSERT_EQ(4, lru_replacer.Size());
+
+  // Scenario: a frame with fewer than k accesses has an infinite k-distance and goes first; among those, the one
+  // accessed earliest.
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(2, value);
+  ASSERT_EQ(3, lru_replacer.Size());
+
+  // Scenario: a second access gives frame 3 a finite k-distance. Frame 2 comes back with a single access and is the
+  // next victim, although it was accessed last; removing it takes it out of the replacer without evicting it.
+  lru_replacer.RecordAccess(3);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.SetEvictable(2, true);
+  ASSERT_EQ(4, lru_replacer.Size());
+  ASSERT_TRUE(lru_replacer.PeekVictim(&value));
+  ASSERT_EQ(2, value);
+  lru_replacer.Remove(2);
+  ASSERT_EQ(3, lru_replacer.Size());
+  lru_replacer.Remove(2);
+  ASSERT_EQ(3, lru_replacer.Size());
+
+  // Scenario: the frames with k accesses go in the order of their k-th most recent access.
+  for (frame_id_t expected : {0, 1, 3}) {
+    ASSERT_TRUE(lru_replacer.Evict(&value));
+    ASSERT_EQ(expected, value);
+  }
+  ASSERT_EQ(0, lru_replacer.Size());
+  ASSERT_FALSE(lru_replacer.Evict(&value));
+}
+
+/** Drives an LRUKReplacer the way the buffer pool does: every access pins and then unpins the frame. */
+class LRUKPolicy {
+ public:
+  explicit LRUKPolicy(size_t num_frames) : replacer_(num_frames, 2) {}
+  void Access(frame_id_t frame_id) {
+    replacer_.RecordAccess(frame_id);
+    replacer_.SetEvictable(frame_id, true);
+  }
+  auto Victim(frame_id_t *frame_id) -> bool { return replacer_.Evict(frame_id); }
+
+ private:
+  LRUKReplacer replacer_;
+};
+
+/** Drives one of the Replacer implementations (LRU, clock) the way the buffer pool would. */
+template <typename ReplacerType>
+class ReplacerPolicy {
+ public:
+  explicit ReplacerPolicy(size_t num_frames) : replacer_(num_frames) {}
+  void Access(frame_id_t frame_id) {
+    replacer_.Pin(frame_id);
+    replacer_.Unpin(frame_id);
+  }
+  auto Victim(frame_id_t *frame_id) -> bool { return replacer_.Victim(frame_id); }
+
+ private:
+  ReplacerType replacer_;
+};
+
+struct ReplacerBenchmarkResult {
+  double hit_ratio_;
+  double ns_per_access_;
+};
+
+/** Replay a page access trace against a simulated pool of num_frames frames managed by the given policy. */
+template <typename Policy>
+auto ReplayTrace(const std::vector<page_id_t> &trace, size_t num_frames) -> ReplacerBenchmarkResult {
+  Policy policy(num_frames);
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::vector<page_id_t> frames(num_frames, INVALID_PAGE_ID);
+  size_t next_free = 0;
+  size_t hits = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto page_id : trace) {
+    auto iter = page_table.find(page_id);
+    if (iter != page_table.end()) {
+      hits++;
+      policy.Access(iter->second);
+      continue;
+    }
+    frame_id_t frame_id;
+    if (next_free < num_frames) {
+      frame_id = static_cast<frame_id_t>(next_free++);
+    } else {
+      EXPECT_TRUE(policy.Victim(&frame_id));
+      page_table.erase(frames[frame_id]);
+    }
+    frames[frame_id] = page_id;
+    page_table[page_id] = frame_id;
+    policy.Access(frame_id);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  return {static_cast<double>(hits) / trace.size(), static_cast<double>(ns) / trace.size()};
+}
+
+TEST(LRUKReplacerTest, DISABLED_ReplacerBenchmark) {
+  const size_t num_pages = 100000;
+  const size_t trace_length = 2000000;
+  const std::vector<size_t> pool_sizes = {1000, 10000};
+
+  std::unordered_map<std::string, std::vector<page_id_t>> traces;
+  // Repeated sequential scans over a table larger than the pool.
+  for (size_t i = 0; i < trace_length; i++) {
+    traces["scan"].push_back(static_cast<page_id_t>(i % (num_pages / 10)));
+  }
+  // Skewed point accesses.
+  ZipfianGenerator zipf(num_pages, 0.99, 15445);
+  for (size_t i = 0; i < trace_length; i++) {
+    traces["zipfian"].push_back(zipf.Next());
+  }
+  // Skewed point accesses interrupted by one-off sequential scans over cold pages.
+  page_id_t cold_page = num_pages;
+  for (size_t i = 0; i < trace_length; i++) {
+    if (i % 100000 < 20000) {
+      traces["zipfian+scan"].push_back(cold_page++);
+    } else {
+      traces["zipfian+scan"].push_back(zipf.Next());
+    }
+  }
+
+  std::cout << "<<< BEGIN" << std::endl;
+  std::cout << "trace\tframes\tpolicy\thit_ratio\tns/access" << std::endl;
+  for (const auto &name : {"scan", "zipfian", "zipfian+scan"}) {
+    const auto &trace = traces[name];
+    for (auto frames : pool_sizes) {
+      auto report = [&](const std::string &policy, const ReplacerBenchmarkResult &result) {
+        std::cout << name << "\t" << frames << "\t" << policy << "\t" << result.hit_ratio_ << "\t"
+                  << result.ns_per_access_ << std::endl;
+      };
+      report("lru-k(2)", ReplayTrace<LRUKPolicy>(trace, frames));
+      report("lru", ReplayTrace<ReplacerPolicy<LRUReplacer>>(trace, frames));
+      report("clock", ReplayTrace<ReplacerPolicy<ClockReplacer>>(trace, frames));
+    }
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
 }  // namespace bustub
@@ -59,4 +59,29 @@ TEST(LRUReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(LRUReplacerTest, VictimOrderTest) {
+  LRUReplacer lru_replacer(4);
+  int value;
+  ASSERT_FALSE(lru_replacer.Victim(&value));
+
+  // Scenario: pinning a frame takes it out of the replacer, unpinning it again puts it back as the most recent one.
+  lru_replacer.Unpin(1);
+  lru_replacer.Unpin(2);
+  lru_replacer.Unpin(3);
+  EXPECT_EQ(3, lru_replacer.Size());
+  lru_replacer.Pin(2);
+  EXPECT_EQ(2, lru_replacer.Size());
+  lru_replacer.Unpin(2);
+  lru_replacer.Unpin(3);
+  EXPECT_EQ(3, lru_replacer.Size());
+
+  // Scenario: victims come least recently unpinned first; unpinning a frame that is already in keeps its place.
+  for (int expected : {1, 3, 2}) {
+    ASSERT_TRUE(lru_replacer.Victim(&value));
+    EXPECT_EQ(expected, value);
+  }
+  EXPECT_EQ(0, lru_replacer.Size());
+  ASSERT_FALSE(lru_replacer.Victim(&value));
+}
+
 }  // namespace bustub
@@ -0,0 +1,114 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_access_trace_test.cpp
+//
+// Identification: test/buffer/page_access_trace_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_access_trace.h"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "common/exception.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+namespace {
+
+auto ReadTrace(const std::string &file_name) -> std::vector<PageAccessRecord> {
+  PageAccessTraceReader reader(file_name);
+  std::vector<PageAccessRecord> records;
+  PageAccessRecord record;
+  while (reader.Next(&record)) {
+    records.push_back(record);
+  }
+  return records;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(PageAccessTraceTest, RoundTripTest) {
+  const std::string file_name = "test_trace.bin";
+  const size_t num_records = PageAccessTraceWriter::BATCH_SIZE + 10;
+  {
+    PageAccessTraceWriter writer(file_name);
+    for (size_t i = 0; i < num_records; i++) {
+      writer.Record(static_cast<page_id_t>(i), i % 2 == 0 ? PageAccessType::PIN : PageAccessType::UNPIN, i % 3 == 0);
+    }
+    EXPECT_EQ(num_records, writer.GetNumRecords());
+  }
+
+  // Scenario: every record comes back, in order, with increasing timestamps.
+  auto records = ReadTrace(file_name);
+  ASSERT_EQ(num_records, records.size());
+  for (size_t i = 0; i < num_records; i++) {
+    EXPECT_EQ(static_cast<page_id_t>(i), records[i].page_id_);
+    EXPECT_EQ(i % 2 == 0 ? PageAccessType::PIN : PageAccessType::UNPIN, records[i].type_);
+    EXPECT_EQ(i % 3 == 0, records[i].is_dirty_);
+    if (i > 0) {
+      EXPECT_LE(records[i - 1].timestamp_, records[i].timestamp_);
+    }
+  }
+
+  // Scenario: the records take 12 bytes each.
+  std::ifstream in(file_name, std::ios::binary | std::ios::ate);
+  EXPECT_EQ(sizeof(PageAccessTraceHeader) + num_records * PageAccessTraceWriter::RECORD_SIZE,
+            static_cast<size_t>(in.tellg()));
+
+  // Scenario: a file that is not a trace is refused.
+  std::ofstream(file_name, std::ios::trunc) << "not a trace";
+  EXPECT_THROW(PageAccessTraceReader reader(file_name), Exception);
+  remove(file_name.c_str());
+}
+
+// NOLINTNEXTLINE
+TEST(PageAccessTraceTest, BufferPoolTraceTest) {
+  const std::string file_name = "test_bpm_trace.bin";
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(2, disk_manager.get(), 2);
+  auto writer = std::make_unique<PageAccessTraceWriter>(file_name);
+
+  page_id_t page_id0;
+  page_id_t page_id1;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id0));
+  bpm->SetAccessTrace(writer.get());
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id1));
+  EXPECT_TRUE(bpm->UnpinPage(page_id1, true));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_id1));
+  EXPECT_TRUE(bpm->UnpinPage(page_id1, false));
+  EXPECT_TRUE(bpm->UnpinPage(page_id0, false));
+  // Scenario: failed calls are not recorded.
+  EXPECT_FALSE(bpm->UnpinPage(page_id0, false));
+  bpm->SetAccessTrace(nullptr);
+  ASSERT_NE(nullptr, bpm->FetchPage(page_id0));
+  writer.reset();
+
+  // Scenario: only the pins and unpins while the trace was attached are recorded, new pages flagged dirty.
+  auto records = ReadTrace(file_name);
+  ASSERT_EQ(5, records.size());
+  EXPECT_EQ(page_id1, records[0].page_id_);
+  EXPECT_EQ(PageAccessType::PIN, records[0].type_);
+  EXPECT_TRUE(records[0].is_dirty_);
+  EXPECT_EQ(PageAccessType::UNPIN, records[1].type_);
+  EXPECT_TRUE(records[1].is_dirty_);
+  EXPECT_EQ(PageAccessType::PIN, records[2].type_);
+  EXPECT_FALSE(records[2].is_dirty_);
+  EXPECT_EQ(PageAccessType::UNPIN, records[3].type_);
+  EXPECT_EQ(page_id0, records[4].page_id_);
+  EXPECT_EQ(PageAccessType::UNPIN, records[4].type_);
+  remove(file_name.c_str());
+}
+
+}  // namespace bustub
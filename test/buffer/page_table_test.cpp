@@ -0,0 +1,126 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table_test.cpp
+//
+// Identification: test/buffer/page_table_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageTableTest, SampleTest) {
+  PageTable table(16);
+  EXPECT_GE(table.Capacity(), 32);
+
+  frame_id_t frame;
+  EXPECT_FALSE(table.Find(0, &frame));
+  for (int i = 0; i < 16; i++) {
+    table.Insert(i * 3, i);
+  }
+  EXPECT_EQ(16, table.Size());
+  for (int i = 0; i < 16; i++) {
+    ASSERT_TRUE(table.Find(i * 3, &frame));
+    EXPECT_EQ(i, frame);
+  }
+  EXPECT_FALSE(table.Find(1, &frame));
+
+  // Remapping a page takes removing its entry first.
+  EXPECT_TRUE(table.Remove(3));
+  table.Insert(3, 10);
+  EXPECT_EQ(16, table.Size());
+  ASSERT_TRUE(table.Find(3, &frame));
+  EXPECT_EQ(10, frame);
+
+  EXPECT_TRUE(table.Remove(3));
+  EXPECT_FALSE(table.Remove(3));
+  EXPECT_FALSE(table.Find(3, &frame));
+  EXPECT_EQ(15, table.Size());
+}
+
+// NOLINTNEXTLINE
+TEST(PageTableTest, ChurnTest) {
+  // Scenario: a pool that keeps replacing its pages leaves tombstones behind. The table has to clean them up and keep
+  // every resident page reachable.
+  const int num_frames = 8;
+  PageTable table(num_frames);
+  frame_id_t frame;
+  for (int page_id = 0; page_id < 10000; page_id++) {
+    frame_id_t victim = page_id % num_frames;
+    if (page_id >= num_frames) {
+      ASSERT_TRUE(table.Remove(page_id - num_frames));
+    }
+    table.Insert(page_id, victim);
+    ASSERT_EQ(std::min(page_id + 1, num_frames), table.Size());
+    for (int resident = std::max(0, page_id - num_frames + 1); resident <= page_id; resident++) {
+      ASSERT_TRUE(table.Find(resident, &frame));
+      ASSERT_EQ(resident % num_frames, frame);
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(PageTableTest, ConcurrentReadTest) {
+  // Scenario: lock-free readers run against a writer that keeps adding and removing pages. A reader may miss a page
+  // while the table cleans up its tombstones, but any page it finds must map to the frame it was inserted with.
+  const int num_frames = 64;
+  PageTable table(num_frames);
+  for (int i = 0; i < num_frames / 2; i++) {
+    table.Insert(i, i);
+  }
+
+  std::atomic<bool> done{false};
+  std::atomic<int> errors{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&] {
+      frame_id_t frame;
+      while (!done) {
+        for (int i = 0; i < num_frames / 2; i++) {
+          if (table.Find(i, &frame) && frame != i) {
+            errors++;
+          }
+        }
+        for (int i = 1000; i < 1000 + num_frames / 2; i++) {
+          if (table.Find(i, &frame) && frame != i - 1000 + num_frames / 2) {
+            errors++;
+          }
+        }
+      }
+    });
+  }
+  for (int round = 0; round < 2000; round++) {
+    for (int i = 1000; i < 1000 + num_frames / 2; i++) {
+      table.Insert(i, i - 1000 + num_frames / 2);
+    }
+    for (int i = 1000; i < 1000 + num_frames / 2; i++) {
+      table.Remove(i);
+    }
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(0, errors);
+
+  frame_id_t frame;
+  for (int i = 0; i < num_frames / 2; i++) {
+    ASSERT_TRUE(table.Find(i, &frame));
+    EXPECT_EQ(i, frame);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,207 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/parallel_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+  const size_t num_instances = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  EXPECT_EQ(buffer_pool_size * num_instances, bpm->GetPoolSize());
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+
+  // Scenario: The buffer pool is empty. We should be able to create a new page.
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, page_id_temp);
+
+  // Scenario: Once we have a page, we should be able to read and write content.
+  snprintf(page0->GetData(), BUSTUB_PAGE_SIZE, "Hello");
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+
+  // Scenario: We should be able to create new pages until we fill up the buffer pool. New pages are handed out
+  // round-robin, so the ids are consecutive.
+  for (size_t i = 1; i < buffer_pool_size * num_instances; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(static_cast<page_id_t>(i), page_id_temp);
+  }
+
+  // Scenario: Once the buffer pool is full, we should not be able to create any new pages.
+  for (size_t i = buffer_pool_size * num_instances; i < buffer_pool_size * num_instances * 2; ++i) {
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: After unpinning pages {0, 1, 2, 3, 4}, every instance has exactly one evictable frame. Creating
+  // new pages must find them no matter which instance the round-robin starts from.
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+    bpm->FlushPage(i);
+  }
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    bpm->UnpinPage(page_id_temp, false);
+  }
+
+  // Scenario: We should be able to fetch the data we wrote a while ago.
+  page0 = bpm->FetchPage(0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+  EXPECT_EQ(true, bpm->UnpinPage(0, true));
+
+  // Scenario: Once page 0 is pinned again, every frame of instance 0 is pinned. Page 25 maps to instance 0 too, so
+  // it cannot be brought back in even though the other instances still have evictable frames.
+  EXPECT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_EQ(nullptr, bpm->FetchPage(25));
+  EXPECT_NE(nullptr, bpm->FetchPage(26));
+
+  // Scenario: flushing the pool writes the dirty pages of every instance, then syncs the file once.
+  const int num_syncs = disk_manager->GetNumSyncs();
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_syncs + 1, disk_manager->GetNumSyncs());
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.fsm");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ResizeTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<ParallelBufferPoolManager>(2, 2, disk_manager.get(), LRUK_REPLACER_K, nullptr, 4);
+  EXPECT_EQ(4, bpm->GetPoolSize());
+  EXPECT_EQ(8, bpm->GetMaxPoolSize());
+
+  // Scenario: the frames are spread as evenly as possible over the instances.
+  ASSERT_TRUE(bpm->Resize(7));
+  EXPECT_EQ(7, bpm->GetPoolSize());
+  EXPECT_FALSE(bpm->Resize(1));
+  EXPECT_FALSE(bpm->Resize(9));
+
+  // Scenario: if one instance cannot shrink, the others go back to their old size.
+  page_id_t page_id;
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 7; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    page_ids.push_back(page_id);
+  }
+  EXPECT_FALSE(bpm->Resize(2));
+  EXPECT_EQ(7, bpm->GetPoolSize());
+  for (auto id : page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(id, false));
+  }
+  ASSERT_TRUE(bpm->Resize(2));
+  EXPECT_EQ(2, bpm->GetPoolSize());
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, PinFailureTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<ParallelBufferPoolManager>(2, 2, disk_manager.get());
+  page_id_t page_id;
+  for (int i = 0; i < 4; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+
+  // Scenario: the next new page starts at instance 0, which is full, and goes to instance 1 instead. That is not a
+  // pin failure; only a new page that no instance has room for is.
+  ASSERT_TRUE(bpm->UnpinPage(1, false));
+  bpm->ResetStats();
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(0, bpm->GetStats().Get(BufferPoolCounter::PIN_FAILURE));
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(1, bpm->GetStats().Get(BufferPoolCounter::PIN_FAILURE));
+}
+
+/**
+ * Hammer the buffer pool with FetchPage/UnpinPage pairs on a resident working set from several threads and return
+ * the number of operations per second.
+ */
+auto BufferPoolContentionBenchmarkCall(BufferPoolManager *bpm, size_t num_threads, size_t num_pages,
+                                       size_t ops_per_thread) -> double {
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, true);
+    page_ids.push_back(page_id);
+  }
+
+  std::vector<std::thread> threads;
+  auto clock_start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_threads; i++) {
+    threads.emplace_back([bpm, &page_ids, i, ops_per_thread]() {
+      std::mt19937 rng(i);
+      std::uniform_int_distribution<size_t> dist(0, page_ids.size() - 1);
+      for (size_t op = 0; op < ops_per_thread; op++) {
+        page_id_t page_id = page_ids[dist(rng)];
+        auto *page = bpm->FetchPage(page_id);
+        if (page != nullptr) {
+          bpm->UnpinPage(page_id, false);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto clock_end = std::chrono::steady_clock::now();
+  auto dur = std::chrono::duration_cast<std::chrono::microseconds>(clock_end - clock_start).count();
+  return static_cast<double>(num_threads * ops_per_thread) * 1000000 / std::max<int64_t>(dur, 1);
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, DISABLED_ContentionBenchmark) {
+  const size_t pool_size = 256;
+  const size_t num_pages = 128;
+  const size_t ops_per_thread = 200000;
+  const size_t num_instances = 16;
+
+  std::cout << "<<< BEGIN" << std::endl;
+  std::cout << "threads\tinstance(ops/s)\tparallel-" << num_instances << "(ops/s)" << std::endl;
+  for (size_t num_threads = 1; num_threads <= 32; num_threads *= 2) {
+    auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+    auto instance = std::make_unique<BufferPoolManagerInstance>(pool_size, disk_manager.get());
+    auto parallel = std::make_unique<ParallelBufferPoolManager>(num_instances, pool_size / num_instances,
+                                                                disk_manager.get());
+    double instance_ops = BufferPoolContentionBenchmarkCall(instance.get(), num_threads, num_pages, ops_per_thread);
+    double parallel_ops = BufferPoolContentionBenchmarkCall(parallel.get(), num_threads, num_pages, ops_per_thread);
+    std::cout << num_threads << "\t" << static_cast<int64_t>(instance_ops) << "\t"
+              << static_cast<int64_t>(parallel_ops) << std::endl;
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+}  // namespace bustub
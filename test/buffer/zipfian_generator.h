@@ -0,0 +1,48 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zipfian_generator.h
+//
+// Identification: test/buffer/zipfian_generator.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** Generates page ids in [0, n) following a zipfian distribution with the given skew. */
+class ZipfianGenerator {
+ public:
+  ZipfianGenerator(size_t n, double theta, uint32_t seed) : rng_(seed), cdf_(n) {
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+      sum += 1.0 / std::pow(static_cast<double>(i + 1), theta);
+      cdf_[i] = sum;
+    }
+    for (auto &c : cdf_) {
+      c /= sum;
+    }
+  }
+
+  auto Next() -> page_id_t {
+    double u = std::uniform_real_distribution<double>(0, 1)(rng_);
+    return static_cast<page_id_t>(std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin());
+  }
+
+ private:
+  std::mt19937 rng_;
+  std::vector<double> cdf_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,168 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hybrid_latch_test.cpp
+//
+// Identification: test/common/hybrid_latch_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/hybrid_latch.h"
+#include "common/rwlatch.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(HybridLatchTest, BasicTest) {
+  HybridLatch latch;
+  uint64_t version = 0;
+  ASSERT_TRUE(latch.TryOptimisticRead(&version));
+  EXPECT_TRUE(latch.Validate(version));
+
+  // Readers do not change the version.
+  latch.RLock();
+  EXPECT_TRUE(latch.Validate(version));
+  latch.RUnlock();
+
+  latch.WLock();
+  uint64_t locked_version = 0;
+  EXPECT_FALSE(latch.TryOptimisticRead(&locked_version));
+  EXPECT_FALSE(latch.TryRLock());
+  latch.WUnlock();
+  EXPECT_FALSE(latch.Validate(version));
+
+  ASSERT_TRUE(latch.TryOptimisticRead(&version));
+  latch.Invalidate();
+  EXPECT_FALSE(latch.Validate(version));
+  ASSERT_TRUE(latch.TryOptimisticRead(&version));
+  EXPECT_TRUE(latch.Validate(version));
+
+  ASSERT_TRUE(latch.TryRLock());
+  latch.RUnlock();
+}
+
+// NOLINTNEXTLINE
+TEST(HybridLatchTest, ConcurrentOptimisticReadTest) {
+  // Writers keep the two values equal under the write latch; a validated optimistic read must never see them differ.
+  HybridLatch latch;
+  std::atomic<int> first{0};
+  std::atomic<int> second{0};
+  std::atomic<bool> stop{false};
+  std::atomic<int> validated{0};
+
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 4; tid++) {
+    readers.emplace_back([&] {
+      while (!stop.load()) {
+        uint64_t version;
+        if (!latch.TryOptimisticRead(&version)) {
+          std::this_thread::yield();
+          continue;
+        }
+        int a = first.load(std::memory_order_relaxed);
+        int b = second.load(std::memory_order_relaxed);
+        if (latch.Validate(version)) {
+          EXPECT_EQ(a, b);
+          validated++;
+        }
+        std::this_thread::yield();
+      }
+    });
+  }
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 2; tid++) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 2000; i++) {
+        latch.WLock();
+        first.store(first.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::this_thread::yield();
+        second.store(second.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        latch.WUnlock();
+        std::this_thread::yield();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  stop = true;
+  for (auto &thread : readers) {
+    thread.join();
+  }
+  EXPECT_EQ(first.load(), 4000);
+  EXPECT_EQ(second.load(), 4000);
+  EXPECT_GT(validated.load(), 0);
+}
+
+namespace {
+
+/** Run `threads` threads doing `read` in a loop for a while, return the number of reads per second. */
+template <typename ReadFn>
+auto MeasureReads(int num_threads, ReadFn read) -> double {
+  constexpr auto DURATION = std::chrono::milliseconds(500);
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> total{0};
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&] {
+      uint64_t reads = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        read();
+        reads++;
+      }
+      total += reads;
+    });
+  }
+  std::this_thread::sleep_for(DURATION);
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return static_cast<double>(total.load()) / std::chrono::duration<double>(DURATION).count();
+}
+
+}  // namespace
+
+/*
+ * Read-mostly microbenchmark: every thread reads the same latch-protected value, the way every lookup reads the root
+ * of a B+ tree. Prints the throughput of a shared RLock against an optimistic read.
+ */
+// NOLINTNEXTLINE
+TEST(HybridLatchTest, DISABLED_ReadThroughputBenchmark) {
+  ReaderWriterLatch rwlatch;
+  HybridLatch hybrid_latch;
+  std::atomic<int> value{42};
+
+  for (int num_threads : {1, 2, 4, 8}) {
+    double locked = MeasureReads(num_threads, [&] {
+      rwlatch.RLock();
+      int v = value.load(std::memory_order_relaxed);
+      rwlatch.RUnlock();
+      ASSERT_EQ(v, 42);
+    });
+    double optimistic = MeasureReads(num_threads, [&] {
+      uint64_t version;
+      int v;
+      do {
+        while (!hybrid_latch.TryOptimisticRead(&version)) {
+        }
+        v = value.load(std::memory_order_relaxed);
+      } while (!hybrid_latch.Validate(version));
+      ASSERT_EQ(v, 42);
+    });
+    printf("%d threads: RLatch %.2f Mreads/s, optimistic %.2f Mreads/s\n", num_threads, locked / 1e6,
+           optimistic / 1e6);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,357 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_bulk_load_test.cpp
+//
+// Identification: test/storage/b_plus_tree_bulk_load_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/external_sorter.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using Sorter = ExternalSorter<GenericKey<8>, RID, GenericComparator<8>>;
+using Tree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+
+/** Shuffled keys 0, 2, 4, ... with a rid that tells the key apart. */
+auto ShuffledEvenKeys(int64_t num_keys) -> std::vector<int64_t> {
+  std::vector<int64_t> keys(num_keys);
+  for (int64_t i = 0; i < num_keys; i++) {
+    keys[i] = 2 * i;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  return keys;
+}
+
+void AddKey(Sorter *sorter, int64_t key, int32_t slot = 0) {
+  GenericKey<8> index_key;
+  index_key.SetFromInteger(key);
+  sorter->Add(index_key, RID(static_cast<int32_t>(key >> 32), static_cast<uint32_t>(key) + slot));
+}
+
+/** Count the leaves and the levels of the tree, by following the leftmost path and then the leaf chain. */
+void TreeShape(Tree *tree, BufferPoolManager *bpm, int *num_leaves, int *height) {
+  using InternalPage = BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
+  using LeafPage = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+  page_id_t page_id = tree->GetRootPageId();
+  *height = 1;
+  while (true) {
+    Page *page = bpm->FetchPage(page_id);
+    auto tree_page = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    bool leaf = tree_page->IsLeafPage();
+    page_id_t child_page_id = leaf ? INVALID_PAGE_ID : reinterpret_cast<InternalPage *>(tree_page)->ValueAt(0);
+    bpm->UnpinPage(page_id, false);
+    if (leaf) {
+      break;
+    }
+    page_id = child_page_id;
+    (*height)++;
+  }
+  *num_leaves = 0;
+  while (page_id != INVALID_PAGE_ID) {
+    Page *page = bpm->FetchPage(page_id);
+    page_id_t next_page_id = reinterpret_cast<LeafPage *>(page->GetData())->GetNextPageId();
+    bpm->UnpinPage(page_id, false);
+    page_id = next_page_id;
+    (*num_leaves)++;
+  }
+}
+
+/** Check that every node under page_id but the root is at least half full. */
+void CheckHalfFull(BufferPoolManager *bpm, page_id_t page_id, bool root = true) {
+  using InternalPage = BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
+  Page *page = bpm->FetchPage(page_id);
+  auto tree_page = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  if (!root) {
+    EXPECT_GE(tree_page->GetSize(), (tree_page->GetMaxSize() + 1) / 2) << "page " << page_id;
+  }
+  if (!tree_page->IsLeafPage()) {
+    auto internal_page = reinterpret_cast<InternalPage *>(tree_page);
+    for (int i = 0; i < internal_page->GetSize(); i++) {
+      CheckHalfFull(bpm, internal_page->ValueAt(i), false);
+    }
+  }
+  bpm->UnpinPage(page_id, false);
+}
+
+// NOLINTNEXTLINE
+TEST(ExternalSorterTest, SpillTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  const int64_t num_keys = 10000;
+  auto keys = ShuffledEvenKeys(num_keys);
+
+  // Scenario: runs of 16 entries are more than one merge pass can take, and every key is added twice; the copy added
+  // first must win.
+  Sorter sorter(comparator, 16 * sizeof(std::pair<GenericKey<8>, RID>));
+  for (auto key : keys) {
+    AddKey(&sorter, key);
+  }
+  for (auto key : keys) {
+    AddKey(&sorter, key, 1);
+  }
+  sorter.Sort();
+  ASSERT_GT(sorter.GetNumRuns(), Sorter::MERGE_FAN_IN);
+  ASSERT_EQ(num_keys, sorter.Size());
+
+  std::pair<GenericKey<8>, RID> entry;
+  int64_t expected = 0;
+  while (sorter.Next(&entry)) {
+    ASSERT_EQ(expected, entry.second.Get());
+    expected += 2;
+  }
+  ASSERT_EQ(2 * num_keys, expected);
+
+  // Scenario: without spilling, the output is the same.
+  Sorter in_memory(comparator);
+  for (auto key : keys) {
+    AddKey(&in_memory, key, 1);
+    AddKey(&in_memory, key);
+  }
+  in_memory.Sort();
+  ASSERT_EQ(0, in_memory.GetNumRuns());
+  ASSERT_EQ(num_keys, in_memory.Size());
+  expected = 0;
+  while (in_memory.Next(&entry)) {
+    ASSERT_EQ(expected + 1, entry.second.Get());
+    expected += 2;
+  }
+  ASSERT_EQ(2 * num_keys, expected);
+}
+
+void BulkLoadSmallNodes(BPlusTreeMode mode) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  Tree tree("foo_pk", bpm, comparator, 3, 4, mode);
+  const int64_t num_keys = 5000;
+  auto keys = ShuffledEvenKeys(num_keys);
+
+  // Scenario: the even keys are sorted with a few spilled runs and loaded into small pages.
+  Sorter sorter(comparator, 1000 * sizeof(std::pair<GenericKey<8>, RID>));
+  for (auto key : keys) {
+    AddKey(&sorter, key);
+  }
+  ASSERT_TRUE(tree.BulkLoad(&sorter));
+  ASSERT_GT(sorter.GetNumRuns(), 1);
+
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.GetValue(index_key, &rids));
+    ASSERT_EQ(key, rids[0].Get());
+  }
+  int64_t expected = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    ASSERT_EQ(expected, (*iterator).second.Get());
+    expected += 2;
+  }
+  ASSERT_EQ(2 * num_keys, expected);
+
+  // Scenario: a tree that is not empty is not loaded again.
+  Sorter again(comparator);
+  AddKey(&again, 1);
+  ASSERT_FALSE(tree.BulkLoad(&again));
+
+  // Scenario: the loaded tree takes inserts between its keys and removes of half of them.
+  for (auto key : keys) {
+    index_key.SetFromInteger(key + 1);
+    ASSERT_TRUE(tree.Insert(index_key, RID(0, static_cast<uint32_t>(key + 1))));
+  }
+  for (auto key : keys) {
+    if (key % 4 == 0) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key);
+    }
+  }
+  expected = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    while (expected % 4 == 0) {
+      expected++;
+    }
+    ASSERT_EQ(expected, (*iterator).second.Get());
+    expected++;
+  }
+  ASSERT_EQ(2 * num_keys, expected);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeBulkLoadTest, SmallNodesTest) { BulkLoadSmallNodes(BPlusTreeMode::LATCH_CRABBING); }
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeBulkLoadTest, BLinkSmallNodesTest) { BulkLoadSmallNodes(BPlusTreeMode::B_LINK); }
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeBulkLoadTest, FillFactorTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  int num_leaves;
+  int height;
+
+  // Scenario: 100 keys in leaves of 10 fill 10 full leaves, or 20 half full ones; nodes never get less than half full.
+  for (auto [fill_factor, expected_leaves] : std::vector<std::pair<double, int>>{{1.0, 10}, {0.5, 20}, {0.1, 20}}) {
+    Tree tree("foo_pk", bpm, comparator, 10, 10);
+    Sorter sorter(comparator);
+    for (int64_t key = 0; key < 100; key++) {
+      AddKey(&sorter, key);
+    }
+    ASSERT_TRUE(tree.BulkLoad(&sorter, fill_factor));
+    TreeShape(&tree, bpm, &num_leaves, &height);
+    ASSERT_EQ(expected_leaves, num_leaves);
+    ASSERT_EQ(fill_factor == 1.0 ? 2 : 3, height);
+  }
+
+  // Scenario: one key more than a node is meant to take. It goes into the same node if that has room, or the keys are
+  // split over two nodes that both stay at least half full.
+  for (auto [fill_factor, expected_leaves] : std::vector<std::pair<double, int>>{{0.5, 1}, {0.8, 1}, {1.0, 2}}) {
+    Tree tree("foo_pk", bpm, comparator, 10, 10);
+    Sorter sorter(comparator);
+    for (int64_t key = 0; key < static_cast<int64_t>(10 * fill_factor) + 1; key++) {
+      AddKey(&sorter, key);
+    }
+    ASSERT_TRUE(tree.BulkLoad(&sorter, fill_factor));
+    TreeShape(&tree, bpm, &num_leaves, &height);
+    ASSERT_EQ(expected_leaves, num_leaves);
+    CheckHalfFull(bpm, tree.GetRootPageId());
+  }
+  for (int num_keys : {51, 101, 1001}) {
+    Tree tree("foo_pk", bpm, comparator, 10, 10);
+    Sorter sorter(comparator);
+    for (int64_t key = 0; key < num_keys; key++) {
+      AddKey(&sorter, key);
+    }
+    ASSERT_TRUE(tree.BulkLoad(&sorter, 0.5));
+    CheckHalfFull(bpm, tree.GetRootPageId());
+  }
+
+  // Scenario: an empty sorter leaves the tree empty; a single key makes a root leaf.
+  Tree tree("foo_pk", bpm, comparator, 10, 10);
+  Sorter empty(comparator);
+  ASSERT_TRUE(tree.BulkLoad(&empty));
+  ASSERT_TRUE(tree.IsEmpty());
+  Sorter one(comparator);
+  AddKey(&one, 42);
+  ASSERT_TRUE(tree.BulkLoad(&one));
+  TreeShape(&tree, bpm, &num_leaves, &height);
+  ASSERT_EQ(1, num_leaves);
+  ASSERT_EQ(1, height);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeBulkLoadTest, OutOfFramesTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  remove("test.db");
+  remove("test.fsm");
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(3, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  // Scenario: a tree of three levels pins a node per level while it is built, one more than the pool has left. The
+  // load fails, gives back every page it built and leaves the tree empty and usable.
+  Tree tree("foo_pk", bpm, comparator, 10, 10);
+  Sorter sorter(comparator);
+  for (int64_t key = 0; key < 1000; key++) {
+    AddKey(&sorter, key);
+  }
+  ASSERT_FALSE(tree.BulkLoad(&sorter, 1.0));
+  ASSERT_TRUE(tree.IsEmpty());
+  EXPECT_EQ(2, disk_manager->GetNumFreePages());
+  Sorter one(comparator);
+  AddKey(&one, 42);
+  ASSERT_TRUE(tree.BulkLoad(&one));
+  std::vector<RID> rids;
+  GenericKey<8> index_key;
+  index_key.SetFromInteger(42);
+  ASSERT_TRUE(tree.GetValue(index_key, &rids));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeBulkLoadTest, DISABLED_BuildBenchmark) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  const int64_t num_keys = 1000000;
+  auto keys = ShuffledEvenKeys(num_keys);
+  int num_leaves;
+  int height;
+  std::cout << "<<< BEGIN" << std::endl;
+  std::cout << "build\tms\tleaves\theight" << std::endl;
+  for (bool bulk : {false, true}) {
+    auto *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(256, disk_manager);
+    page_id_t page_id;
+    bpm->NewPage(&page_id);
+    Tree tree("foo_pk", bpm, comparator);
+    auto start = std::chrono::steady_clock::now();
+    if (bulk) {
+      Sorter sorter(comparator);
+      for (auto key : keys) {
+        AddKey(&sorter, key);
+      }
+      tree.BulkLoad(&sorter);
+    } else {
+      GenericKey<8> index_key;
+      for (auto key : keys) {
+        index_key.SetFromInteger(key);
+        tree.Insert(index_key, RID(static_cast<int32_t>(key >> 32), static_cast<uint32_t>(key)));
+      }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    TreeShape(&tree, bpm, &num_leaves, &height);
+    std::cout << (bulk ? "bulk load" : "insert") << "\t"
+              << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << "\t" << num_leaves << "\t"
+              << height << std::endl;
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete disk_manager;
+    delete bpm;
+    remove("test.db");
+    remove("test.log");
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
@@ -333,4 +334,88 @@ TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
   remove("test.log");
 }
 
+void SmallNodesMix(BPlusTreeMode mode) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(256, disk_manager);
+  // Tiny nodes, so that most inserts and removes split or merge pages all the way up.
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4, mode);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  const int num_threads = 4;
+  const int64_t scale_factor = 2000;
+  std::vector<int64_t> keys;
+  std::vector<int64_t> odd_keys;
+  std::vector<int64_t> new_keys;
+  for (int64_t key = 1; key <= scale_factor; key++) {
+    keys.push_back(key);
+    if (key % 2 == 1) {
+      odd_keys.push_back(key);
+    }
+    new_keys.push_back(scale_factor + key);
+  }
+  LaunchParallelTest(num_threads, InsertHelperSplit, &tree, keys, num_threads);
+
+  // Scenario: removers take out the odd keys and inserters add new ones, while readers keep finding the even keys.
+  std::atomic<bool> done{false};
+  std::atomic<int> missing{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back(DeleteHelperSplit, &tree, odd_keys, num_threads, t);
+    threads.emplace_back(InsertHelperSplit, &tree, new_keys, num_threads, t);
+  }
+  std::thread reader([&] {
+    std::vector<RID> rids;
+    GenericKey<8> index_key;
+    while (!done) {
+      for (int64_t key = 2; key <= scale_factor; key += 2) {
+        rids.clear();
+        index_key.SetFromInteger(key);
+        if (!tree.GetValue(index_key, &rids)) {
+          missing++;
+        }
+      }
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  done = true;
+  reader.join();
+  EXPECT_EQ(0, missing);
+
+  std::vector<RID> rids;
+  GenericKey<8> index_key;
+  for (int64_t key = 1; key <= 2 * scale_factor; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    bool expected = key > scale_factor || key % 2 == 0;
+    EXPECT_EQ(expected, tree.GetValue(index_key, &rids)) << key;
+  }
+  int64_t current_key = 2;
+  int64_t size = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+    current_key += current_key < scale_factor ? 2 : 1;
+    size++;
+  }
+  EXPECT_EQ(scale_factor / 2 + scale_factor, size);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeConcurrentTest, SmallNodesMixTest) { SmallNodesMix(BPlusTreeMode::LATCH_CRABBING); }
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeConcurrentTest, BLinkSmallNodesMixTest) { SmallNodesMix(BPlusTreeMode::B_LINK); }
+
 }  // namespace bustub
@@ -154,4 +154,90 @@ TEST(BPlusTreeTest, DISABLED_BPlusTreeContentionBenchmark2) {  // NOLINT
             << std::endl;
 }
 
+/**
+ * Time a mixed load on a tree built in the given mode: half of the threads insert keys of their own range while the
+ * other half look up keys loaded beforehand.
+ */
+auto BPlusTreeMixedBenchmarkCall(size_t num_threads, int leaf_node_size, BPlusTreeMode mode) -> size_t {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManagerMemory(256 << 10);  // 1GB
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, leaf_node_size, 10, mode);
+  page_id_t page_id;
+  auto *header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  const int preloaded_keys = 10000;
+  const int keys_per_thread = 20000 / num_threads;
+  const int keys_stride = 100000;
+  GenericKey<8> index_key;
+  RID rid;
+  for (int64_t key = 0; key < preloaded_keys; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid);
+  }
+
+  auto clock_start = std::chrono::system_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < num_threads; i++) {
+    threads.emplace_back([&tree, i, keys_per_thread, keys_stride, preloaded_keys]() {
+      GenericKey<8> index_key;
+      RID rid;
+      std::vector<RID> result;
+      for (int64_t n = 0; n < keys_per_thread; n++) {
+        if (i % 2 == 0) {
+          int64_t key = keys_stride * (i + 1) + n;
+          rid.Set(0, key);
+          index_key.SetFromInteger(key);
+          tree.Insert(index_key, rid);
+        } else {
+          result.clear();
+          index_key.SetFromInteger((n * 7919 + i) % preloaded_keys);
+          tree.GetValue(index_key, &result);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto clock_end = std::chrono::system_clock::now();
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  return std::chrono::duration_cast<std::chrono::milliseconds>(clock_end - clock_start).count();
+}
+
+TEST(BPlusTreeTest, DISABLED_BPlusTreeModeBenchmark) {  // NOLINT
+  std::vector<size_t> time_ms_crabbing;
+  std::vector<size_t> time_ms_b_link;
+  for (size_t iter = 0; iter < 20; iter++) {
+    if (iter % 2 == 0) {
+      time_ms_crabbing.push_back(BPlusTreeMixedBenchmarkCall(32, 10, BPlusTreeMode::LATCH_CRABBING));
+    } else {
+      time_ms_b_link.push_back(BPlusTreeMixedBenchmarkCall(32, 10, BPlusTreeMode::B_LINK));
+    }
+  }
+  std::cout << "<<< BEGIN" << std::endl;
+  double total_crabbing = 0;
+  double total_b_link = 0;
+  std::cout << "Latch Crabbing Time: ";
+  for (auto x : time_ms_crabbing) {
+    std::cout << x << " ";
+    total_crabbing += x;
+  }
+  std::cout << std::endl;
+  std::cout << "B-Link Time: ";
+  for (auto x : time_ms_b_link) {
+    std::cout << x << " ";
+    total_b_link += x;
+  }
+  std::cout << std::endl;
+  std::cout << "Ratio: " << total_b_link / total_crabbing << std::endl;
+  std::cout << ">>> END" << std::endl;
+}
+
 }  // namespace bustub
@@ -163,4 +163,107 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, PinnedMergeTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  remove("test.db");
+  remove("test.fsm");
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+  GenericKey<8> index_key;
+  for (int64_t key = 1; key <= 20; key++) {
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.Insert(index_key, RID(0, static_cast<uint32_t>(key))));
+  }
+
+  // Scenario: readers that got to the pages before they were merged away still pin them. Their deletion is put off
+  // rather than lost, and goes through once the readers are gone.
+  bpm->FlushAllPages();
+  const page_id_t num_pages = disk_manager->GetNumPages();
+  for (page_id_t pinned = 1; pinned < num_pages; pinned++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(pinned));
+  }
+  for (int64_t key = 1; key < 20; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key);
+  }
+  EXPECT_EQ(0, disk_manager->GetNumFreePages());
+  for (page_id_t pinned = 1; pinned < num_pages; pinned++) {
+    ASSERT_TRUE(bpm->UnpinPage(pinned, false));
+  }
+  index_key.SetFromInteger(20);
+  tree.Remove(index_key);
+  // The tree is empty now, and every page it had is free but the header page.
+  EXPECT_EQ(num_pages - 1, disk_manager->GetNumFreePages());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, OutOfFramesTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  remove("test.db");
+  remove("test.fsm");
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(20, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= 20; key++) {
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.Insert(index_key, RID(0, static_cast<uint32_t>(key))));
+  }
+
+  // Scenario: every frame is pinned by someone else and the tree is not resident. Lookups, inserts and removes fail
+  // instead of touching a page they could not fetch, and the tree is intact once frames are available again.
+  std::vector<page_id_t> pinned;
+  while (bpm->NewPage(&page_id) != nullptr) {
+    pinned.push_back(page_id);
+  }
+  index_key.SetFromInteger(5);
+  EXPECT_FALSE(tree.GetValue(index_key, &rids));
+  index_key.SetFromInteger(21);
+  EXPECT_FALSE(tree.Insert(index_key, RID(0, 21)));
+  index_key.SetFromInteger(5);
+  tree.Remove(index_key);
+  for (auto pinned_page_id : pinned) {
+    ASSERT_TRUE(bpm->UnpinPage(pinned_page_id, false));
+  }
+  for (int64_t key = 1; key <= 20; key++) {
+    index_key.SetFromInteger(key);
+    rids.clear();
+    EXPECT_TRUE(tree.GetValue(index_key, &rids));
+  }
+
+  // Scenario: merges that move children around keep the tree consistent while they re-parent them.
+  for (int64_t key = 1; key <= 20; key += 2) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key);
+  }
+  int64_t expected = 2;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(expected, (*iterator).second.GetSlotNum());
+    expected += 2;
+  }
+  EXPECT_EQ(22, expected);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+}
 }  // namespace bustub
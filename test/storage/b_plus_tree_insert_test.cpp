@@ -12,11 +12,15 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
 #include "storage/index/b_plus_tree.h"
 #include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
 
 namespace bustub {
 
@@ -195,4 +199,219 @@ TEST(BPlusTreeTests, DISABLED_InsertTest3) {
   remove("test.db");
   remove("test.log");
 }
+
+/** A key of the schema (a bigint, b integer), which only takes the first 12 bytes of a GenericKey. */
+template <size_t KeySize>
+auto CompositeKey(Schema *key_schema, int64_t a) -> GenericKey<KeySize> {
+  GenericKey<KeySize> index_key;
+  index_key.SetFromKey(
+      Tuple({ValueFactory::GetBigIntValue(a), ValueFactory::GetIntegerValue(static_cast<int32_t>(a % 7))}, key_schema));
+  return index_key;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, TruncatedKeyTest) {
+  using InternalPage = BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>>;
+  using LeafPage = BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>;
+  auto key_schema = ParseCreateStatement("a bigint,b integer");
+  GenericComparator<64> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<64>, RID, GenericComparator<64>> tree("foo_pk", bpm, comparator);
+  std::vector<int64_t> keys(5000);
+  for (size_t i = 0; i < keys.size(); i++) {
+    keys[i] = static_cast<int64_t>(i) - 2500;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (auto key : keys) {
+    ASSERT_TRUE(tree.Insert(CompositeKey<64>(key_schema.get(), key), RID(0, static_cast<uint32_t>(key + 2500))));
+  }
+
+  // Scenario: pages store the 12 bytes of each key the schema uses instead of 64, and take in as many more entries.
+  page_id_t leaf_page_id = tree.GetRootPageId();
+  while (true) {
+    Page *page = bpm->FetchPage(leaf_page_id);
+    auto tree_page = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    ASSERT_EQ(12, tree_page->GetKeySize());
+    bool leaf = tree_page->IsLeafPage();
+    if (leaf) {
+      ASSERT_EQ(LeafPage::Capacity(12), tree_page->GetMaxSize());
+    } else {
+      ASSERT_EQ(InternalPage::Capacity(12), tree_page->GetMaxSize());
+      leaf_page_id = reinterpret_cast<InternalPage *>(tree_page)->ValueAt(0);
+    }
+    bpm->UnpinPage(page->GetPageId(), false);
+    if (leaf) {
+      break;
+    }
+  }
+  ASSERT_GT(LeafPage::Capacity(12), 3 * LeafPage::Capacity(sizeof(GenericKey<64>)));
+
+  // Scenario: keys come back whole, in order, from lookups and from the iterator.
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    ASSERT_TRUE(tree.GetValue(CompositeKey<64>(key_schema.get(), key), &rids));
+    ASSERT_EQ(key + 2500, rids[0].GetSlotNum());
+  }
+  int64_t expected = -2500;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    ASSERT_EQ(expected, (*iterator).first.ToValue(key_schema.get(), 0).GetAs<int64_t>());
+    ASSERT_EQ(expected % 7, (*iterator).first.ToValue(key_schema.get(), 1).GetAs<int32_t>());
+    expected++;
+  }
+  ASSERT_EQ(2500, expected);
+
+  // Scenario: removes find their keys as well.
+  for (auto key : keys) {
+    if (key % 2 == 0) {
+      tree.Remove(CompositeKey<64>(key_schema.get(), key));
+    }
+  }
+  for (auto key : keys) {
+    rids.clear();
+    ASSERT_EQ(key % 2 != 0, tree.GetValue(CompositeKey<64>(key_schema.get(), key), &rids));
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+void OutOfFrames(BPlusTreeMode mode) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  remove("test.db");
+  remove("test.fsm");
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(10, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4, mode);
+  GenericKey<8> index_key;
+  for (int64_t key = 1; key <= 3; key++) {
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.Insert(index_key, RID(0, static_cast<uint32_t>(key))));
+  }
+
+  // Scenario: the root leaf is full, and splitting it takes a new leaf and a new root. With no frame to spare, or only
+  // one, the insert fails before touching the tree.
+  std::vector<page_id_t> pinned(8);
+  for (auto &pinned_page_id : pinned) {
+    ASSERT_NE(nullptr, bpm->NewPage(&pinned_page_id));
+  }
+  const page_id_t root_page_id = tree.GetRootPageId();
+  index_key.SetFromInteger(4);
+  EXPECT_FALSE(tree.Insert(index_key, RID(0, 4)));
+  ASSERT_TRUE(bpm->UnpinPage(pinned.back(), false));
+  pinned.pop_back();
+  EXPECT_FALSE(tree.Insert(index_key, RID(0, 4)));
+  EXPECT_EQ(root_page_id, tree.GetRootPageId());
+  std::vector<RID> rids;
+  EXPECT_FALSE(tree.GetValue(index_key, &rids));
+
+  ASSERT_TRUE(bpm->UnpinPage(pinned.back(), false));
+  pinned.pop_back();
+  EXPECT_TRUE(tree.Insert(index_key, RID(0, 4)));
+  EXPECT_NE(root_page_id, tree.GetRootPageId());
+  for (auto pinned_page_id : pinned) {
+    ASSERT_TRUE(bpm->UnpinPage(pinned_page_id, false));
+  }
+  int64_t expected = 1;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(expected, (*iterator).second.GetSlotNum());
+    expected++;
+  }
+  EXPECT_EQ(5, expected);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, OutOfFramesTest) { OutOfFrames(BPlusTreeMode::LATCH_CRABBING); }
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, BLinkOutOfFramesTest) { OutOfFrames(BPlusTreeMode::B_LINK); }
+/** Build a tree of (a bigint, b integer) keys in GenericKey<KeySize> and print its page sizes and shape. */
+template <size_t KeySize>
+void KeySizeShape(int64_t num_keys) {
+  using InternalPage = BPlusTreeInternalPage<GenericKey<KeySize>, page_id_t, GenericComparator<KeySize>>;
+  using LeafPage = BPlusTreeLeafPage<GenericKey<KeySize>, RID, GenericComparator<KeySize>>;
+  auto key_schema = ParseCreateStatement("a bigint,b integer");
+  GenericComparator<KeySize> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(256, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<KeySize>, RID, GenericComparator<KeySize>> tree("foo_pk", bpm, comparator);
+  std::vector<int64_t> keys(num_keys);
+  for (int64_t i = 0; i < num_keys; i++) {
+    keys[i] = i;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (auto key : keys) {
+    tree.Insert(CompositeKey<KeySize>(key_schema.get(), key), RID(0, static_cast<uint32_t>(key)));
+  }
+
+  // Follow the leftmost path down, then the leaf chain.
+  int height = 1;
+  int internal_max_size = 0;
+  page_id = tree.GetRootPageId();
+  while (true) {
+    Page *page = bpm->FetchPage(page_id);
+    auto tree_page = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    bool leaf = tree_page->IsLeafPage();
+    page_id_t child_page_id = INVALID_PAGE_ID;
+    if (!leaf) {
+      internal_max_size = tree_page->GetMaxSize();
+      child_page_id = reinterpret_cast<InternalPage *>(tree_page)->ValueAt(0);
+    }
+    bpm->UnpinPage(page_id, false);
+    if (leaf) {
+      break;
+    }
+    page_id = child_page_id;
+    height++;
+  }
+  int leaf_max_size = 0;
+  int num_leaves = 0;
+  while (page_id != INVALID_PAGE_ID) {
+    Page *page = bpm->FetchPage(page_id);
+    auto leaf_page = reinterpret_cast<LeafPage *>(page->GetData());
+    leaf_max_size = leaf_page->GetMaxSize();
+    page_id_t next_page_id = leaf_page->GetNextPageId();
+    bpm->UnpinPage(page_id, false);
+    page_id = next_page_id;
+    num_leaves++;
+  }
+  std::cout << KeySize << "\t" << leaf_max_size << "\t" << internal_max_size << "\t" << num_leaves << "\t"
+            << static_cast<double>(num_keys) / num_leaves << "\t" << height << std::endl;
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeTests, DISABLED_KeySizeBenchmark) {
+  const int64_t num_keys = 1000000;
+  std::cout << "<<< BEGIN" << std::endl;
+  std::cout << "key size\tleaf max\tinternal max\tleaves\tkeys/leaf\theight" << std::endl;
+  KeySizeShape<16>(num_keys);
+  KeySizeShape<32>(num_keys);
+  KeySizeShape<64>(num_keys);
+  std::cout << ">>> END" << std::endl;
+}
+
 }  // namespace bustub
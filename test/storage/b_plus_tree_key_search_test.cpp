@@ -0,0 +1,231 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_key_search_test.cpp
+//
+// Identification: test/storage/b_plus_tree_key_search_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/page/b_plus_tree_key_search.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+using IntegerSearch = KeySearch<GenericKey<4>, GenericComparator<4>>;
+using IntegerTree = BPlusTree<GenericKey<4>, RID, GenericComparator<4>>;
+
+auto IntegerKey(Schema *key_schema, int32_t key) -> GenericKey<4> {
+  GenericKey<4> index_key;
+  index_key.SetFromKey(Tuple({ValueFactory::GetIntegerValue(key)}, key_schema));
+  return index_key;
+}
+
+/** Sorted, distinct keys spread over the whole int32_t range, stored back to back as a page stores them. */
+auto SortedKeys(int num_keys, std::mt19937 *random) -> std::vector<int32_t> {
+  std::uniform_int_distribution<int32_t> distribution(std::numeric_limits<int32_t>::min() + 1,
+                                                      std::numeric_limits<int32_t>::max());
+  std::vector<int32_t> keys{std::numeric_limits<int32_t>::min() + 1, -1, 0, 1, std::numeric_limits<int32_t>::max()};
+  while (static_cast<int>(keys.size()) < num_keys) {
+    keys.push_back(distribution(*random));
+  }
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  return keys;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeKeySearchTest, IntegerBoundTest) {
+  auto key_schema = ParseCreateStatement("a integer");
+  GenericComparator<4> comparator(key_schema.get());
+  ASSERT_TRUE(comparator.IsIntegerKey());
+  std::mt19937 random(15445);
+
+  // Scenario: integer compares and counts find the same bounds as the comparator, for ranges around the block the
+  // binary search stops at and for targets on, between and beyond the keys.
+  for (int num_keys : {1, 3, 4, 5, IntegerSearch::SEARCH_BLOCK, IntegerSearch::SEARCH_BLOCK + 1, 100, 338, 507}) {
+    auto keys = SortedKeys(num_keys, &random);
+    auto data = reinterpret_cast<const char *>(keys.data());
+    int size = static_cast<int>(keys.size());
+    std::vector<int32_t> targets{std::numeric_limits<int32_t>::min() + 1, std::numeric_limits<int32_t>::max()};
+    // The smallest int32_t is NULL, which the comparator finds equal to every key.
+    for (auto key : keys) {
+      targets.push_back(key);
+      if (key - 1 > std::numeric_limits<int32_t>::min()) {
+        targets.push_back(key - 1);
+      }
+      if (key < std::numeric_limits<int32_t>::max()) {
+        targets.push_back(key + 1);
+      }
+    }
+    for (auto target : targets) {
+      auto index_key = IntegerKey(key_schema.get(), target);
+      for (bool upper : {false, true}) {
+        for (int begin : {0, 1, size / 2}) {
+          ASSERT_EQ(BinarySearchKeys(data, sizeof(int32_t), begin, size, index_key, comparator, upper),
+                    IntegerSearch::Bound(data, sizeof(int32_t), begin, size, index_key, comparator, upper));
+        }
+      }
+    }
+  }
+
+  // Scenario: other schemas of the same key size go through the comparator.
+  auto smallint_schema = ParseCreateStatement("a smallint,b smallint");
+  ASSERT_FALSE(GenericComparator<4>(smallint_schema.get()).IsIntegerKey());
+}
+
+void IntegerTreeInsertRemove(const char *create_statement, int leaf_max_size, int internal_max_size) {
+  auto key_schema = ParseCreateStatement(create_statement);
+  GenericComparator<4> comparator(key_schema.get());
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  IntegerTree tree("foo_pk", bpm, comparator, leaf_max_size, internal_max_size);
+  std::vector<int32_t> keys(5000);
+  for (size_t i = 0; i < keys.size(); i++) {
+    keys[i] = static_cast<int32_t>(i) - 2500;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  // Keys of two smallint columns, which are not searched as integers, keep the order of the integers.
+  auto make_key = [&](int32_t key) {
+    if (comparator.IsIntegerKey()) {
+      return IntegerKey(key_schema.get(), key);
+    }
+    GenericKey<4> index_key;
+    index_key.SetFromKey(Tuple({ValueFactory::GetSmallIntValue(static_cast<int16_t>(key >> 16)),
+                                ValueFactory::GetSmallIntValue(static_cast<int16_t>(key & 0x7fff))},
+                               key_schema.get()));
+    return index_key;
+  };
+
+  for (auto key : keys) {
+    ASSERT_TRUE(tree.Insert(make_key(key), RID(0, static_cast<uint32_t>(key + 2500))));
+  }
+  ASSERT_FALSE(tree.Insert(make_key(keys[0]), RID()));
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    ASSERT_TRUE(tree.GetValue(make_key(key), &rids));
+    ASSERT_EQ(key + 2500, rids[0].GetSlotNum());
+  }
+  rids.clear();
+  ASSERT_FALSE(tree.GetValue(make_key(2500), &rids));
+
+  for (auto key : keys) {
+    if (key % 2 == 0) {
+      tree.Remove(make_key(key));
+    }
+  }
+  for (auto key : keys) {
+    rids.clear();
+    ASSERT_EQ(key % 2 != 0, tree.GetValue(make_key(key), &rids));
+  }
+  int count = 0;
+  for (auto iterator = tree.Begin(make_key(-1001)); iterator != tree.End(); ++iterator) {
+    count++;
+  }
+  ASSERT_EQ(1751, count);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeKeySearchTest, IntegerTreeTest) {
+  // Scenario: small pages split and merge through every level.
+  IntegerTreeInsertRemove("a integer", 3, 4);
+  // Scenario: full pages take the SIMD counts over whole blocks.
+  IntegerTreeInsertRemove("a integer", 0, 0);
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeKeySearchTest, OtherSchemaTreeTest) {
+  // Scenario: a key of the same size that is not a single integer keeps its own order.
+  IntegerTreeInsertRemove("a smallint,b smallint", 3, 4);
+  IntegerTreeInsertRemove("a smallint,b smallint", 0, 0);
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeKeySearchTest, DISABLED_LookupBenchmark) {
+  auto key_schema = ParseCreateStatement("a integer");
+  GenericComparator<4> comparator(key_schema.get());
+  const int num_keys = 200000;
+  const int num_lookups = 1000000;
+  std::mt19937 random(15445);
+  std::vector<int32_t> keys(num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    keys[i] = 2 * i;
+  }
+  std::shuffle(keys.begin(), keys.end(), random);
+  std::vector<GenericKey<4>> lookups;
+  std::uniform_int_distribution<int32_t> distribution(0, 2 * num_keys);
+  for (int i = 0; i < num_lookups; i++) {
+    lookups.push_back(IntegerKey(key_schema.get(), distribution(random)));
+  }
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(1024, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  IntegerTree tree("foo_pk", bpm, comparator);
+  for (auto key : keys) {
+    tree.Insert(IntegerKey(key_schema.get(), key), RID(0, static_cast<uint32_t>(key)));
+  }
+
+  std::cout << "<<< BEGIN" << std::endl;
+  // The search within a single full leaf, through the comparator and with integer compares and counts.
+  auto node_keys = SortedKeys(338, &random);
+  auto data = reinterpret_cast<const char *>(node_keys.data());
+  int size = static_cast<int>(node_keys.size());
+  for (bool integer : {false, true}) {
+    int64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &key : lookups) {
+      sum += integer ? IntegerSearch::Bound(data, sizeof(int32_t), 0, size, key, comparator, false)
+                     : BinarySearchKeys(data, sizeof(int32_t), 0, size, key, comparator, false);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << (integer ? "integer" : "comparator") << " node search ns/lookup\t"
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / num_lookups << "\t(" << sum
+              << ")" << std::endl;
+  }
+  std::vector<RID> rids;
+  int found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &key : lookups) {
+    rids.clear();
+    found += static_cast<int>(tree.GetValue(key, &rids));
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << "GetValue ns/lookup\t"
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / num_lookups << "\t(" << found
+            << " found)" << std::endl;
+  std::cout << ">>> END" << std::endl;
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
@@ -10,11 +10,16 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <cstdlib>
 #include <cstring>
+#include <future>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_uring.h"
 
 namespace bustub {
 
@@ -55,6 +60,179 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ReadPastEndTest) {
+  char buf[BUSTUB_PAGE_SIZE];
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  std::strncpy(data, "A test string.", sizeof(data));
+  dm.WritePage(0, data);
+
+  // Pages past the end of the file read back as zeroes.
+  std::memset(buf, 0xff, sizeof(buf));
+  EXPECT_TRUE(dm.ReadPage(3, buf));
+  for (char c : buf) {
+    EXPECT_EQ(0, c);
+  }
+
+  // Syncing makes the writes durable: a new disk manager on the same file sees them.
+  dm.Sync();
+  EXPECT_EQ(1, dm.GetNumSyncs());
+  dm.ShutDown();
+  auto dm2 = DiskManager(db_file);
+  EXPECT_TRUE(dm2.ReadPage(0, buf));
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  dm2.ShutDown();
+
+  // Once the file is closed, I/O fails, and the requests scheduled report it.
+  EXPECT_FALSE(dm2.WritePage(0, data));
+  EXPECT_FALSE(dm2.ReadPage(0, buf));
+  EXPECT_FALSE(dm2.WritePageAsync(0, data).get());
+  EXPECT_FALSE(dm2.ReadPageAsync(0, buf).get());
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWriteTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 32;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Every thread writes its own pages and reads them back while the others do the same.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&dm, tid]() {
+      char buf[BUSTUB_PAGE_SIZE];
+      char data[BUSTUB_PAGE_SIZE];
+      for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < pages_per_thread; i++) {
+          page_id_t page_id = i * num_threads + tid;
+          std::memset(data, page_id + round, sizeof(data));
+          dm.WritePage(page_id, data);
+          dm.ReadPage(page_id, buf);
+          EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * pages_per_thread * 4, dm.GetNumWrites());
+
+  char buf[BUSTUB_PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < num_threads * pages_per_thread; page_id++) {
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ(static_cast<char>(page_id + 3), buf[0]);
+    EXPECT_EQ(static_cast<char>(page_id + 3), buf[BUSTUB_PAGE_SIZE - 1]);
+  }
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ScheduleBatchTest) {
+  // More requests than the queue depth, so that submissions have to wait for completions.
+  const int num_pages = 200;
+  std::string db_file("test.db");
+  auto dm = DiskManagerUring(db_file, 16);
+  EXPECT_TRUE(dm.IsAsync());
+
+  std::vector<char> data(num_pages * BUSTUB_PAGE_SIZE);
+  std::vector<DiskRequest> requests;
+  std::vector<std::future<bool>> futures;
+  for (int i = 0; i < num_pages; i++) {
+    std::memset(data.data() + i * BUSTUB_PAGE_SIZE, 'a' + i % 26, BUSTUB_PAGE_SIZE);
+    requests.push_back(DiskRequest{true, data.data() + i * BUSTUB_PAGE_SIZE, i, {}});
+    futures.push_back(requests.back().callback_.get_future());
+  }
+  dm.Schedule(&requests);
+  EXPECT_TRUE(requests.empty());
+  for (auto &future : futures) {
+    EXPECT_TRUE(future.get());
+  }
+  EXPECT_EQ(num_pages, dm.GetNumWrites());
+
+  // Read everything back in a single batch, plus a page past the end of the file which reads as zeroes.
+  std::vector<char> buf((num_pages + 1) * BUSTUB_PAGE_SIZE, 1);
+  futures.clear();
+  for (int i = 0; i <= num_pages; i++) {
+    requests.push_back(DiskRequest{false, buf.data() + i * BUSTUB_PAGE_SIZE, i, {}});
+    futures.push_back(requests.back().callback_.get_future());
+  }
+  dm.Schedule(&requests);
+  for (auto &future : futures) {
+    EXPECT_TRUE(future.get());
+  }
+  EXPECT_EQ(0, std::memcmp(buf.data(), data.data(), data.size()));
+  for (int i = 0; i < BUSTUB_PAGE_SIZE; i++) {
+    EXPECT_EQ(0, buf[num_pages * BUSTUB_PAGE_SIZE + i]);
+  }
+
+  // The single-page helpers go through Schedule(), too.
+  char page[BUSTUB_PAGE_SIZE];
+  EXPECT_TRUE(dm.WritePageAsync(num_pages, data.data()).get());
+  EXPECT_TRUE(dm.ReadPageAsync(num_pages, page).get());
+  EXPECT_EQ(0, std::memcmp(page, data.data(), BUSTUB_PAGE_SIZE));
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIOTest) {
+  DiskManagerUring dm("test.db", DISK_QUEUE_DEPTH, true);
+  if (!dm.IsDirectIO()) {
+    GTEST_SKIP() << "the file system does not support direct I/O";
+  }
+
+  // Buffers aligned for direct I/O, and the same buffers one byte off.
+  const int num_pages = 4;
+  auto *aligned = static_cast<char *>(std::aligned_alloc(DiskManager::DIRECT_IO_ALIGNMENT,
+                                                         (num_pages + 1) * BUSTUB_PAGE_SIZE));
+  char *unaligned = aligned + 1;
+  std::vector<char> expected(num_pages * BUSTUB_PAGE_SIZE);
+  for (int i = 0; i < num_pages; i++) {
+    std::memset(expected.data() + i * BUSTUB_PAGE_SIZE, 'a' + i, BUSTUB_PAGE_SIZE);
+  }
+
+  // Scenario: aligned and unaligned buffers can both be written and read, synchronously and in batches.
+  std::memcpy(aligned, expected.data(), BUSTUB_PAGE_SIZE);
+  dm.WritePage(0, aligned);
+  std::memcpy(unaligned, expected.data() + BUSTUB_PAGE_SIZE, BUSTUB_PAGE_SIZE);
+  dm.WritePage(1, unaligned);
+  std::memcpy(aligned, expected.data() + 2 * BUSTUB_PAGE_SIZE, BUSTUB_PAGE_SIZE);
+  std::vector<char> page3(expected.begin() + 3 * BUSTUB_PAGE_SIZE, expected.end());
+  EXPECT_TRUE(dm.WritePageAsync(2, aligned).get());
+  EXPECT_TRUE(dm.WritePageAsync(3, page3.data()).get());
+
+  dm.ReadPage(0, unaligned);
+  EXPECT_EQ(0, std::memcmp(unaligned, expected.data(), BUSTUB_PAGE_SIZE));
+  dm.ReadPage(1, aligned);
+  EXPECT_EQ(0, std::memcmp(aligned, expected.data() + BUSTUB_PAGE_SIZE, BUSTUB_PAGE_SIZE));
+  EXPECT_TRUE(dm.ReadPageAsync(2, unaligned).get());
+  EXPECT_EQ(0, std::memcmp(unaligned, expected.data() + 2 * BUSTUB_PAGE_SIZE, BUSTUB_PAGE_SIZE));
+  EXPECT_TRUE(dm.ReadPageAsync(3, aligned).get());
+  EXPECT_EQ(0, std::memcmp(aligned, expected.data() + 3 * BUSTUB_PAGE_SIZE, BUSTUB_PAGE_SIZE));
+
+  // Scenario: a vectored write with one unaligned page falls back to page-by-page writes.
+  std::vector<const char *> pages;
+  for (int i = 0; i < num_pages; i++) {
+    pages.push_back(expected.data() + (num_pages - 1 - i) * BUSTUB_PAGE_SIZE);
+  }
+  std::memcpy(aligned, pages[0], BUSTUB_PAGE_SIZE);
+  pages[0] = aligned;
+  dm.WritePages(0, pages);
+  std::vector<char> buf(BUSTUB_PAGE_SIZE);
+  for (int i = 0; i < num_pages; i++) {
+    dm.ReadPage(i, buf.data());
+    EXPECT_EQ(0, std::memcmp(buf.data(), pages[i], BUSTUB_PAGE_SIZE));
+  }
+  EXPECT_EQ(num_pages, dm.GetNumPages());
+
+  dm.ShutDown();
+  std::free(aligned);  // NOLINT
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
@@ -0,0 +1,83 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_test.cpp
+//
+// Identification: test/storage/free_space_map_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/free_space_map.h"
+
+#include <cstdio>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FreeSpaceMapTest, AllocateTest) {
+  FreeSpaceMap map;
+  EXPECT_EQ(INVALID_PAGE_ID, map.Allocate(0, 1));
+
+  for (page_id_t page_id : {3, 70, 5, 130, 8}) {
+    map.Free(page_id);
+  }
+  map.Free(5);
+  EXPECT_EQ(5, map.GetNumFree());
+  EXPECT_TRUE(map.IsFree(70));
+  EXPECT_FALSE(map.IsFree(4));
+
+  // Scenario: the lowest free page of the residue class is handed out first.
+  EXPECT_EQ(3, map.Allocate(1, 2));
+  EXPECT_EQ(5, map.Allocate(1, 2));
+  EXPECT_EQ(INVALID_PAGE_ID, map.Allocate(1, 2));
+  EXPECT_EQ(8, map.Allocate(0, 2));
+  EXPECT_EQ(70, map.Allocate(0, 1));
+  EXPECT_FALSE(map.IsFree(70));
+  EXPECT_EQ(1, map.GetNumFree());
+
+  // Scenario: a page freed again below the pages already handed out is found again.
+  map.Free(3);
+  EXPECT_EQ(3, map.Allocate(0, 1));
+  EXPECT_EQ(130, map.Allocate(0, 1));
+  EXPECT_EQ(0, map.GetNumFree());
+}
+
+// NOLINTNEXTLINE
+TEST(FreeSpaceMapTest, PersistTest) {
+  const std::string file_name = "free_space_map_test.fsm";
+  remove(file_name.c_str());
+
+  FreeSpaceMap map;
+  for (page_id_t page_id : {1, 64, 99, 150}) {
+    map.Free(page_id);
+  }
+  ASSERT_TRUE(map.Save(file_name, 200));
+
+  // Scenario: the map survives a restart.
+  FreeSpaceMap loaded;
+  ASSERT_TRUE(loaded.Load(file_name, 200));
+  EXPECT_EQ(4, loaded.GetNumFree());
+  EXPECT_TRUE(loaded.IsFree(99));
+  EXPECT_EQ(1, loaded.Allocate(0, 1));
+
+  // Scenario: a map saved for a longer file is stale, e.g. the file was removed and recreated.
+  FreeSpaceMap stale;
+  EXPECT_FALSE(stale.Load(file_name, 10));
+  EXPECT_EQ(0, stale.GetNumFree());
+
+  // Scenario: pages freed before they were ever written out are past the end of the file, and dropped on load.
+  map.Free(250);
+  ASSERT_TRUE(map.Save(file_name, 200));
+  ASSERT_TRUE(loaded.Load(file_name, 200));
+  EXPECT_EQ(4, loaded.GetNumFree());
+  EXPECT_FALSE(loaded.IsFree(250));
+
+  remove(file_name.c_str());
+}
+
+}  // namespace bustub
@@ -0,0 +1,225 @@
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/clock_replacer.h"
+#include "buffer/concurrent_clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/page_access_trace.h"
+#include "common/exception.h"
+#include "common/util/string_util.h"
+#include "fmt/core.h"
+
+/**
+ * Replays a page access trace recorded with `\trace` in the BusTub shell against several replacement policies and
+ * pool sizes, and prints the hit ratio of each, without running the database.
+ */
+
+namespace {
+
+/** A replacement policy, driven the way the buffer pool drives its replacer. */
+class ReplayPolicy {
+ public:
+  virtual ~ReplayPolicy() = default;
+  /** A page was pinned in the frame, which is not evictable until it is unpinned again. */
+  virtual void Pin(bustub::frame_id_t frame_id) = 0;
+  /** The last pin of the frame went away. */
+  virtual void Unpin(bustub::frame_id_t frame_id) = 0;
+  /** Pick an unpinned frame and forget it. @return false if every frame is pinned */
+  virtual auto Victim(bustub::frame_id_t *frame_id) -> bool = 0;
+};
+
+/** Adapts the replacers the buffer pool instance can be built with. */
+class FrameReplacerPolicy : public ReplayPolicy {
+ public:
+  explicit FrameReplacerPolicy(std::unique_ptr<bustub::FrameReplacer> replacer) : replacer_(std::move(replacer)) {}
+  void Pin(bustub::frame_id_t frame_id) override {
+    replacer_->RecordAccess(frame_id);
+    replacer_->SetEvictable(frame_id, false);
+  }
+  void Unpin(bustub::frame_id_t frame_id) override { replacer_->SetEvictable(frame_id, true); }
+  auto Victim(bustub::frame_id_t *frame_id) -> bool override { return replacer_->Evict(frame_id); }
+
+ private:
+  std::unique_ptr<bustub::FrameReplacer> replacer_;
+};
+
+/** Adapts the implementations of the Replacer interface. */
+template <typename ReplacerType>
+class ReplacerPolicy : public ReplayPolicy {
+ public:
+  explicit ReplacerPolicy(size_t num_frames) : replacer_(num_frames) {}
+  void Pin(bustub::frame_id_t frame_id) override { replacer_.Pin(frame_id); }
+  void Unpin(bustub::frame_id_t frame_id) override { replacer_.Unpin(frame_id); }
+  auto Victim(bustub::frame_id_t *frame_id) -> bool override { return replacer_.Victim(frame_id); }
+
+ private:
+  ReplacerType replacer_;
+};
+
+using PolicyFactory = std::function<std::unique_ptr<ReplayPolicy>(size_t num_frames)>;
+
+/** The policies the tool knows about, by name. A new policy only needs an entry here. */
+auto MakePolicies(size_t k) -> std::map<std::string, PolicyFactory> {
+  return {
+      {"lru-k",
+       [k](size_t num_frames) {
+         return std::make_unique<FrameReplacerPolicy>(std::make_unique<bustub::LRUKReplacer>(num_frames, k));
+       }},
+      {"concurrent-clock",
+       [](size_t num_frames) {
+         return std::make_unique<FrameReplacerPolicy>(std::make_unique<bustub::ConcurrentClockReplacer>(num_frames));
+       }},
+      {"lru", [](size_t num_frames) { return std::make_unique<ReplacerPolicy<bustub::LRUReplacer>>(num_frames); }},
+      {"clock",
+       [](size_t num_frames) { return std::make_unique<ReplacerPolicy<bustub::ClockReplacer>>(num_frames); }},
+  };
+}
+
+struct ReplayResult {
+  size_t pins_{0};
+  size_t hits_{0};
+  /** Dirty pages that were evicted and would have been written back. */
+  size_t write_backs_{0};
+  /** Pins that found every frame pinned; the buffer pool would have returned nullptr. */
+  size_t failures_{0};
+
+  auto HitRatio() const -> double { return pins_ == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(pins_); }
+};
+
+/** Simulate a buffer pool of num_frames frames managed by policy over the trace. */
+auto Replay(const std::vector<bustub::PageAccessRecord> &trace, size_t num_frames, ReplayPolicy *policy)
+    -> ReplayResult {
+  struct Frame {
+    bustub::page_id_t page_id_{bustub::INVALID_PAGE_ID};
+    int pin_count_{0};
+    bool is_dirty_{false};
+  };
+  std::vector<Frame> frames(num_frames);
+  std::unordered_map<bustub::page_id_t, bustub::frame_id_t> page_table;
+  size_t next_free = 0;
+  ReplayResult result;
+
+  for (const auto &record : trace) {
+    auto iter = page_table.find(record.page_id_);
+    if (record.type_ == bustub::PageAccessType::UNPIN) {
+      // Unpins of pages pinned before the trace started, or whose pin failed here, have nothing to match.
+      if (iter == page_table.end() || frames[iter->second].pin_count_ == 0) {
+        continue;
+      }
+      Frame &frame = frames[iter->second];
+      frame.is_dirty_ = frame.is_dirty_ || record.is_dirty_;
+      if (--frame.pin_count_ == 0) {
+        policy->Unpin(iter->second);
+      }
+      continue;
+    }
+
+    result.pins_++;
+    bustub::frame_id_t frame_id;
+    if (iter != page_table.end()) {
+      result.hits_++;
+      frame_id = iter->second;
+    } else {
+      if (next_free < num_frames) {
+        frame_id = static_cast<bustub::frame_id_t>(next_free++);
+      } else if (policy->Victim(&frame_id)) {
+        Frame &victim = frames[frame_id];
+        result.write_backs_ += victim.is_dirty_ ? 1 : 0;
+        page_table.erase(victim.page_id_);
+        victim = Frame{};
+      } else {
+        result.failures_++;
+        continue;
+      }
+      frames[frame_id].page_id_ = record.page_id_;
+      // A pin flagged dirty is a new page, which has to be written out eventually.
+      frames[frame_id].is_dirty_ = record.is_dirty_;
+      page_table[record.page_id_] = frame_id;
+    }
+    frames[frame_id].pin_count_++;
+    policy->Pin(frame_id);
+  }
+  return result;
+}
+
+auto ParseList(const std::string &str) -> std::vector<std::string> {
+  std::vector<std::string> items;
+  for (const auto &item : bustub::StringUtil::Split(str, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-replacer-replay");
+  program.add_argument("trace").help("page access trace recorded with \\trace in the BusTub shell");
+  program.add_argument("--pool-sizes")
+      .default_value(std::string("16,32,64,128,256,512,1024,2048,4096"))
+      .help("comma-separated numbers of frames to simulate");
+  program.add_argument("--policies")
+      .default_value(std::string("lru-k,lru,clock,concurrent-clock"))
+      .help("comma-separated replacement policies to compare: lru-k, lru, clock, concurrent-clock");
+  program.add_argument("--k").default_value(std::string("10")).help("lookback constant of lru-k");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  try {
+    auto policies = MakePolicies(std::stoul(program.get("--k")));
+    std::vector<std::string> policy_names = ParseList(program.get("--policies"));
+    for (const auto &name : policy_names) {
+      if (policies.count(name) == 0) {
+        throw bustub::Exception(fmt::format("unknown policy: {}", name));
+      }
+    }
+    std::vector<size_t> pool_sizes;
+    for (const auto &size : ParseList(program.get("--pool-sizes"))) {
+      pool_sizes.push_back(std::stoul(size));
+    }
+
+    std::vector<bustub::PageAccessRecord> trace;
+    bustub::PageAccessTraceReader reader(program.get("trace"));
+    bustub::PageAccessRecord record;
+    std::unordered_set<bustub::page_id_t> pages;
+    while (reader.Next(&record)) {
+      trace.push_back(record);
+      pages.insert(record.page_id_);
+    }
+    fmt::print("trace: {} events, {} distinct pages\n", trace.size(), pages.size());
+
+    fmt::print("<<< BEGIN\n");
+    fmt::print("policy\tframes\thit_ratio\twrite_backs\tpin_failures\n");
+    for (const auto &name : policy_names) {
+      for (size_t num_frames : pool_sizes) {
+        auto policy = policies[name](num_frames);
+        ReplayResult result = Replay(trace, num_frames, policy.get());
+        fmt::print("{}\t{}\t{:.4f}\t{}\t{}\n", name, num_frames, result.HitRatio(), result.write_backs_,
+                   result.failures_);
+      }
+    }
+    fmt::print(">>> END\n");
+  } catch (const std::exception &err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
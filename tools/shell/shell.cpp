@@ -27,24 +27,26 @@ auto GetWidthOfUtf8(const void *beg, const void *end, size_t *width) -> int {
 auto main(int argc, char **argv) -> int {
   ft_set_u8strwid_func(&GetWidthOfUtf8);
 
-  auto bustub = std::make_unique<bustub::BustubInstance>("test.db");
-
   auto default_prompt = "bustub> ";
   auto emoji_prompt = "\U0001f6c1> ";  // the bathtub emoji
   bool use_emoji_prompt = false;
   bool disable_tty = false;
+  bool direct_io = false;
 
   for (int i = 1; i < argc; i++) {
     if (strcmp(argv[i], "--emoji-prompt") == 0) {
       use_emoji_prompt = true;
-      break;
     }
     if (strcmp(argv[i], "--disable-tty") == 0) {
       disable_tty = true;
-      break;
+    }
+    if (strcmp(argv[i], "--direct-io") == 0) {
+      direct_io = true;
     }
   }
 
+  auto bustub = std::make_unique<bustub::BustubInstance>("test.db", 1, true, direct_io);
+
   bustub->GenerateMockTable();
 
   if (bustub->buffer_pool_manager_ != nullptr) {